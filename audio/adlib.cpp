@@ -77,6 +77,41 @@ struct AdLibInstrument {
 } PACKED_STRUCT;
 #include "common/pack-end.h"
 
+// Register values of an AdLibInstrument, precomputed when the instrument is
+// loaded (see compileInstrument). Only the total level bits of the 0x40
+// registers depend on the note velocity and are patched in on note on.
+struct AdLibRegisterProgram {
+	byte modRegs[4];		// 0x20, 0x60, 0x80 and 0xE0 values
+	byte carRegs[4];
+	byte modLevel;			// 0x40 value with all total level bits set
+	byte carLevel;
+	byte feedback;			// 0xC0 value without panning bits
+	byte modVolume;			// Output level used for the velocity calculation
+	byte carVolume;
+	byte modVelocityScale;	// Velocity sensitivity, stored in the waveform register
+	byte carVelocityScale;
+};
+
+static void compileInstrument(const AdLibInstrument &instr, AdLibRegisterProgram &program) {
+	program.modRegs[0] = instr.modCharacteristic;
+	program.modRegs[1] = 0xff & (~instr.modAttackDecay);
+	program.modRegs[2] = 0xff & (~instr.modSustainRelease);
+	program.modRegs[3] = instr.modWaveformSelect;
+	program.modLevel = instr.modScalingOutputLevel | 0x3F;
+	program.modVolume = instr.modScalingOutputLevel & 0x3F;
+	program.modVelocityScale = instr.modWaveformSelect >> 2;
+
+	program.carRegs[0] = instr.carCharacteristic;
+	program.carRegs[1] = 0xff & (~instr.carAttackDecay);
+	program.carRegs[2] = 0xff & (~instr.carSustainRelease);
+	program.carRegs[3] = instr.carWaveformSelect;
+	program.carLevel = instr.carScalingOutputLevel | 0x3F;
+	program.carVolume = instr.carScalingOutputLevel & 0x3F;
+	program.carVelocityScale = instr.carWaveformSelect >> 2;
+
+	program.feedback = instr.feedback;
+}
+
 class AdLibPart : public MidiChannel {
 	friend class MidiDriver_ADLIB;
 
@@ -94,8 +129,10 @@ protected:
 	byte _priEff;
 	byte _pan;
 	AdLibInstrument _partInstr;
+	AdLibRegisterProgram _partProgram;
 #ifdef ENABLE_OPL3
 	AdLibInstrument _partInstrSecondary;
+	AdLibRegisterProgram _partProgramSecondary;
 #endif
 
 protected:
@@ -125,8 +162,10 @@ public:
 		_channel = 0;
 
 		memset(&_partInstr, 0, sizeof(_partInstr));
+		compileInstrument(_partInstr, _partProgram);
 #ifdef ENABLE_OPL3
 		memset(&_partInstrSecondary, 0, sizeof(_partInstrSecondary));
+		compileInstrument(_partInstrSecondary, _partProgramSecondary);
 #endif
 	}
 
@@ -190,6 +229,7 @@ public:
 private:
 	byte _notes[256];
 	AdLibInstrument *_customInstruments[256];
+	AdLibRegisterProgram *_customPrograms[256];
 };
 
 struct Struct10 {
@@ -975,19 +1015,26 @@ private:
 	AdLibPart _parts[32];
 	AdLibPercussionChannel _percussion;
 
+	// Register programs of the built-in percussion instruments, compiled in open()
+	AdLibRegisterProgram _percussionPrograms[ARRAYSIZE(g_gmPercussionInstruments)];
+#ifdef ENABLE_OPL3
+	AdLibRegisterProgram _percussionProgramsOPL3[ARRAYSIZE(g_gmPercussionInstrumentsOPL3)][2];
+#endif
+
 	bool _isOpen;
 
 	void onTimer();
-	void partKeyOn(AdLibPart *part, const AdLibInstrument *instr, byte note, byte velocity, const AdLibInstrument *second, byte pan);
+	void partKeyOn(AdLibPart *part, const AdLibInstrument *instr, const AdLibRegisterProgram *program, byte note, byte velocity,
+	               const AdLibInstrument *second, const AdLibRegisterProgram *secondProgram, byte pan);
 	void partKeyOff(AdLibPart *part, byte note);
 
 	void adlibKeyOff(int chan);
 	void adlibNoteOn(int chan, byte note, int mod);
 	void adlibNoteOnEx(int chan, byte note, int mod);
 	int adlibGetRegValueParam(int chan, byte data);
-	void adlibSetupChannel(int chan, const AdLibInstrument *instr, byte vol1, byte vol2);
+	void adlibSetupChannel(int chan, const AdLibRegisterProgram *program, byte vol1, byte vol2);
 #ifdef ENABLE_OPL3
-	void adlibSetupChannelSecondary(int chan, const AdLibInstrument *instr, byte vol1, byte vol2, byte pan);
+	void adlibSetupChannelSecondary(int chan, const AdLibRegisterProgram *program, byte vol1, byte vol2, byte pan);
 #endif
 	byte adlibGetRegValue(byte reg) {
 		return _regCache[reg];
@@ -1018,7 +1065,8 @@ private:
 	static byte struct10OnTimer(Struct10 *s10, Struct11 *s11);
 	static void struct10Setup(Struct10 *s10);
 	static int randomNr(int a);
-	void mcKeyOn(AdLibVoice *voice, const AdLibInstrument *instr, byte note, byte velocity, const AdLibInstrument *second, byte pan);
+	void mcKeyOn(AdLibVoice *voice, const AdLibInstrument *instr, const AdLibRegisterProgram *program, byte note, byte velocity,
+	             const AdLibInstrument *second, const AdLibRegisterProgram *secondProgram, byte pan);
 };
 
 // MidiChannel method implementations
@@ -1049,11 +1097,11 @@ void AdLibPart::noteOn(byte note, byte velocity) {
 #ifdef DEBUG_ADLIB
 	debug(6, "%10d: noteOn(%d,%d)", g_tick, note, velocity);
 #endif
-	_owner->partKeyOn(this, &_partInstr, note, velocity,
+	_owner->partKeyOn(this, &_partInstr, &_partProgram, note, velocity,
 #ifdef ENABLE_OPL3
-			&_partInstrSecondary,
+			&_partInstrSecondary, &_partProgramSecondary,
 #else
-			NULL,
+			NULL, NULL,
 #endif
 			_pan);
 }
@@ -1079,8 +1127,10 @@ void AdLibPart::programChange(byte program) {
 	} else {
 		memcpy(&_partInstr,          &g_gmInstrumentsOPL3[program][0], sizeof(AdLibInstrument));
 		memcpy(&_partInstrSecondary, &g_gmInstrumentsOPL3[program][1], sizeof(AdLibInstrument));
+		compileInstrument(_partInstrSecondary, _partProgramSecondary);
 	}
 #endif
+	compileInstrument(_partInstr, _partProgram);
 }
 
 void AdLibPart::pitchBend(int16 bend) {
@@ -1267,6 +1317,7 @@ void AdLibPart::sysEx_customInstrument(uint32 type, const byte *instr) {
 
 	if (type == 'ADL ') {
 		memcpy(&_partInstr, instr, sizeof(AdLibInstrument));
+		compileInstrument(_partInstr, _partProgram);
 	}
 }
 
@@ -1275,6 +1326,7 @@ void AdLibPart::sysEx_customInstrument(uint32 type, const byte *instr) {
 AdLibPercussionChannel::~AdLibPercussionChannel() {
 	for (int i = 0; i < ARRAYSIZE(_customInstruments); ++i) {
 		delete _customInstruments[i];
+		delete _customPrograms[i];
 	}
 }
 
@@ -1286,6 +1338,7 @@ void AdLibPercussionChannel::init(MidiDriver_ADLIB *owner, byte channel) {
 	// Initialize the custom instruments data
 	memset(_notes, 0, sizeof(_notes));
 	memset(_customInstruments, 0, sizeof(_customInstruments));
+	memset(_customPrograms, 0, sizeof(_customPrograms));
 }
 
 void AdLibPercussionChannel::noteOff(byte note) {
@@ -1304,6 +1357,8 @@ void AdLibPercussionChannel::noteOff(byte note) {
 void AdLibPercussionChannel::noteOn(byte note, byte velocity) {
 	const AdLibInstrument *inst = NULL;
 	const AdLibInstrument *sec  = NULL;
+	const AdLibRegisterProgram *prog    = NULL;
+	const AdLibRegisterProgram *secProg = NULL;
 
 	// The custom instruments have priority over the default mapping
 	// We do not support custom instruments in OPL3 mode though.
@@ -1311,6 +1366,7 @@ void AdLibPercussionChannel::noteOn(byte note, byte velocity) {
 	if (!_owner->_opl3Mode) {
 #endif
 		inst = _customInstruments[note];
+		prog = _customPrograms[note];
 		if (inst)
 			note = _notes[note];
 #ifdef ENABLE_OPL3
@@ -1325,10 +1381,13 @@ void AdLibPercussionChannel::noteOn(byte note, byte velocity) {
 			if (!_owner->_opl3Mode) {
 #endif
 				inst = &g_gmPercussionInstruments[key];
+				prog = &_owner->_percussionPrograms[key];
 #ifdef ENABLE_OPL3
 			} else {
-				inst = &g_gmPercussionInstrumentsOPL3[key][0];
-				sec  = &g_gmPercussionInstrumentsOPL3[key][1];
+				inst    = &g_gmPercussionInstrumentsOPL3[key][0];
+				sec     = &g_gmPercussionInstrumentsOPL3[key][1];
+				prog    = &_owner->_percussionProgramsOPL3[key][0];
+				secProg = &_owner->_percussionProgramsOPL3[key][1];
 			}
 #endif
 		}
@@ -1339,7 +1398,7 @@ void AdLibPercussionChannel::noteOn(byte note, byte velocity) {
 		return;
 	}
 
-	_owner->partKeyOn(this, inst, note, velocity, sec, _pan);
+	_owner->partKeyOn(this, inst, prog, note, velocity, sec, secProg, _pan);
 }
 
 void AdLibPercussionChannel::sysEx_customInstrument(uint32 type, const byte *instr) {
@@ -1373,6 +1432,10 @@ void AdLibPercussionChannel::sysEx_customInstrument(uint32 type, const byte *ins
 		_customInstruments[note]->carSustainRelease     = instr[10];
 		_customInstruments[note]->carWaveformSelect     = instr[11];
 		_customInstruments[note]->feedback               = instr[12];
+
+		if (!_customPrograms[note])
+			_customPrograms[note] = new AdLibRegisterProgram;
+		compileInstrument(*_customInstruments[note], *_customPrograms[note]);
 	}
 }
 
@@ -1440,6 +1503,15 @@ int MidiDriver_ADLIB::open() {
 #endif
 	_opl->init();
 
+	for (i = 0; i < ARRAYSIZE(_percussionPrograms); ++i)
+		compileInstrument(g_gmPercussionInstruments[i], _percussionPrograms[i]);
+#ifdef ENABLE_OPL3
+	for (i = 0; i < ARRAYSIZE(_percussionProgramsOPL3); ++i) {
+		compileInstrument(g_gmPercussionInstrumentsOPL3[i][0], _percussionProgramsOPL3[i][0]);
+		compileInstrument(g_gmPercussionInstrumentsOPL3[i][1], _percussionProgramsOPL3[i][1]);
+	}
+#endif
+
 	_regCache = (byte *)calloc(256, 1);
 
 	adlibWrite(8, 0x40);
@@ -1942,7 +2014,8 @@ void MidiDriver_ADLIB::partKeyOff(AdLibPart *part, byte note) {
 	}
 }
 
-void MidiDriver_ADLIB::partKeyOn(AdLibPart *part, const AdLibInstrument *instr, byte note, byte velocity, const AdLibInstrument *second, byte pan) {
+void MidiDriver_ADLIB::partKeyOn(AdLibPart *part, const AdLibInstrument *instr, const AdLibRegisterProgram *program, byte note, byte velocity,
+                                 const AdLibInstrument *second, const AdLibRegisterProgram *secondProgram, byte pan) {
 	AdLibVoice *voice;
 
 	voice = allocateVoice(part->_priEff);
@@ -1950,7 +2023,7 @@ void MidiDriver_ADLIB::partKeyOn(AdLibPart *part, const AdLibInstrument *instr,
 		return;
 
 	linkMc(part, voice);
-	mcKeyOn(voice, instr, note, velocity, second, pan);
+	mcKeyOn(voice, instr, program, note, velocity, second, secondProgram, pan);
 }
 
 AdLibVoice *MidiDriver_ADLIB::allocateVoice(byte pri) {
@@ -1990,14 +2063,15 @@ void MidiDriver_ADLIB::linkMc(AdLibPart *part, AdLibVoice *voice) {
 		voice->_next->_prev = voice;
 }
 
-void MidiDriver_ADLIB::mcKeyOn(AdLibVoice *voice, const AdLibInstrument *instr, byte note, byte velocity, const AdLibInstrument *second, byte pan) {
+void MidiDriver_ADLIB::mcKeyOn(AdLibVoice *voice, const AdLibInstrument *instr, const AdLibRegisterProgram *program, byte note, byte velocity,
+                               const AdLibInstrument *second, const AdLibRegisterProgram *secondProgram, byte pan) {
 	AdLibPart *part = voice->_part;
 	byte vol1, vol2;
 #ifdef ENABLE_OPL3
 	byte secVol1 = 0, secVol2 = 0;
 #endif
 
-	voice->_twoChan = instr->feedback & 1;
+	voice->_twoChan = program->feedback & 1;
 	voice->_note = note;
 	voice->_waitForPedal = false;
 	voice->_duration = instr->duration;
@@ -2007,12 +2081,12 @@ void MidiDriver_ADLIB::mcKeyOn(AdLibVoice *voice, const AdLibInstrument *instr,
 	if (!_scummSmallHeader) {
 #ifdef ENABLE_OPL3
 		if (_opl3Mode)
-			vol1 = (instr->modScalingOutputLevel & 0x3F) + (velocity * ((instr->modWaveformSelect >> 3) + 1)) / 64;
+			vol1 = program->modVolume + (velocity * ((program->modVelocityScale >> 1) + 1)) / 64;
 		else
 #endif
-		vol1 = (instr->modScalingOutputLevel & 0x3F) + g_volumeLookupTable[velocity >> 1][instr->modWaveformSelect >> 2];
+		vol1 = program->modVolume + g_volumeLookupTable[velocity >> 1][program->modVelocityScale];
 	} else {
-		vol1 = 0x3f - (instr->modScalingOutputLevel & 0x3F);
+		vol1 = 0x3f - program->modVolume;
 	}
 	if (vol1 > 0x3F)
 		vol1 = 0x3F;
@@ -2021,12 +2095,12 @@ void MidiDriver_ADLIB::mcKeyOn(AdLibVoice *voice, const AdLibInstrument *instr,
 	if (!_scummSmallHeader) {
 #ifdef ENABLE_OPL3
 		if (_opl3Mode)
-			vol2 = (instr->carScalingOutputLevel & 0x3F) + (velocity * ((instr->carWaveformSelect >> 3) + 1)) / 64;
+			vol2 = program->carVolume + (velocity * ((program->carVelocityScale >> 1) + 1)) / 64;
 		else
 #endif
-		vol2 = (instr->carScalingOutputLevel & 0x3F) + g_volumeLookupTable[velocity >> 1][instr->carWaveformSelect >> 2];
+		vol2 = program->carVolume + g_volumeLookupTable[velocity >> 1][program->carVelocityScale];
 	} else {
-		vol2 = 0x3f - (instr->carScalingOutputLevel & 0x3F);
+		vol2 = 0x3f - program->carVolume;
 	}
 	if (vol2 > 0x3F)
 		vol2 = 0x3F;
@@ -2034,13 +2108,13 @@ void MidiDriver_ADLIB::mcKeyOn(AdLibVoice *voice, const AdLibInstrument *instr,
 
 #ifdef ENABLE_OPL3
 	if (_opl3Mode) {
-		voice->_secTwoChan = second->feedback & 1;
-		secVol1 = (second->modScalingOutputLevel & 0x3F) + (velocity * ((second->modWaveformSelect >> 3) + 1)) / 64;
+		voice->_secTwoChan = secondProgram->feedback & 1;
+		secVol1 = secondProgram->modVolume + (velocity * ((secondProgram->modVelocityScale >> 1) + 1)) / 64;
 		if (secVol1 > 0x3F) {
 			secVol1 = 0x3F;
 		}
 		voice->_secVol1 = secVol1;
-		secVol2 = (second->carScalingOutputLevel & 0x3F) + (velocity * ((second->carWaveformSelect >> 3) + 1)) / 64;
+		secVol2 = secondProgram->carVolume + (velocity * ((secondProgram->carVelocityScale >> 1) + 1)) / 64;
 		if (secVol2 > 0x3F) {
 			secVol2 = 0x3F;
 		}
@@ -2068,7 +2142,7 @@ void MidiDriver_ADLIB::mcKeyOn(AdLibVoice *voice, const AdLibInstrument *instr,
 #endif
 	}
 
-	adlibSetupChannel(voice->_channel, instr, vol1, vol2);
+	adlibSetupChannel(voice->_channel, program, vol1, vol2);
 #ifdef ENABLE_OPL3
 	if (!_opl3Mode) {
 #endif
@@ -2087,30 +2161,30 @@ void MidiDriver_ADLIB::mcKeyOn(AdLibVoice *voice, const AdLibInstrument *instr,
 		}
 #ifdef ENABLE_OPL3
 	} else {
-		adlibSetupChannelSecondary(voice->_channel, second, secVol1, secVol2, pan);
+		adlibSetupChannelSecondary(voice->_channel, secondProgram, secVol1, secVol2, pan);
 		adlibNoteOnEx(voice->_channel, note, part->_pitchBend >> 1);
 	}
 #endif
 }
 
-void MidiDriver_ADLIB::adlibSetupChannel(int chan, const AdLibInstrument *instr, byte vol1, byte vol2) {
+void MidiDriver_ADLIB::adlibSetupChannel(int chan, const AdLibRegisterProgram *program, byte vol1, byte vol2) {
 	assert(chan >= 0 && chan < 9);
 
 	byte channel = g_operator1Offsets[chan];
-	adlibWrite(channel + 0x20, instr->modCharacteristic);
-	adlibWrite(channel + 0x40, (instr->modScalingOutputLevel | 0x3F) - vol1);
-	adlibWrite(channel + 0x60, 0xff & (~instr->modAttackDecay));
-	adlibWrite(channel + 0x80, 0xff & (~instr->modSustainRelease));
-	adlibWrite(channel + 0xE0, instr->modWaveformSelect);
+	adlibWrite(channel + 0x20, program->modRegs[0]);
+	adlibWrite(channel + 0x40, program->modLevel - vol1);
+	adlibWrite(channel + 0x60, program->modRegs[1]);
+	adlibWrite(channel + 0x80, program->modRegs[2]);
+	adlibWrite(channel + 0xE0, program->modRegs[3]);
 
 	channel = g_operator2Offsets[chan];
-	adlibWrite(channel + 0x20, instr->carCharacteristic);
-	adlibWrite(channel + 0x40, (instr->carScalingOutputLevel | 0x3F) - vol2);
-	adlibWrite(channel + 0x60, 0xff & (~instr->carAttackDecay));
-	adlibWrite(channel + 0x80, 0xff & (~instr->carSustainRelease));
-	adlibWrite(channel + 0xE0, instr->carWaveformSelect);
+	adlibWrite(channel + 0x20, program->carRegs[0]);
+	adlibWrite(channel + 0x40, program->carLevel - vol2);
+	adlibWrite(channel + 0x60, program->carRegs[1]);
+	adlibWrite(channel + 0x80, program->carRegs[2]);
+	adlibWrite(channel + 0xE0, program->carRegs[3]);
 
-	adlibWrite((byte)chan + 0xC0, instr->feedback
+	adlibWrite((byte)chan + 0xC0, program->feedback
 #ifdef ENABLE_OPL3
 			| (_opl3Mode ? 0x30 : 0)
 #endif
@@ -2118,33 +2192,33 @@ void MidiDriver_ADLIB::adlibSetupChannel(int chan, const AdLibInstrument *instr,
 }
 
 #ifdef ENABLE_OPL3
-void MidiDriver_ADLIB::adlibSetupChannelSecondary(int chan, const AdLibInstrument *instr, byte vol1, byte vol2, byte pan) {
+void MidiDriver_ADLIB::adlibSetupChannelSecondary(int chan, const AdLibRegisterProgram *program, byte vol1, byte vol2, byte pan) {
 	assert(chan >= 0 && chan < 9);
 	assert(_opl3Mode);
 
 	byte channel = g_operator1Offsets[chan];
-	adlibWriteSecondary(channel + 0x20, instr->modCharacteristic);
-	adlibWriteSecondary(channel + 0x40, (instr->modScalingOutputLevel | 0x3F) - vol1);
-	adlibWriteSecondary(channel + 0x60, 0xff & (~instr->modAttackDecay));
-	adlibWriteSecondary(channel + 0x80, 0xff & (~instr->modSustainRelease));
-	adlibWriteSecondary(channel + 0xE0, instr->modWaveformSelect);
+	adlibWriteSecondary(channel + 0x20, program->modRegs[0]);
+	adlibWriteSecondary(channel + 0x40, program->modLevel - vol1);
+	adlibWriteSecondary(channel + 0x60, program->modRegs[1]);
+	adlibWriteSecondary(channel + 0x80, program->modRegs[2]);
+	adlibWriteSecondary(channel + 0xE0, program->modRegs[3]);
 
 	channel = g_operator2Offsets[chan];
-	adlibWriteSecondary(channel + 0x20, instr->carCharacteristic);
-	adlibWriteSecondary(channel + 0x40, (instr->carScalingOutputLevel | 0x3F) - vol2);
-	adlibWriteSecondary(channel + 0x60, 0xff & (~instr->carAttackDecay));
-	adlibWriteSecondary(channel + 0x80, 0xff & (~instr->carSustainRelease));
-	adlibWriteSecondary(channel + 0xE0, instr->carWaveformSelect);
+	adlibWriteSecondary(channel + 0x20, program->carRegs[0]);
+	adlibWriteSecondary(channel + 0x40, program->carLevel - vol2);
+	adlibWriteSecondary(channel + 0x60, program->carRegs[1]);
+	adlibWriteSecondary(channel + 0x80, program->carRegs[2]);
+	adlibWriteSecondary(channel + 0xE0, program->carRegs[3]);
 
 	// The original uses the following (strange) behavior:
 #if 0
-	if (instr->feedback | (pan > 64)) {
+	if (program->feedback | (pan > 64)) {
 		adlibWriteSecondary((byte)chan + 0xC0, 0x20);
 	} else {
 		adlibWriteSecondary((byte)chan + 0xC0, 0x10);
 	}
 #else
-	adlibWriteSecondary((byte)chan + 0xC0, instr->feedback | ((pan > 64) ? 0x20 : 0x10));
+	adlibWriteSecondary((byte)chan + 0xC0, program->feedback | ((pan > 64) ? 0x20 : 0x10));
 #endif
 }
 #endif
@@ -197,6 +197,8 @@ void OPL::write(int port, int val) {
 	int chip = (port & 2) >> 1;
 
 	if (port & 1) {
+		countWrite();
+
 		switch(_type) {
 		case Config::kOpl2:
 			writeOplReg(0, index[0], val);
@@ -234,6 +236,8 @@ byte OPL::read(int port) {
 }
 
 void OPL::writeReg(int r, int v) {
+	countWrite();
+
 	switch (_type) {
 	case Config::kOpl2:
 		writeOplReg(0, r, v);
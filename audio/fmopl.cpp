@@ -25,8 +25,11 @@
 #include "audio/mixer.h"
 #include "audio/softsynth/opl/dosbox.h"
 #include "audio/softsynth/opl/mame.h"
+#include "audio/softsynth/opl/reference.h"
 
 #include "common/config-manager.h"
+#include "common/stream.h"
+#include "common/str.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/timer.h"
@@ -48,13 +51,17 @@ enum OplEmulator {
 	kAuto = 0,
 	kMame = 1,
 	kDOSBox = 2,
-	kALSA = 3
+	kALSA = 3,
+	kReference = 4
 };
 
-OPL::OPL() {
+OPL::OPL() : _instrumented(false) {
 	if (_hasInstance)
 		error("There are multiple OPL output instances running");
 	_hasInstance = true;
+	_instance = this;
+
+	memset(&_statistics, 0, sizeof(_statistics));
 }
 
 const Config::EmulatorDescription Config::_drivers[] = {
@@ -66,6 +73,7 @@ const Config::EmulatorDescription Config::_drivers[] = {
 #ifdef USE_ALSA
 	{ "alsa", _s("ALSA Direct FM"), kALSA, kFlagOpl2 | kFlagDualOpl2 | kFlagOpl3 },
 #endif
+	{ "reference", _s("Reference OPL emulator (slow)"), kReference, kFlagOpl2 | kFlagDualOpl2 | kFlagOpl3 | kFlagNoAutoDetect },
 	{ 0, 0, 0, 0 }
 };
 
@@ -132,7 +140,7 @@ Config::DriverId Config::detect(OplType type) {
 	drv = -1;
 
 	for (int i = 1; _drivers[i].name; ++i) {
-		if (_drivers[i].flags & flags) {
+		if ((_drivers[i].flags & flags) && !(_drivers[i].flags & kFlagNoAutoDetect)) {
 			drv = _drivers[i].id;
 			break;
 		}
@@ -183,6 +191,9 @@ OPL *Config::create(DriverId driver, OplType type) {
 		return ALSA::create(type);
 #endif
 
+	case kReference:
+		return new Reference::OPL(type);
+
 	default:
 		warning("Unsupported OPL emulator %d", driver);
 		// TODO: Maybe we should add some dummy emulator too, which just outputs
@@ -201,9 +212,89 @@ void OPL::stop() {
 	_callback.reset();
 }
 
+void OPL::setInstrumentation(bool enable) {
+	if (enable && !_instrumented)
+		resetStatistics();
+	_instrumented = enable;
+}
+
+Statistics OPL::getStatistics() const {
+	Common::StackLock lock(_statisticsMutex);
+	return _statistics;
+}
+
+void OPL::resetStatistics() {
+	Common::StackLock lock(_statisticsMutex);
+	memset(&_statistics, 0, sizeof(_statistics));
+	_statistics.startTime = g_system->getMillis();
+}
+
+static const char *const s_envelopePhaseNames[] = {
+	"off", "attack", "decay", "sustain", "release"
+};
+
+void OPL::writeStatusCSV(Common::WriteStream &stream) const {
+	// Statistics and channel rows are told apart by the first column
+	const Statistics stats = getStatistics();
+	stream.writeString("statistic,name,value\n");
+	stream.writeString(Common::String::format("statistic,duration,%u\n", g_system->getMillis() - stats.startTime));
+	stream.writeString(Common::String::format("statistic,writes,%u\n", stats.writes));
+	stream.writeString(Common::String::format("statistic,callbacks,%u\n", stats.callbacks));
+	stream.writeString(Common::String::format("statistic,blocks,%u\n", stats.blocks));
+	stream.writeString(Common::String::format("statistic,frames,%u\n", stats.frames));
+	stream.writeString(Common::String::format("statistic,render_time,%u\n", stats.renderTime));
+	stream.writeString(Common::String::format("statistic,max_block_time,%u\n", stats.maxBlockTime));
+
+	stream.writeString("channel,index,key_on,phase,active_operators,synth_mode\n");
+	for (int i = 0; i < getChannelCount(); ++i) {
+		ChannelStatus status;
+		if (!getChannelStatus(i, status))
+			continue;
+
+		stream.writeString(Common::String::format("channel,%d,%d,%s,%d,%s\n", i, status.keyOn ? 1 : 0,
+		                                          s_envelopePhaseNames[status.phase], status.activeOperators,
+		                                          status.synthMode ? status.synthMode : ""));
+	}
+}
+
 bool OPL::_hasInstance = false;
+OPL *OPL::_instance = 0;
+
+TickScheduler::TickScheduler() : _clockRate(0), _tickRate(0), _phase(0) {
+}
+
+void TickScheduler::setRates(uint32 clockRate, uint32 tickRate) {
+	assert(clockRate > 0 && tickRate > 0);
+
+	// Keep the position within the current tick
+	if (_clockRate && _clockRate != clockRate)
+		_phase = _phase * clockRate / _clockRate;
+
+	_clockRate = clockRate;
+	_tickRate = tickRate;
+}
+
+void TickScheduler::reset() {
+	_phase = _clockRate;
+}
+
+uint32 TickScheduler::getUnitsToNextTick() const {
+	if (_phase >= _clockRate)
+		return 0;
+
+	// Round up, the tick is due at the first unit reaching _clockRate
+	return (uint32)((_clockRate - _phase + _tickRate - 1) / _tickRate);
+}
 
-RealOPL::RealOPL() : _baseFreq(0), _remainingTicks(0) {
+uint32 TickScheduler::advance(uint32 units) {
+	_phase += (uint64)units * _tickRate;
+
+	uint32 ticks = (uint32)(_phase / _clockRate);
+	_phase %= _clockRate;
+	return ticks;
+}
+
+RealOPL::RealOPL() : _baseFreq(0) {
 }
 
 RealOPL::~RealOPL() {
@@ -228,14 +319,16 @@ void RealOPL::startCallbacks(int timerFrequency) {
 	if (timerFrequency > kMaxFreq)
 		timerFrequency = kMaxFreq;
 
-	_remainingTicks = 0;
+	// The scheduler counts timer procs instead of measuring the elapsed
+	// time, so jitter of the timer thread can not add or drop ticks.
+	_scheduler.setRates(timerFrequency, _baseFreq);
+
 	g_system->getTimerManager()->installTimerProc(timerProc, 1000000 / timerFrequency, this, "RealOPL");
 }
 
 void RealOPL::stopCallbacks() {
 	g_system->getTimerManager()->removeTimerProc(timerProc);
 	_baseFreq = 0;
-	_remainingTicks = 0;
 }
 
 void RealOPL::timerProc(void *refCon) {
@@ -243,26 +336,15 @@ void RealOPL::timerProc(void *refCon) {
 }
 
 void RealOPL::onTimer() {
-	uint callbacks = 1;
-
-	if (_baseFreq > kMaxFreq) {
-		// We run faster than our max, so run the callback multiple
-		// times to approximate the actual timer callback frequency.
-		uint totalTicks = _baseFreq + _remainingTicks;
-		callbacks = totalTicks / kMaxFreq;
-		_remainingTicks = totalTicks % kMaxFreq;
-	}
+	uint32 callbacks = _scheduler.advance(1);
 
-	// Call the callback multiple times. The if is on the inside of the
-	// loop in case the callback removes itself.
-	for (uint i = 0; i < callbacks; i++)
-		if (_callback && _callback->isValid())
-			(*_callback)();
+	// Call the callback multiple times. The check is done by runCallback
+	// in case the callback removes itself.
+	for (uint32 i = 0; i < callbacks; i++)
+		runCallback();
 }
 
 EmulatedOPL::EmulatedOPL() :
-	_nextTick(0),
-	_samplesPerTick(0),
 	_baseFreq(0),
 	_handle(new Audio::SoundHandle()) {
 }
@@ -282,25 +364,44 @@ int EmulatedOPL::readBuffer(int16 *buffer, const int numSamples) {
 	int len = numSamples / stereoFactor;
 	int step;
 
-	do {
-		step = len;
-		if (step > (_nextTick >> FIXP_SHIFT))
-			step = (_nextTick >> FIXP_SHIFT);
+	// The render time is measured in ms, so a single block mostly shows
+	// up as 0 or 1 ms. Summed up over many blocks it is accurate, though.
+	uint32 renderTime = 0;
 
-		generateSamples(buffer, step * stereoFactor);
+	Common::StackLock emulatorLock(_emulatorMutex);
 
-		_nextTick -= step << FIXP_SHIFT;
-		if (!(_nextTick >> FIXP_SHIFT)) {
-			if (_callback && _callback->isValid())
-				(*_callback)();
+	do {
+		step = len;
+		if ((uint32)step > _scheduler.getUnitsToNextTick())
+			step = _scheduler.getUnitsToNextTick();
 
-			_nextTick += _samplesPerTick;
+		if (_instrumented) {
+			const uint32 startTime = g_system->getMillis();
+			generateSamples(buffer, step * stereoFactor);
+			renderTime += g_system->getMillis() - startTime;
+		} else {
+			generateSamples(buffer, step * stereoFactor);
 		}
 
+		// Run the callback for every tick which is due at this sample
+		// position. This can be more than one tick when the callback
+		// frequency is higher than the output rate.
+		uint32 ticks = _scheduler.advance(step);
+		while (ticks--)
+			runCallback();
+
 		buffer += step * stereoFactor;
 		len -= step;
 	} while (len);
 
+	if (_instrumented) {
+		Common::StackLock lock(_statisticsMutex);
+		++_statistics.blocks;
+		_statistics.frames += numSamples / stereoFactor;
+		_statistics.renderTime += renderTime;
+		_statistics.maxBlockTime = MAX(_statistics.maxBlockTime, renderTime);
+	}
+
 	return numSamples;
 }
 
@@ -310,6 +411,7 @@ int EmulatedOPL::getRate() const {
 
 void EmulatedOPL::startCallbacks(int timerFrequency) {
 	setCallbackFrequency(timerFrequency);
+	_scheduler.reset();
 	g_system->getMixer()->playStream(Audio::Mixer::kPlainSoundType, _handle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
 }
 
@@ -321,13 +423,7 @@ void EmulatedOPL::setCallbackFrequency(int timerFrequency) {
 	_baseFreq = timerFrequency;
 	assert(_baseFreq != 0);
 
-	int d = getRate() / _baseFreq;
-	int r = getRate() % _baseFreq;
-
-	// This is equivalent to (getRate() << FIXP_SHIFT) / BASE_FREQ
-	// but less prone to arithmetic overflow.
-
-	_samplesPerTick = (d << FIXP_SHIFT) + (r << FIXP_SHIFT) / _baseFreq;
+	_scheduler.setRates(getRate(), _baseFreq);
 }
 
 } // End of namespace OPL
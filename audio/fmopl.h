@@ -26,9 +26,14 @@
 #include "audio/audiostream.h"
 
 #include "common/func.h"
+#include "common/mutex.h"
 #include "common/ptr.h"
 #include "common/scummsys.h"
 
+namespace Common {
+class WriteStream;
+}
+
 namespace Audio {
 class SoundHandle;
 }
@@ -46,7 +51,8 @@ public:
 	enum OplFlags {
 		kFlagOpl2		= (1 << 0),
 		kFlagDualOpl2	= (1 << 1),
-		kFlagOpl3		= (1 << 2)
+		kFlagOpl3		= (1 << 2),
+		kFlagNoAutoDetect	= (1 << 3)	///< Only used when selected explicitly
 	};
 
 	/**
@@ -111,15 +117,101 @@ private:
  */
 typedef Common::Functor0<void> TimerCallback;
 
+/**
+ * Distributes driver ticks over a clock running at a different rate.
+ *
+ * The tick position is tracked as an exact fraction of the clock rate, so
+ * ticks are delivered at their true average frequency without accumulating
+ * rounding errors, no matter how the clock is advanced. Both the emulated
+ * OPLs (clock = output samples) and the real OPLs (clock = timer procs)
+ * use this to drive the timer callback.
+ */
+class TickScheduler {
+public:
+	TickScheduler();
+
+	/**
+	 * Sets the rate of the clock and the tick frequency, both in Hz. The
+	 * position within the current tick is kept.
+	 */
+	void setRates(uint32 clockRate, uint32 tickRate);
+
+	/**
+	 * Makes the next tick due immediately.
+	 */
+	void reset();
+
+	/**
+	 * @return the number of clock units until the next tick is due, 0 if
+	 *         a tick is due right now
+	 */
+	uint32 getUnitsToNextTick() const;
+
+	/**
+	 * Advances the clock.
+	 *
+	 * @param units		number of clock units which passed
+	 * @return			number of ticks which became due, including a tick which
+	 *					was already due before advancing
+	 */
+	uint32 advance(uint32 units);
+
+private:
+	uint32 _clockRate;
+	uint32 _tickRate;
+	/** Position within the current tick, a tick is due at _clockRate */
+	uint64 _phase;
+};
+
+/**
+ * Snapshot of the state of a single OPL channel, used for instrumentation.
+ */
+struct ChannelStatus {
+	enum EnvelopePhase {
+		kPhaseOff,
+		kPhaseAttack,
+		kPhaseDecay,
+		kPhaseSustain,
+		kPhaseRelease
+	};
+
+	bool keyOn;
+	/** Envelope phase of the most active operator of the channel */
+	EnvelopePhase phase;
+	/** Number of operators which are not silent */
+	uint8 activeOperators;
+	/** Name of the emulator's render path for this channel, 0 if unknown */
+	const char *synthMode;
+};
+
+/**
+ * Counters collected by an OPL while instrumentation is enabled.
+ */
+struct Statistics {
+	uint32 startTime;		///< g_system->getMillis() at the last reset
+	uint32 writes;			///< register data writes, per chip for dual OPL2
+	uint32 callbacks;		///< timer callbacks
+	uint32 blocks;			///< readBuffer calls (emulated OPLs only)
+	uint32 frames;			///< frames rendered (emulated OPLs only)
+	uint32 renderTime;		///< time spent generating samples, in ms (emulated OPLs only)
+	uint32 maxBlockTime;	///< longest time spent generating one block, in ms (emulated OPLs only)
+};
+
 /**
  * A representation of a Yamaha OPL chip.
  */
 class OPL {
 private:
 	static bool _hasInstance;
+	static OPL *_instance;
 public:
 	OPL();
-	virtual ~OPL() { _hasInstance = false; }
+	virtual ~OPL() { _hasInstance = false; _instance = 0; }
+
+	/**
+	 * Returns the OPL which is currently in use, 0 if there is none.
+	 */
+	static OPL *getInstance() { return _instance; }
 
 	/**
 	 * Initializes the OPL emulator.
@@ -183,7 +275,74 @@ public:
 		kDefaultCallbackFrequency = 250
 	};
 
+	/**
+	 * @name Instrumentation
+	 *
+	 * Optional interface to inspect what the OPL is doing, e.g. from the
+	 * debugger console. Collecting the statistics costs some time in the
+	 * audio thread, so it is disabled by default. The channel status can
+	 * be queried at any time from emulators supporting it.
+	 */
+	//@{
+
+	void setInstrumentation(bool enable);
+	bool isInstrumented() const { return _instrumented; }
+
+	/**
+	 * @return a snapshot of the statistics. They are updated from the
+	 *         audio thread, so they cannot be accessed directly.
+	 */
+	Statistics getStatistics() const;
+	void resetStatistics();
+
+	/**
+	 * @return number of channels getChannelStatus can report, 0 when the
+	 *         emulator does not support channel status
+	 */
+	virtual int getChannelCount() const { return 0; }
+
+	/**
+	 * Queries the current state of a channel. For dual OPL2, the channels
+	 * of the second chip follow the ones of the first chip.
+	 *
+	 * @return false if the channel status is not available
+	 */
+	virtual bool getChannelStatus(int channel, ChannelStatus &status) const { return false; }
+
+	/**
+	 * Writes the statistics and the status of all channels as CSV.
+	 */
+	void writeStatusCSV(Common::WriteStream &stream) const;
+
+	//@}
+
 protected:
+	/**
+	 * Runs the timer callback, if there is one.
+	 */
+	void runCallback() {
+		if (_instrumented) {
+			Common::StackLock lock(_statisticsMutex);
+			++_statistics.callbacks;
+		}
+		if (_callback && _callback->isValid())
+			(*_callback)();
+	}
+
+	/**
+	 * Counts a register data write. Called by the implementations.
+	 */
+	void countWrite() {
+		if (_instrumented) {
+			Common::StackLock lock(_statisticsMutex);
+			++_statistics.writes;
+		}
+	}
+
+	bool _instrumented;
+	Statistics _statistics;
+	mutable Common::Mutex _statisticsMutex;
+
 	/**
 	 * Start the callbacks.
 	 */
@@ -204,7 +363,9 @@ protected:
  * An OPL that represents a real OPL, as opposed to an emulated one.
  *
  * This will use an actual timer instead of using one calculated from
- * the number of samples in an AudioStream::readBuffer call.
+ * the number of samples in an AudioStream::readBuffer call. The timer
+ * can not run faster than kMaxFreq, so faster ticks are spread evenly
+ * over the timer procs.
  */
 class RealOPL : public OPL {
 public:
@@ -224,7 +385,7 @@ private:
 	void onTimer();
 
 	uint _baseFreq;
-	uint _remainingTicks;
+	TickScheduler _scheduler;
 
 	enum {
 		kMaxFreq = 100
@@ -235,7 +396,8 @@ private:
  * An OPL that represents an emulated OPL.
  *
  * This will send callbacks based on the number of samples
- * decoded in readBuffer().
+ * decoded in readBuffer(). Each callback happens exactly at the
+ * sample position where its tick is due.
  */
 class EmulatedOPL : public OPL, protected Audio::AudioStream {
 public:
@@ -267,15 +429,17 @@ protected:
 	 */
 	virtual void generateSamples(int16 *buffer, int numSamples) = 0;
 
+	/**
+	 * Held by readBuffer while the emulator generates samples and runs the
+	 * timer callbacks. Implementations lock it to inspect the emulator state
+	 * from other threads, e.g. in getChannelStatus.
+	 */
+	mutable Common::Mutex _emulatorMutex;
+
 private:
 	int _baseFreq;
 
-	enum {
-		FIXP_SHIFT = 16
-	};
-
-	int _nextTick;
-	int _samplesPerTick;
+	TickScheduler _scheduler;
 
 	Audio::SoundHandle *_handle;
 };
@@ -87,6 +87,12 @@ struct InstrumentEntry {
 	byte reg80op2;
 	byte regE0op2;
 	byte regC0;
+
+	// Precomputed when the instrument is loaded, so that a note on or volume
+	// change only has to scale the output levels
+	byte volumeOp1;	// output level (inverted total level) of operator 1
+	byte volumeOp2;
+	bool scaleOp1;	// operator 1 is a carrier (additive synthesis)
 };
 
 // hardcoded, dumped from ADLIB.MDI
@@ -756,10 +762,10 @@ void MidiDriver_Miles_AdLib::updatePhysicalFmVoice(byte virtualFmVoice, bool key
 		byte reg40op1 = instrumentPtr->reg40op1;
 		byte reg40op2 = instrumentPtr->reg40op2;
 
-		uint16 volumeOp1 = (~reg40op1) & 0x3F;
-		uint16 volumeOp2 = (~reg40op2) & 0x3F;
+		uint16 volumeOp1 = instrumentPtr->volumeOp1;
+		uint16 volumeOp2 = instrumentPtr->volumeOp2;
 
-		if (instrumentPtr->regC0 & 1) {
+		if (instrumentPtr->scaleOp1) {
 			// operator 2 enabled
 			// scale volume factor
 			volumeOp1 = (volumeOp1 * compositeVolume) / 127;
@@ -1260,6 +1266,10 @@ MidiDriver *MidiDriver_Miles_AdLib_create(const Common::String &filenameAdLib, c
 		instrumentPtr->reg80op2 = streamDataPtr[instrumentOffset + 12];
 		instrumentPtr->regE0op2 = streamDataPtr[instrumentOffset + 13];
 
+		instrumentPtr->volumeOp1 = (~instrumentPtr->reg40op1) & 0x3F;
+		instrumentPtr->volumeOp2 = (~instrumentPtr->reg40op2) & 0x3F;
+		instrumentPtr->scaleOp1  = (instrumentPtr->regC0 & 1) != 0;
+
 		// Instrument read, next instrument please
 		instrumentPtr++;
 	}
@@ -784,6 +784,25 @@ void Channel::ResetC0( const Chip* chip ) {
 	WriteC0( chip, val );
 }
 
+SynthMode Channel::GetSynthMode() const {
+	static const SynthMode modes[] = {
+		sm2AM, sm2FM, sm3AM, sm3FM, sm3FMFM, sm3AMFM, sm3FMAM, sm3AMAM, sm2Percussion, sm3Percussion
+	};
+	static const SynthHandler handlers[] = {
+		&Channel::BlockTemplate< sm2AM >, &Channel::BlockTemplate< sm2FM >,
+		&Channel::BlockTemplate< sm3AM >, &Channel::BlockTemplate< sm3FM >,
+		&Channel::BlockTemplate< sm3FMFM >, &Channel::BlockTemplate< sm3AMFM >,
+		&Channel::BlockTemplate< sm3FMAM >, &Channel::BlockTemplate< sm3AMAM >,
+		&Channel::BlockTemplate< sm2Percussion >, &Channel::BlockTemplate< sm3Percussion >
+	};
+
+	for ( Bitu i = 0; i < sizeof( modes ) / sizeof( modes[0] ); i++ ) {
+		if ( synthHandler == handlers[i] )
+			return modes[i];
+	}
+	return sm2FM;
+}
+
 template< bool opl3Mode>
 INLINE void Channel::GeneratePercussion( Chip* chip, Bit32s* output ) {
 	Channel* chan = this;
@@ -207,6 +207,8 @@ struct Channel {
 	void WriteB0( const Chip* chip, Bit8u val );
 	void WriteC0( const Chip* chip, Bit8u val );
 	void ResetC0( const Chip* chip );
+	//Which of the block generation modes is currently used, for instrumentation
+	SynthMode GetSynthMode() const;
 
 	//call this for the first channel
 	template< bool opl3Mode >
@@ -145,7 +145,7 @@ uint8 Chip::read() {
 	return ret;
 }
 
-OPL::OPL(Config::OplType type) : _type(type), _rate(0), _emulator(0) {
+OPL::OPL(Config::OplType type) : _type(type), _rate(0), _emulator(0), _emulatorRight(0) {
 }
 
 OPL::~OPL() {
@@ -156,9 +156,12 @@ OPL::~OPL() {
 void OPL::free() {
 	delete _emulator;
 	_emulator = 0;
+	delete _emulatorRight;
+	_emulatorRight = 0;
 }
 
 bool OPL::init() {
+	Common::StackLock lock(_emulatorMutex);
 	free();
 
 	memset(&_reg, 0, sizeof(_reg));
@@ -169,12 +172,15 @@ bool OPL::init() {
 		return false;
 
 	DBOPL::InitTables();
-	_rate = g_system->getMixer()->getOutputRate();
+	_rate = getRate();
 	_emulator->Setup(_rate);
 
 	if (_type == Config::kDualOpl2) {
-		// Setup opl3 mode in the hander
-		_emulator->WriteReg(0x105, 1);
+		// Emulate both chips natively in OPL2 mode instead of mapping them
+		// onto the two register banks of an OPL3. This avoids the OPL3 4-op
+		// channel handling and stereo mixing for each chip.
+		_emulatorRight = new DBOPL::Chip();
+		_emulatorRight->Setup(_rate);
 	}
 
 	return true;
@@ -189,6 +195,7 @@ void OPL::write(int port, int val) {
 		switch (_type) {
 		case Config::kOpl2:
 		case Config::kOpl3:
+			countWrite();
 			if (!_chip[0].write(_reg.normal, val))
 				_emulator->WriteReg(_reg.normal, val);
 			break;
@@ -286,6 +293,9 @@ void OPL::writeReg(int r, int v) {
 }
 
 void OPL::dualWrite(uint8 index, uint8 reg, uint8 val) {
+	// Writes to both chips count once for each chip
+	countWrite();
+
 	// Make sure you don't use opl3 features
 	// Don't allow write to disable opl3
 	if (reg == 5)
@@ -295,18 +305,73 @@ void OPL::dualWrite(uint8 index, uint8 reg, uint8 val) {
 	if (reg >= 0xE0 && reg <= 0xE8)
 		val &= 3;
 
+	// The waveforms used to be always available when both chips were
+	// emulated with an OPL3, so keep the waveform select enabled.
+	if (reg == 0x01)
+		val |= 0x20;
+
 	// Write to the timer?
 	if (_chip[index].write(reg, val))
 		return;
 
-	// Enabling panning
-	if (reg >= 0xC0 && reg <= 0xC8) {
-		val &= 15;
-		val |= index ? 0xA0 : 0x50;
+	(index ? _emulatorRight : _emulator)->WriteReg(reg, val);
+}
+
+int OPL::getChannelCount() const {
+	return (_type == Config::kOpl2) ? 9 : 18;
+}
+
+bool OPL::getChannelStatus(int channel, ChannelStatus &status) const {
+	static const char *const synthModeNames[] = {
+		"sm2AM", "sm2FM", "sm3AM", "sm3FM", "sm4Start", "sm3FMFM", "sm3AMFM", "sm3FMAM", "sm3AMAM",
+		"sm6Start", "sm2Percussion", "sm3Percussion"
+	};
+
+	if (channel < 0 || channel >= getChannelCount())
+		return false;
+
+	// The mixer thread may be running the emulator right now
+	Common::StackLock lock(_emulatorMutex);
+	if (!_emulator)
+		return false;
+
+	const DBOPL::Channel *chan;
+	if (_type == Config::kDualOpl2)
+		chan = &(channel < 9 ? _emulator : _emulatorRight)->chan[channel % 9];
+	else
+		chan = &_emulator->chan[channel];
+
+	uint8 state = DBOPL::Operator::OFF;
+	status.keyOn = false;
+	status.activeOperators = 0;
+	for (int i = 0; i < 2; ++i) {
+		const DBOPL::Operator &op = chan->op[i];
+		if (op.keyOn)
+			status.keyOn = true;
+		if (!op.Silent())
+			++status.activeOperators;
+		state = MAX(state, op.state);
 	}
 
-	uint32 fullReg = reg + (index ? 0x100 : 0);
-	_emulator->WriteReg(fullReg, val);
+	switch (state) {
+	case DBOPL::Operator::ATTACK:
+		status.phase = ChannelStatus::kPhaseAttack;
+		break;
+	case DBOPL::Operator::DECAY:
+		status.phase = ChannelStatus::kPhaseDecay;
+		break;
+	case DBOPL::Operator::SUSTAIN:
+		status.phase = ChannelStatus::kPhaseSustain;
+		break;
+	case DBOPL::Operator::RELEASE:
+		status.phase = ChannelStatus::kPhaseRelease;
+		break;
+	default:
+		status.phase = ChannelStatus::kPhaseOff;
+	}
+
+	status.synthMode = synthModeNames[chan->GetSynthMode()];
+	return true;
 }
 
 void OPL::generateSamples(int16 *buffer, int length) {
@@ -318,7 +383,23 @@ void OPL::generateSamples(int16 *buffer, int length) {
 	const uint bufferLength = 512;
 	int32 tempBuffer[bufferLength * 2];
 
-	if (_emulator->opl3Active) {
+	if (_type == Config::kDualOpl2) {
+		// Each chip is mono and hard panned to its side
+		while (length > 0) {
+			const uint readSamples = MIN<uint>(length, bufferLength);
+
+			_emulator->GenerateBlock2(readSamples, tempBuffer);
+			_emulatorRight->GenerateBlock2(readSamples, tempBuffer + bufferLength);
+
+			for (uint i = 0; i < readSamples; ++i) {
+				buffer[(i << 1) + 0] = tempBuffer[i];
+				buffer[(i << 1) + 1] = tempBuffer[bufferLength + i];
+			}
+
+			buffer += (readSamples << 1);
+			length -= readSamples;
+		}
+	} else if (_emulator->opl3Active) {
 		while (length > 0) {
 			const uint readSamples = MIN<uint>(length, bufferLength);
 
@@ -75,6 +75,8 @@ private:
 	uint _rate;
 
 	DBOPL::Chip *_emulator;
+	// Second chip in dual OPL2 mode, _emulator is the left one then
+	DBOPL::Chip *_emulatorRight;
 	Chip _chip[2];
 	union {
 		uint16 normal;
@@ -97,6 +99,9 @@ public:
 
 	bool isStereo() const { return _type != Config::kOpl2; }
 
+	int getChannelCount() const;
+	bool getChannelStatus(int channel, ChannelStatus &status) const;
+
 protected:
 	void generateSamples(int16 *buffer, int length);
 };
@@ -0,0 +1,443 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/softsynth/opl/harness.h"
+#include "audio/softsynth/opl/dosbox.h"
+#include "audio/softsynth/opl/mame.h"
+#include "audio/softsynth/opl/reference.h"
+
+#include "common/debug.h"
+#include "common/stream.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace OPL {
+namespace Harness {
+
+// Register log
+
+RegisterLog::RegisterLog(Config::OplType type, uint32 rate) : _type(type), _rate(rate), _length(0) {
+}
+
+void RegisterLog::addWrite(uint32 sample, uint16 reg, uint8 value) {
+	assert(_writes.empty() || _writes.back().sample <= sample);
+
+	RegisterWrite write;
+	write.sample = sample;
+	write.reg = reg;
+	write.value = value;
+	_writes.push_back(write);
+
+	extend(sample + 1);
+}
+
+void RegisterLog::extend(uint32 samples) {
+	_length = MAX(_length, samples);
+}
+
+void RegisterLog::clear() {
+	_writes.clear();
+	_length = 0;
+}
+
+bool RegisterLog::loadDRO(Common::SeekableReadStream &stream) {
+	char signature[8];
+	if (stream.read(signature, 8) != 8 || memcmp(signature, "DBRAWOPL", 8))
+		return false;
+
+	const uint16 versionMajor = stream.readUint16LE();
+	const uint16 versionMinor = stream.readUint16LE();
+	if (versionMajor != 2 || versionMinor != 0) {
+		warning("Unsupported DRO version %d.%d", versionMajor, versionMinor);
+		return false;
+	}
+
+	const uint32 lengthPairs = stream.readUint32LE();
+	const uint32 lengthMs = stream.readUint32LE();
+	const byte hardwareType = stream.readByte();
+	const byte format = stream.readByte();
+	const byte compression = stream.readByte();
+	const byte shortDelayCode = stream.readByte();
+	const byte longDelayCode = stream.readByte();
+	const byte codemapLength = stream.readByte();
+
+	if (format != 0 || compression != 0 || codemapLength > 128) {
+		warning("Unsupported DRO format %d, compression %d", format, compression);
+		return false;
+	}
+
+	byte codemap[128];
+	if (stream.read(codemap, codemapLength) != codemapLength)
+		return false;
+
+	switch (hardwareType) {
+	case 0:
+		_type = Config::kOpl2;
+		break;
+	case 1:
+		_type = Config::kDualOpl2;
+		break;
+	case 2:
+		_type = Config::kOpl3;
+		break;
+	default:
+		warning("Unknown DRO hardware type %d", hardwareType);
+		return false;
+	}
+
+	clear();
+
+	uint32 timeMs = 0;
+	for (uint32 i = 0; i < lengthPairs; ++i) {
+		const byte reg = stream.readByte();
+		const byte val = stream.readByte();
+		if (stream.eos() || stream.err())
+			return false;
+
+		if (reg == shortDelayCode) {
+			timeMs += val + 1;
+		} else if (reg == longDelayCode) {
+			timeMs += (val + 1) << 8;
+		} else {
+			const byte index = reg & 0x7f;
+			if (index >= codemapLength)
+				continue;
+			const uint16 fullReg = codemap[index] | ((reg & 0x80) ? 0x100 : 0);
+			addWrite((uint32)((uint64)timeMs * _rate / 1000), fullReg, val);
+		}
+	}
+
+	extend((uint32)((uint64)MAX(timeMs, lengthMs) * _rate / 1000));
+	return true;
+}
+
+// Renderers
+
+namespace {
+
+class ReferenceRenderer : public Renderer {
+public:
+	ReferenceRenderer() : _type(Config::kOpl2) {}
+
+	const char *getName() const { return "reference"; }
+
+	bool init(Config::OplType type, uint32 rate) {
+		_type = type;
+		_chip[0].reset(rate, type != Config::kOpl3);
+		_chip[1].reset(rate, type != Config::kOpl3);
+		return true;
+	}
+
+	void writeReg(int r, int v) {
+		if (_type == Config::kDualOpl2)
+			_chip[(r >> 8) & 1].writeReg(r & 0xff, v);
+		else
+			_chip[0].writeReg(r & 0x1ff, v);
+	}
+
+	void generate(int16 *buffer, int numSamples) {
+		int16 frame[2];
+
+		if (_type == Config::kOpl2) {
+			for (int i = 0; i < numSamples; ++i) {
+				_chip[0].generateResampled(frame);
+				buffer[i] = frame[0];
+			}
+		} else if (_type == Config::kDualOpl2) {
+			for (int i = 0; i < numSamples; i += 2) {
+				_chip[0].generateResampled(frame);
+				buffer[i] = frame[0];
+				_chip[1].generateResampled(frame);
+				buffer[i + 1] = frame[0];
+			}
+		} else {
+			for (int i = 0; i < numSamples; i += 2) {
+				_chip[0].generateResampled(frame);
+				buffer[i] = frame[0];
+				buffer[i + 1] = frame[1];
+			}
+		}
+	}
+
+private:
+	Config::OplType _type;
+	Reference::Chip _chip[2];
+};
+
+#ifndef DISABLE_DOSBOX_OPL
+/**
+ * Plays the log through the DOSBox driver used by ScummVM itself, so that
+ * its register filtering and sample output are covered as well.
+ */
+class DOSBoxRenderer : public Renderer {
+public:
+	DOSBoxRenderer() : _type(Config::kOpl2), _opl(0) {}
+	~DOSBoxRenderer() { delete _opl; }
+
+	const char *getName() const { return "db"; }
+
+	bool init(Config::OplType type, uint32 rate) {
+		delete _opl;
+		_opl = 0;
+		_type = type;
+
+		// The driver needs OSystem for its mutex and mixer handle
+		if (!g_system || !g_system->getMixer())
+			return false;
+
+		_opl = new LogRateOPL(type, rate);
+		if (!_opl->init())
+			return false;
+
+		// readBuffer needs a running tick clock. No callback is installed,
+		// so the ticks themselves do nothing.
+		_opl->setCallbackFrequency(kTimerFrequency);
+		return true;
+	}
+
+	void writeReg(int r, int v) {
+		if (_type == Config::kDualOpl2) {
+			// writeReg addresses both chips in dual OPL2 mode, so use the
+			// dedicated ports of each chip like the drivers do
+			const int port = 0x220 | (((r >> 8) & 1) << 1);
+			_opl->write(port, r & 0xff);
+			_opl->write(port + 1, v);
+		} else {
+			_opl->writeReg(r, v);
+		}
+	}
+
+	void generate(int16 *buffer, int numSamples) {
+		_opl->readBuffer(buffer, numSamples);
+	}
+
+private:
+	enum {
+		kTimerFrequency = 50
+	};
+
+	/**
+	 * Runs the driver at the rate of the register log instead of the
+	 * output rate of the mixer.
+	 */
+	class LogRateOPL : public DOSBox::OPL {
+	public:
+		LogRateOPL(Config::OplType type, uint32 rate) : DOSBox::OPL(type), _logRate(rate) {}
+
+		int getRate() const { return _logRate; }
+
+	private:
+		const uint32 _logRate;
+	};
+
+	Config::OplType _type;
+	LogRateOPL *_opl;
+};
+#endif
+
+class MAMERenderer : public Renderer {
+public:
+	MAMERenderer() : _opl(0) {}
+	~MAMERenderer() { MAME::OPLDestroy(_opl); }
+
+	const char *getName() const { return "mame"; }
+
+	bool init(Config::OplType type, uint32 rate) {
+		MAME::OPLDestroy(_opl);
+		_opl = 0;
+
+		// The MAME core only emulates a single OPL2 and seeds its noise
+		// generator through OSystem.
+		if (type != Config::kOpl2 || !g_system)
+			return false;
+
+		_opl = MAME::makeAdLibOPL(rate);
+		return _opl != 0;
+	}
+
+	void writeReg(int r, int v) {
+		MAME::OPLWriteReg(_opl, r & 0xff, v);
+	}
+
+	void generate(int16 *buffer, int numSamples) {
+		MAME::YM3812UpdateOne(_opl, buffer, numSamples);
+	}
+
+private:
+	MAME::FM_OPL *_opl;
+};
+
+} // End of anonymous namespace
+
+Renderer *createRenderer(const Common::String &name) {
+	if (name.equalsIgnoreCase("reference"))
+		return new ReferenceRenderer();
+#ifndef DISABLE_DOSBOX_OPL
+	if (name.equalsIgnoreCase("db"))
+		return new DOSBoxRenderer();
+#endif
+	if (name.equalsIgnoreCase("mame"))
+		return new MAMERenderer();
+	return 0;
+}
+
+bool render(const RegisterLog &log, Renderer &renderer, Common::Array<int16> &output) {
+	if (!renderer.init(log.getType(), log.getRate()))
+		return false;
+
+	const uint channels = (log.getType() == Config::kOpl2) ? 1 : 2;
+	output.resize(log.getLength() * channels);
+
+	const Common::Array<RegisterWrite> &writes = log.getWrites();
+	uint32 pos = 0;
+	for (uint i = 0; i <= writes.size(); ++i) {
+		const uint32 next = (i < writes.size()) ? writes[i].sample : log.getLength();
+		if (next > pos) {
+			renderer.generate(&output[pos * channels], (next - pos) * channels);
+			pos = next;
+		}
+
+		if (i < writes.size())
+			renderer.writeReg(writes[i].reg, writes[i].value);
+	}
+
+	return true;
+}
+
+void compare(const Common::Array<int16> &reference, const Common::Array<int16> &candidate, uint channels,
+             uint32 blockSize, int maxLag, Report &report) {
+	assert(channels > 0 && blockSize > 0);
+
+	const uint32 frames = MIN(reference.size(), candidate.size()) / channels;
+
+	report.blocks.clear();
+	report.peakError = 0;
+
+	double totalError = 0.0;
+	double totalLevel = 0.0;
+
+	for (uint32 start = 0; start < frames; start += blockSize) {
+		const uint32 end = MIN(start + blockSize, frames);
+
+		BlockStats block;
+		block.start = start;
+		block.peakError = 0;
+
+		double blockError = 0.0;
+		for (uint32 i = start * channels; i < end * channels; ++i) {
+			const int diff = (int)candidate[i] - (int)reference[i];
+			blockError += (double)diff * diff;
+			totalLevel += (double)reference[i] * reference[i];
+			block.peakError = MAX(block.peakError, ABS(diff));
+		}
+
+		block.rmsError = sqrt(blockError / ((end - start) * channels));
+		report.peakError = MAX(report.peakError, block.peakError);
+		totalError += blockError;
+		report.blocks.push_back(block);
+	}
+
+	const uint32 count = frames * channels;
+	report.rmsError = count ? sqrt(totalError / count) : 0.0;
+	report.referenceRms = count ? sqrt(totalLevel / count) : 0.0;
+
+	// Find the lag which minimizes the mean squared error of the overlap
+	report.timingOffset = 0;
+	double bestError = -1.0;
+	for (int lag = -maxLag; lag <= maxLag; ++lag) {
+		const uint32 absLag = ABS(lag);
+		if (absLag >= frames)
+			continue;
+
+		double error = 0.0;
+		for (uint32 i = 0; i < (frames - absLag) * channels; ++i) {
+			const int ref = reference[(lag < 0) ? i + absLag * channels : i];
+			const int cand = candidate[(lag < 0) ? i : i + absLag * channels];
+			error += (double)(cand - ref) * (cand - ref);
+		}
+		error /= (frames - absLag) * channels;
+
+		// Prefer the smallest lag on ties
+		if (bestError < 0.0 || error < bestError || (error == bestError && absLag < (uint32)ABS(report.timingOffset))) {
+			bestError = error;
+			report.timingOffset = lag;
+		}
+	}
+}
+
+bool run(const RegisterLog &log, const Common::Array<Common::String> &emulators, uint32 blockSize,
+         Common::Array<Report> &reports) {
+	reports.clear();
+
+	Common::Array<int16> reference;
+	Renderer *referenceRenderer = createRenderer("reference");
+	const bool success = render(log, *referenceRenderer, reference);
+	delete referenceRenderer;
+
+	if (!success)
+		return false;
+
+	const uint channels = (log.getType() == Config::kOpl2) ? 1 : 2;
+
+	for (uint i = 0; i < emulators.size(); ++i) {
+		Renderer *renderer = createRenderer(emulators[i]);
+		if (!renderer) {
+			warning("OPL harness: unknown emulator \"%s\"", emulators[i].c_str());
+			continue;
+		}
+
+		Common::Array<int16> candidate;
+		if (render(log, *renderer, candidate)) {
+			Report report;
+			report.name = renderer->getName();
+			// Search up to 2ms for timing divergence
+			compare(reference, candidate, channels, blockSize, log.getRate() / 500, report);
+			reports.push_back(report);
+		} else {
+			warning("OPL harness: emulator \"%s\" does not support OPL type %d", emulators[i].c_str(), log.getType());
+		}
+
+		delete renderer;
+	}
+
+	return true;
+}
+
+void printReport(const Report &report, bool perBlock) {
+	debug("%s: rms error %.2f (reference level %.2f), peak error %d, timing offset %d",
+	      report.name.c_str(), report.rmsError, report.referenceRms, report.peakError, report.timingOffset);
+
+	if (!perBlock)
+		return;
+
+	for (uint i = 0; i < report.blocks.size(); ++i) {
+		const BlockStats &block = report.blocks[i];
+		debug("  %8u: rms error %8.2f, peak error %5d", block.start, block.rmsError, block.peakError);
+	}
+}
+
+} // End of namespace Harness
+} // End of namespace OPL
@@ -0,0 +1,182 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_SOFTSYNTH_OPL_HARNESS_H
+#define AUDIO_SOFTSYNTH_OPL_HARNESS_H
+
+#include "audio/fmopl.h"
+
+#include "common/array.h"
+#include "common/str.h"
+
+namespace Common {
+class SeekableReadStream;
+}
+
+namespace OPL {
+
+/**
+ * Differential test harness for the OPL emulators.
+ *
+ * A register log is played back through the reference emulator and one or
+ * more of the fast emulators, all running on the same sample clock, and the
+ * resulting output is compared block by block. The reference emulator runs
+ * without OSystem, the DOSBox and MAME renderers need g_system to be set.
+ */
+namespace Harness {
+
+/**
+ * A single register write of a register log.
+ */
+struct RegisterWrite {
+	uint32 sample;	///< output sample (frame) at which the write happens
+	uint16 reg;		///< register, >= 0x100 for the second bank or chip
+	uint8 value;
+};
+
+/**
+ * A timed sequence of OPL register writes.
+ */
+class RegisterLog {
+public:
+	RegisterLog(Config::OplType type = Config::kOpl2, uint32 rate = 44100);
+
+	Config::OplType getType() const { return _type; }
+	uint32 getRate() const { return _rate; }
+
+	/**
+	 * Appends a register write. Writes must be added in chronological order.
+	 */
+	void addWrite(uint32 sample, uint16 reg, uint8 value);
+
+	/**
+	 * Makes sure the log plays for at least the given number of frames.
+	 */
+	void extend(uint32 samples);
+
+	/** Length of the log in frames */
+	uint32 getLength() const { return _length; }
+
+	const Common::Array<RegisterWrite> &getWrites() const { return _writes; }
+
+	void clear();
+
+	/**
+	 * Loads a DOSBox raw OPL capture (version 2.0). The log type is taken
+	 * from the hardware type of the capture, timestamps are converted to
+	 * the rate of this log.
+	 *
+	 * @return true on success, false if the stream is not a supported DRO
+	 */
+	bool loadDRO(Common::SeekableReadStream &stream);
+
+private:
+	Config::OplType _type;
+	uint32 _rate;
+	uint32 _length;
+	Common::Array<RegisterWrite> _writes;
+};
+
+/**
+ * Minimal interface to drive a single emulator core.
+ */
+class Renderer {
+public:
+	virtual ~Renderer() {}
+
+	virtual const char *getName() const = 0;
+
+	/**
+	 * (Re)initializes the core.
+	 *
+	 * @return false when the core does not support the requested type
+	 */
+	virtual bool init(Config::OplType type, uint32 rate) = 0;
+
+	virtual void writeReg(int r, int v) = 0;
+
+	/**
+	 * Generates samples, interleaved for stereo types. The sample count
+	 * includes both channels for stereo types.
+	 */
+	virtual void generate(int16 *buffer, int numSamples) = 0;
+};
+
+/**
+ * Creates a renderer for the emulator with the given driver name as used by
+ * Config::parse, i.e. "reference", "db" or "mame".
+ *
+ * @return the renderer, or 0 if the emulator is not available
+ */
+Renderer *createRenderer(const Common::String &name);
+
+/**
+ * Renders a register log through the given renderer.
+ *
+ * @return false if the renderer does not support the log type
+ */
+bool render(const RegisterLog &log, Renderer &renderer, Common::Array<int16> &output);
+
+struct BlockStats {
+	uint32 start;		///< first frame of the block
+	double rmsError;
+	int peakError;
+};
+
+struct Report {
+	Common::String name;
+	double referenceRms;	///< RMS level of the reference output
+	double rmsError;		///< RMS error over the complete log
+	int peakError;			///< largest absolute sample error
+	int timingOffset;		///< lag in frames which best aligns the candidate to the reference
+	Common::Array<BlockStats> blocks;
+};
+
+/**
+ * Compares a candidate output against the reference output.
+ *
+ * Errors are computed without any alignment, so a constant delay of one of
+ * the cores shows up as error. The timing offset is the lag within +/-
+ * maxLag frames which minimizes the squared error and is reported
+ * separately.
+ */
+void compare(const Common::Array<int16> &reference, const Common::Array<int16> &candidate, uint channels,
+             uint32 blockSize, int maxLag, Report &report);
+
+/**
+ * Plays a register log through the reference emulator and each of the
+ * given emulators and compares their output.
+ *
+ * @return false if the reference emulator could not render the log
+ */
+bool run(const RegisterLog &log, const Common::Array<Common::String> &emulators, uint32 blockSize,
+         Common::Array<Report> &reports);
+
+/**
+ * Writes a report in human readable form to the debug output.
+ */
+void printReport(const Report &report, bool perBlock);
+
+} // End of namespace Harness
+} // End of namespace OPL
+
+#endif
@@ -69,6 +69,8 @@ void OPL::reset() {
 }
 
 void OPL::write(int a, int v) {
+	if (a & 1)
+		countWrite();
 	MAME::OPLWrite(_opl, a, v);
 }
 
@@ -77,6 +79,7 @@ byte OPL::read(int a) {
 }
 
 void OPL::writeReg(int r, int v) {
+	countWrite();
 	MAME::OPLWriteReg(_opl, r, v);
 }
 
@@ -0,0 +1,1144 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Based on the Nuked OPL3 emulator
+ * Copyright (C) 2013-2020 Nuke.YKT
+ * Licensed under LGPLv2.1+
+ * https://github.com/nukeykt/Nuked-OPL3
+ */
+
+#include "audio/softsynth/opl/reference.h"
+
+#include "audio/mixer.h"
+#include "common/system.h"
+#include "common/util.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace OPL {
+namespace Reference {
+
+namespace {
+
+enum EnvelopeGen {
+	kEnvAttack = 0,
+	kEnvDecay = 1,
+	kEnvSustain = 2,
+	kEnvRelease = 3
+};
+
+enum KeyType {
+	kKeyNorm = 0x01,
+	kKeyDrum = 0x02
+};
+
+enum ChannelType {
+	kCh2Op = 0,
+	kCh4Op = 1,
+	kCh4Op2 = 2,
+	kChDrum = 3
+};
+
+// Log-sin and exponent ROM contents. These are generated from the formulas
+// recovered from the die shots, which reproduce the ROMs exactly.
+uint16 logSinRom[256];
+uint16 expRom[256];
+bool tablesInitialized = false;
+
+void initTables() {
+	if (tablesInitialized)
+		return;
+
+	for (int i = 0; i < 256; ++i) {
+		const double s = sin((i + 0.5) * M_PI / 512.0);
+		logSinRom[i] = (uint16)floor(-log(s) / log(2.0) * 256.0 + 0.5);
+		expRom[i] = 0x400 + (uint16)floor((pow(2.0, (255 - i) / 256.0) - 1.0) * 1024.0 + 0.5);
+	}
+
+	tablesInitialized = true;
+}
+
+const uint8 kslRom[16] = {
+	0, 32, 40, 45, 48, 51, 53, 55, 56, 58, 59, 60, 61, 62, 63, 64
+};
+
+// Frequency multipliers, times two
+const uint8 multTable[16] = {
+	1, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 20, 24, 24, 30, 30
+};
+
+const uint8 kslShift[4] = {
+	8, 1, 2, 0
+};
+
+const uint8 egIncStep[4][4] = {
+	{ 0, 0, 0, 0 },
+	{ 1, 0, 0, 0 },
+	{ 1, 0, 1, 0 },
+	{ 1, 1, 1, 0 }
+};
+
+// Register offset (0x20..0x35 etc.) to slot number within one register bank
+const int8 regToSlot[0x20] = {
+	 0,  1,  2,  3,  4,  5, -1, -1,  6,  7,  8,  9, 10, 11, -1, -1,
+	12, 13, 14, 15, 16, 17, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+// First slot of every channel
+const uint8 channelSlot[18] = {
+	0, 1, 2, 6, 7, 8, 12, 13, 14, 18, 19, 20, 24, 25, 26, 30, 31, 32
+};
+
+inline int16 calcExp(uint32 level) {
+	if (level > 0x1fff)
+		level = 0x1fff;
+	return (expRom[level & 0xff] << 1) >> (level >> 8);
+}
+
+int16 calcWave(uint8 waveform, uint16 phase, uint16 envelope) {
+	uint16 out = 0;
+	uint16 neg = 0;
+
+	phase &= 0x3ff;
+
+	switch (waveform) {
+	case 0:
+		if (phase & 0x200)
+			neg = 0xffff;
+		if (phase & 0x100)
+			out = logSinRom[(phase & 0xff) ^ 0xff];
+		else
+			out = logSinRom[phase & 0xff];
+		break;
+
+	case 1:
+		if (phase & 0x200)
+			out = 0x1000;
+		else if (phase & 0x100)
+			out = logSinRom[(phase & 0xff) ^ 0xff];
+		else
+			out = logSinRom[phase & 0xff];
+		break;
+
+	case 2:
+		if (phase & 0x100)
+			out = logSinRom[(phase & 0xff) ^ 0xff];
+		else
+			out = logSinRom[phase & 0xff];
+		break;
+
+	case 3:
+		if (phase & 0x100)
+			out = 0x1000;
+		else
+			out = logSinRom[phase & 0xff];
+		break;
+
+	case 4:
+		if ((phase & 0x300) == 0x100)
+			neg = 0xffff;
+		if (phase & 0x200)
+			out = 0x1000;
+		else if (phase & 0x80)
+			out = logSinRom[((phase ^ 0xff) << 1) & 0xff];
+		else
+			out = logSinRom[(phase << 1) & 0xff];
+		break;
+
+	case 5:
+		if (phase & 0x200)
+			out = 0x1000;
+		else if (phase & 0x80)
+			out = logSinRom[((phase ^ 0xff) << 1) & 0xff];
+		else
+			out = logSinRom[(phase << 1) & 0xff];
+		break;
+
+	case 6:
+		if (phase & 0x200)
+			neg = 0xffff;
+		out = 0;
+		break;
+
+	case 7:
+	default:
+		if (phase & 0x200) {
+			neg = 0xffff;
+			phase = (phase & 0x1ff) ^ 0x1ff;
+		}
+		out = phase << 3;
+		break;
+	}
+
+	return calcExp(out + (envelope << 3)) ^ neg;
+}
+
+inline int16 clipSample(int32 sample) {
+	return (int16)CLIP<int32>(sample, -32768, 32767);
+}
+
+} // End of anonymous namespace
+
+// Slot
+
+void Slot::write20(uint8 val) {
+	if (val & 0x80)
+		trem = &chip->tremolo;
+	else
+		trem = (uint8 *)&chip->zeroMod;
+	regVib = (val >> 6) & 0x01;
+	regType = (val >> 5) & 0x01;
+	regKsr = (val >> 4) & 0x01;
+	regMult = val & 0x0f;
+}
+
+void Slot::write40(uint8 val) {
+	regKsl = (val >> 6) & 0x03;
+	regTl = val & 0x3f;
+	updateKsl();
+}
+
+void Slot::write60(uint8 val) {
+	regAr = (val >> 4) & 0x0f;
+	regDr = val & 0x0f;
+}
+
+void Slot::write80(uint8 val) {
+	regSl = (val >> 4) & 0x0f;
+	if (regSl == 0x0f)
+		regSl = 0x1f;
+	regRr = val & 0x0f;
+}
+
+void Slot::writeE0(uint8 val) {
+	regWf = val & 0x07;
+	if (!chip->newm)
+		regWf &= 0x03;
+}
+
+void Slot::updateKsl() {
+	int16 ksl = (kslRom[channel->fNum >> 6] << 2) - ((0x08 - channel->block) << 5);
+	if (ksl < 0)
+		ksl = 0;
+	egKsl = (uint8)ksl;
+}
+
+void Slot::keyOn(uint8 type) {
+	key |= type;
+}
+
+void Slot::keyOff(uint8 type) {
+	key &= ~type;
+}
+
+void Slot::calcFeedback() {
+	if (channel->fb != 0x00)
+		fbmod = (prout + out) >> (0x09 - channel->fb);
+	else
+		fbmod = 0;
+	prout = out;
+}
+
+void Slot::calcEnvelope() {
+	uint8 regRate = 0;
+	bool reset = false;
+
+	egOut = egRout + (regTl << 2) + (egKsl >> kslShift[regKsl]) + *trem;
+	if (egOut > 0x1ff)
+		egOut = 0x1ff;
+
+	if (key && egGen == kEnvRelease) {
+		reset = true;
+		regRate = regAr;
+	} else {
+		switch (egGen) {
+		case kEnvAttack:
+			regRate = regAr;
+			break;
+		case kEnvDecay:
+			regRate = regDr;
+			break;
+		case kEnvSustain:
+			if (!regType)
+				regRate = regRr;
+			break;
+		case kEnvRelease:
+			regRate = regRr;
+			break;
+		}
+	}
+
+	pgReset = reset;
+
+	const uint8 ks = channel->ksv >> ((regKsr ^ 1) << 1);
+	const bool nonZero = (regRate != 0);
+	const uint8 rate = ks + (regRate << 2);
+	uint8 rateHi = rate >> 2;
+	const uint8 rateLo = rate & 0x03;
+	if (rateHi & 0x10)
+		rateHi = 0x0f;
+
+	const uint8 egShift = rateHi + chip->egAdd;
+	uint8 shift = 0;
+
+	if (nonZero) {
+		if (rateHi < 12) {
+			if (chip->egState) {
+				switch (egShift) {
+				case 12:
+					shift = 1;
+					break;
+				case 13:
+					shift = (rateLo >> 1) & 0x01;
+					break;
+				case 14:
+					shift = rateLo & 0x01;
+					break;
+				default:
+					break;
+				}
+			}
+		} else {
+			shift = (rateHi & 0x03) + egIncStep[rateLo][chip->timer & 0x03];
+			if (shift & 0x04)
+				shift = 0x03;
+			if (!shift)
+				shift = chip->egState;
+		}
+	}
+
+	uint16 newRout = egRout;
+	int16 egInc = 0;
+	bool egOff = false;
+
+	// Instant attack
+	if (reset && rateHi == 0x0f)
+		newRout = 0x00;
+
+	// Envelope off
+	if ((egRout & 0x1f8) == 0x1f8)
+		egOff = true;
+	if (egGen != kEnvAttack && !reset && egOff)
+		newRout = 0x1ff;
+
+	switch (egGen) {
+	case kEnvAttack:
+		if (!egRout)
+			egGen = kEnvDecay;
+		else if (key && shift > 0 && rateHi != 0x0f)
+			egInc = ~egRout >> (4 - shift);
+		break;
+	case kEnvDecay:
+		if ((egRout >> 4) == regSl)
+			egGen = kEnvSustain;
+		else if (!egOff && !reset && shift > 0)
+			egInc = 1 << (shift - 1);
+		break;
+	case kEnvSustain:
+	case kEnvRelease:
+		if (!egOff && !reset && shift > 0)
+			egInc = 1 << (shift - 1);
+		break;
+	}
+
+	egRout = (newRout + egInc) & 0x1ff;
+
+	if (reset)
+		egGen = kEnvAttack;
+	if (!key)
+		egGen = kEnvRelease;
+}
+
+void Slot::generatePhase() {
+	uint16 f = channel->fNum;
+
+	if (regVib) {
+		int8 range = (f >> 7) & 7;
+		const uint8 vibPos = chip->vibPos;
+
+		if (!(vibPos & 3))
+			range = 0;
+		else if (vibPos & 1)
+			range >>= 1;
+		range >>= chip->vibShift;
+
+		if (vibPos & 4)
+			range = -range;
+		f += range;
+	}
+
+	const uint32 baseFreq = (f << channel->block) >> 1;
+	const uint16 phase = (uint16)(pgPhase >> 9);
+	if (pgReset)
+		pgPhase = 0;
+	pgPhase += (baseFreq * multTable[regMult]) >> 1;
+
+	// Rhythm mode
+	const uint32 noise = chip->noise;
+	pgPhaseOut = phase;
+	if (slotNum == 13) { // hh
+		chip->rmHhBit2 = (phase >> 2) & 1;
+		chip->rmHhBit3 = (phase >> 3) & 1;
+		chip->rmHhBit7 = (phase >> 7) & 1;
+		chip->rmHhBit8 = (phase >> 8) & 1;
+	}
+	if (slotNum == 17 && (chip->rhy & 0x20)) { // tc
+		chip->rmTcBit3 = (phase >> 3) & 1;
+		chip->rmTcBit5 = (phase >> 5) & 1;
+	}
+	if (chip->rhy & 0x20) {
+		const uint8 rmXor = (chip->rmHhBit2 ^ chip->rmHhBit7)
+		                  | (chip->rmHhBit3 ^ chip->rmTcBit5)
+		                  | (chip->rmTcBit3 ^ chip->rmTcBit5);
+		switch (slotNum) {
+		case 13: // hh
+			pgPhaseOut = rmXor << 9;
+			if (rmXor ^ (noise & 1))
+				pgPhaseOut |= 0xd0;
+			else
+				pgPhaseOut |= 0x34;
+			break;
+		case 16: // sd
+			pgPhaseOut = (chip->rmHhBit8 << 9) | ((chip->rmHhBit8 ^ (noise & 1)) << 8);
+			break;
+		case 17: // tc
+			pgPhaseOut = (rmXor << 9) | 0x80;
+			break;
+		default:
+			break;
+		}
+	}
+
+	// The noise LFSR is clocked once per slot cycle
+	const uint32 nBit = ((noise >> 14) ^ noise) & 0x01;
+	chip->noise = (noise >> 1) | (nBit << 22);
+}
+
+void Slot::generate() {
+	uint8 waveform = regWf;
+	if (chip->opl2 && !chip->waveSelect)
+		waveform = 0;
+	out = calcWave(waveform, pgPhaseOut + *mod, egOut);
+}
+
+// Channel
+
+void Channel::writeA0(uint8 val) {
+	if (chip->newm && chType == kCh4Op2)
+		return;
+
+	fNum = (fNum & 0x300) | val;
+	ksv = (block << 1) | ((fNum >> (0x09 - chip->nts)) & 0x01);
+	slots[0]->updateKsl();
+	slots[1]->updateKsl();
+
+	if (chip->newm && chType == kCh4Op) {
+		pair->fNum = fNum;
+		pair->ksv = ksv;
+		pair->slots[0]->updateKsl();
+		pair->slots[1]->updateKsl();
+	}
+}
+
+void Channel::writeB0(uint8 val) {
+	if (chip->newm && chType == kCh4Op2)
+		return;
+
+	fNum = (fNum & 0xff) | ((val & 0x03) << 8);
+	block = (val >> 2) & 0x07;
+	ksv = (block << 1) | ((fNum >> (0x09 - chip->nts)) & 0x01);
+	slots[0]->updateKsl();
+	slots[1]->updateKsl();
+
+	if (chip->newm && chType == kCh4Op) {
+		pair->fNum = fNum;
+		pair->block = block;
+		pair->ksv = ksv;
+		pair->slots[0]->updateKsl();
+		pair->slots[1]->updateKsl();
+	}
+}
+
+void Channel::setupAlg() {
+	int16 *zero = &chip->zeroMod;
+
+	if (chType == kChDrum) {
+		if (chNum == 7 || chNum == 8) {
+			slots[0]->mod = zero;
+			slots[1]->mod = zero;
+			return;
+		}
+
+		if (alg & 0x01) {
+			slots[0]->mod = &slots[0]->fbmod;
+			slots[1]->mod = zero;
+		} else {
+			slots[0]->mod = &slots[0]->fbmod;
+			slots[1]->mod = &slots[0]->out;
+		}
+		return;
+	}
+
+	if (alg & 0x08)
+		return;
+
+	if (alg & 0x04) {
+		pair->out[0] = zero;
+		pair->out[1] = zero;
+		pair->out[2] = zero;
+		pair->out[3] = zero;
+
+		switch (alg & 0x03) {
+		case 0x00:
+			pair->slots[0]->mod = &pair->slots[0]->fbmod;
+			pair->slots[1]->mod = &pair->slots[0]->out;
+			slots[0]->mod = &pair->slots[1]->out;
+			slots[1]->mod = &slots[0]->out;
+			out[0] = &slots[1]->out;
+			out[1] = zero;
+			out[2] = zero;
+			out[3] = zero;
+			break;
+		case 0x01:
+			pair->slots[0]->mod = &pair->slots[0]->fbmod;
+			pair->slots[1]->mod = &pair->slots[0]->out;
+			slots[0]->mod = zero;
+			slots[1]->mod = &slots[0]->out;
+			out[0] = &pair->slots[1]->out;
+			out[1] = &slots[1]->out;
+			out[2] = zero;
+			out[3] = zero;
+			break;
+		case 0x02:
+			pair->slots[0]->mod = &pair->slots[0]->fbmod;
+			pair->slots[1]->mod = zero;
+			slots[0]->mod = &pair->slots[1]->out;
+			slots[1]->mod = &slots[0]->out;
+			out[0] = &pair->slots[0]->out;
+			out[1] = &slots[1]->out;
+			out[2] = zero;
+			out[3] = zero;
+			break;
+		case 0x03:
+			pair->slots[0]->mod = &pair->slots[0]->fbmod;
+			pair->slots[1]->mod = zero;
+			slots[0]->mod = &pair->slots[1]->out;
+			slots[1]->mod = zero;
+			out[0] = &pair->slots[0]->out;
+			out[1] = &slots[0]->out;
+			out[2] = &slots[1]->out;
+			out[3] = zero;
+			break;
+		}
+	} else {
+		if (alg & 0x01) {
+			slots[0]->mod = &slots[0]->fbmod;
+			slots[1]->mod = zero;
+			out[0] = &slots[0]->out;
+			out[1] = &slots[1]->out;
+			out[2] = zero;
+			out[3] = zero;
+		} else {
+			slots[0]->mod = &slots[0]->fbmod;
+			slots[1]->mod = &slots[0]->out;
+			out[0] = &slots[1]->out;
+			out[1] = zero;
+			out[2] = zero;
+			out[3] = zero;
+		}
+	}
+}
+
+void Channel::updateAlg() {
+	alg = con;
+
+	if (chip->newm) {
+		if (chType == kCh4Op) {
+			pair->alg = 0x04 | (con << 1) | pair->con;
+			alg = 0x08;
+			pair->setupAlg();
+		} else if (chType == kCh4Op2) {
+			alg = 0x04 | (pair->con << 1) | con;
+			pair->alg = 0x08;
+			setupAlg();
+		} else {
+			setupAlg();
+		}
+	} else {
+		setupAlg();
+	}
+}
+
+void Channel::writeC0(uint8 val) {
+	fb = (val & 0x0e) >> 1;
+	con = val & 0x01;
+	updateAlg();
+
+	if (chip->newm) {
+		cha = ((val >> 4) & 0x01) ? 0xffff : 0;
+		chb = ((val >> 5) & 0x01) ? 0xffff : 0;
+	} else {
+		cha = chb = 0xffff;
+	}
+}
+
+void Channel::keyOn() {
+	if (chip->newm) {
+		if (chType == kCh4Op) {
+			slots[0]->keyOn(kKeyNorm);
+			slots[1]->keyOn(kKeyNorm);
+			pair->slots[0]->keyOn(kKeyNorm);
+			pair->slots[1]->keyOn(kKeyNorm);
+		} else if (chType == kCh2Op || chType == kChDrum) {
+			slots[0]->keyOn(kKeyNorm);
+			slots[1]->keyOn(kKeyNorm);
+		}
+	} else {
+		slots[0]->keyOn(kKeyNorm);
+		slots[1]->keyOn(kKeyNorm);
+	}
+}
+
+void Channel::keyOff() {
+	if (chip->newm) {
+		if (chType == kCh4Op) {
+			slots[0]->keyOff(kKeyNorm);
+			slots[1]->keyOff(kKeyNorm);
+			pair->slots[0]->keyOff(kKeyNorm);
+			pair->slots[1]->keyOff(kKeyNorm);
+		} else if (chType == kCh2Op || chType == kChDrum) {
+			slots[0]->keyOff(kKeyNorm);
+			slots[1]->keyOff(kKeyNorm);
+		}
+	} else {
+		slots[0]->keyOff(kKeyNorm);
+		slots[1]->keyOff(kKeyNorm);
+	}
+}
+
+// Chip
+
+void Chip::reset(uint32 rate, bool isOpl2) {
+	initTables();
+
+	memset(this, 0, sizeof(Chip));
+
+	for (int i = 0; i < 36; ++i) {
+		Slot &s = slot[i];
+		s.chip = this;
+		s.mod = &zeroMod;
+		s.egRout = 0x1ff;
+		s.egOut = 0x1ff;
+		s.egGen = kEnvRelease;
+		s.trem = (uint8 *)&zeroMod;
+		s.slotNum = i;
+	}
+
+	for (int i = 0; i < 18; ++i) {
+		Channel &c = channel[i];
+		const uint8 first = channelSlot[i];
+		c.slots[0] = &slot[first];
+		c.slots[1] = &slot[first + 3];
+		slot[first].channel = &c;
+		slot[first + 3].channel = &c;
+
+		if ((i % 9) < 3)
+			c.pair = &channel[i + 3];
+		else if ((i % 9) < 6)
+			c.pair = &channel[i - 3];
+
+		c.chip = this;
+		c.out[0] = c.out[1] = c.out[2] = c.out[3] = &zeroMod;
+		c.chType = kCh2Op;
+		c.cha = 0xffff;
+		c.chb = 0xffff;
+		c.chNum = i;
+		c.setupAlg();
+	}
+
+	noise = 1;
+	rateRatio = (rate << kResampleFrac) / kChipRate;
+	tremoloShift = 4;
+	vibShift = 1;
+	opl2 = isOpl2;
+}
+
+void Chip::updateRhythm(uint8 val) {
+	rhy = val & 0x3f;
+
+	if (rhy & 0x20) {
+		Channel &ch6 = channel[6];
+		Channel &ch7 = channel[7];
+		Channel &ch8 = channel[8];
+
+		ch6.out[0] = &ch6.slots[1]->out;
+		ch6.out[1] = &ch6.slots[1]->out;
+		ch6.out[2] = &zeroMod;
+		ch6.out[3] = &zeroMod;
+		ch7.out[0] = &ch7.slots[0]->out;
+		ch7.out[1] = &ch7.slots[0]->out;
+		ch7.out[2] = &ch7.slots[1]->out;
+		ch7.out[3] = &ch7.slots[1]->out;
+		ch8.out[0] = &ch8.slots[0]->out;
+		ch8.out[1] = &ch8.slots[0]->out;
+		ch8.out[2] = &ch8.slots[1]->out;
+		ch8.out[3] = &ch8.slots[1]->out;
+
+		for (int i = 6; i < 9; ++i)
+			channel[i].chType = kChDrum;
+
+		ch6.setupAlg();
+		ch7.setupAlg();
+		ch8.setupAlg();
+
+		// hh
+		if (rhy & 0x01)
+			ch7.slots[0]->keyOn(kKeyDrum);
+		else
+			ch7.slots[0]->keyOff(kKeyDrum);
+
+		// tc
+		if (rhy & 0x02)
+			ch8.slots[1]->keyOn(kKeyDrum);
+		else
+			ch8.slots[1]->keyOff(kKeyDrum);
+
+		// tom
+		if (rhy & 0x04)
+			ch8.slots[0]->keyOn(kKeyDrum);
+		else
+			ch8.slots[0]->keyOff(kKeyDrum);
+
+		// sd
+		if (rhy & 0x08)
+			ch7.slots[1]->keyOn(kKeyDrum);
+		else
+			ch7.slots[1]->keyOff(kKeyDrum);
+
+		// bd
+		if (rhy & 0x10) {
+			ch6.slots[0]->keyOn(kKeyDrum);
+			ch6.slots[1]->keyOn(kKeyDrum);
+		} else {
+			ch6.slots[0]->keyOff(kKeyDrum);
+			ch6.slots[1]->keyOff(kKeyDrum);
+		}
+	} else {
+		for (int i = 6; i < 9; ++i) {
+			channel[i].chType = kCh2Op;
+			channel[i].setupAlg();
+			channel[i].slots[0]->keyOff(kKeyDrum);
+			channel[i].slots[1]->keyOff(kKeyDrum);
+		}
+	}
+}
+
+void Chip::set4Op(uint8 val) {
+	for (int bit = 0; bit < 6; ++bit) {
+		int chNum = bit;
+		if (bit >= 3)
+			chNum += 9 - 3;
+
+		if ((val >> bit) & 0x01) {
+			channel[chNum].chType = kCh4Op;
+			channel[chNum + 3].chType = kCh4Op2;
+			channel[chNum].updateAlg();
+		} else {
+			channel[chNum].chType = kCh2Op;
+			channel[chNum + 3].chType = kCh2Op;
+			channel[chNum].updateAlg();
+			channel[chNum + 3].updateAlg();
+		}
+	}
+}
+
+void Chip::writeTimerControl(uint8 val) {
+	if (val & 0x80) {
+		// IRQ reset, all other bits are ignored
+		status = 0;
+		return;
+	}
+
+	timerMasked[0] = (val & 0x40) != 0;
+	timerMasked[1] = (val & 0x20) != 0;
+
+	// Masking a timer also clears its overflow flag
+	if (timerMasked[0])
+		status &= ~0x40;
+	if (timerMasked[1])
+		status &= ~0x20;
+	if (!(status & 0x60))
+		status = 0;
+
+	for (int i = 0; i < 2; ++i) {
+		const bool start = (val & (1 << i)) != 0;
+		if (start && !timerEnabled[i])
+			timerCounter[i] = timerReload[i];
+		timerEnabled[i] = start;
+	}
+}
+
+void Chip::clockTimers() {
+	// Timer 1 runs at 80 usec resolution, i.e. once every 4 chip cycles,
+	// timer 2 at 320 usec, i.e. once every 16 chip cycles.
+	++timerCycles;
+
+	for (int i = 0; i < 2; ++i) {
+		const uint32 period = i ? 16 : 4;
+		if (!timerEnabled[i] || (timerCycles % period))
+			continue;
+
+		if (++timerCounter[i] == 0) {
+			timerCounter[i] = timerReload[i];
+			if (!timerMasked[i])
+				status |= 0x80 | (i ? 0x20 : 0x40);
+		}
+	}
+}
+
+void Chip::writeReg(uint16 reg, uint8 val) {
+	const uint8 high = (reg >> 8) & 0x01;
+	const uint8 regm = reg & 0xff;
+
+	switch (regm & 0xf0) {
+	case 0x00:
+		if (high) {
+			switch (regm & 0x0f) {
+			case 0x04:
+				set4Op(val);
+				break;
+			case 0x05:
+				if (!opl2)
+					newm = val & 0x01;
+				break;
+			}
+		} else {
+			switch (regm & 0x0f) {
+			case 0x01:
+				waveSelect = (val & 0x20) != 0;
+				break;
+			case 0x02:
+				timerReload[0] = val;
+				break;
+			case 0x03:
+				timerReload[1] = val;
+				break;
+			case 0x04:
+				writeTimerControl(val);
+				break;
+			case 0x08:
+				nts = (val >> 6) & 0x01;
+				break;
+			}
+		}
+		break;
+
+	case 0x20:
+	case 0x30:
+		if (regToSlot[regm & 0x1f] >= 0)
+			slot[18 * high + regToSlot[regm & 0x1f]].write20(val);
+		break;
+
+	case 0x40:
+	case 0x50:
+		if (regToSlot[regm & 0x1f] >= 0)
+			slot[18 * high + regToSlot[regm & 0x1f]].write40(val);
+		break;
+
+	case 0x60:
+	case 0x70:
+		if (regToSlot[regm & 0x1f] >= 0)
+			slot[18 * high + regToSlot[regm & 0x1f]].write60(val);
+		break;
+
+	case 0x80:
+	case 0x90:
+		if (regToSlot[regm & 0x1f] >= 0)
+			slot[18 * high + regToSlot[regm & 0x1f]].write80(val);
+		break;
+
+	case 0xe0:
+	case 0xf0:
+		if (regToSlot[regm & 0x1f] >= 0)
+			slot[18 * high + regToSlot[regm & 0x1f]].writeE0(val);
+		break;
+
+	case 0xa0:
+		if ((regm & 0x0f) < 9)
+			channel[9 * high + (regm & 0x0f)].writeA0(val);
+		break;
+
+	case 0xb0:
+		if (regm == 0xbd && !high) {
+			tremoloShift = (((val >> 7) ^ 1) << 1) + 2;
+			vibShift = ((val >> 6) & 0x01) ^ 1;
+			updateRhythm(val);
+		} else if ((regm & 0x0f) < 9) {
+			Channel &c = channel[9 * high + (regm & 0x0f)];
+			c.writeB0(val);
+			if (val & 0x20)
+				c.keyOn();
+			else
+				c.keyOff();
+		}
+		break;
+
+	case 0xc0:
+		if ((regm & 0x0f) < 9)
+			channel[9 * high + (regm & 0x0f)].writeC0(val);
+		break;
+	}
+}
+
+void Chip::generate(int16 *buf) {
+	// The right channel of the previous cycle is output first, since the
+	// hardware DAC latches it half a cycle later.
+	buf[1] = clipSample(mixBuff[1]);
+
+	for (int i = 0; i < 15; ++i) {
+		slot[i].calcFeedback();
+		slot[i].calcEnvelope();
+		slot[i].generatePhase();
+		slot[i].generate();
+	}
+
+	mixBuff[0] = 0;
+	for (int i = 0; i < 18; ++i) {
+		int16 **out = channel[i].out;
+		const int16 accm = *out[0] + *out[1] + *out[2] + *out[3];
+		mixBuff[0] += (int16)(accm & channel[i].cha);
+	}
+
+	for (int i = 15; i < 18; ++i) {
+		slot[i].calcFeedback();
+		slot[i].calcEnvelope();
+		slot[i].generatePhase();
+		slot[i].generate();
+	}
+
+	buf[0] = clipSample(mixBuff[0]);
+
+	for (int i = 18; i < 33; ++i) {
+		slot[i].calcFeedback();
+		slot[i].calcEnvelope();
+		slot[i].generatePhase();
+		slot[i].generate();
+	}
+
+	mixBuff[1] = 0;
+	for (int i = 0; i < 18; ++i) {
+		int16 **out = channel[i].out;
+		const int16 accm = *out[0] + *out[1] + *out[2] + *out[3];
+		mixBuff[1] += (int16)(accm & channel[i].chb);
+	}
+
+	for (int i = 33; i < 36; ++i) {
+		slot[i].calcFeedback();
+		slot[i].calcEnvelope();
+		slot[i].generatePhase();
+		slot[i].generate();
+	}
+
+	// LFOs
+	if ((timer & 0x3f) == 0x3f)
+		tremoloPos = (tremoloPos + 1) % 210;
+	if (tremoloPos < 105)
+		tremolo = tremoloPos >> tremoloShift;
+	else
+		tremolo = (210 - tremoloPos) >> tremoloShift;
+
+	if ((timer & 0x3ff) == 0x3ff)
+		vibPos = (vibPos + 1) & 7;
+
+	++timer;
+
+	// Envelope timer
+	egAdd = 0;
+	if (egTimer) {
+		uint8 shift = 0;
+		while (shift < 36 && ((egTimer >> shift) & 1) == 0)
+			++shift;
+		if (shift > 12)
+			egAdd = 0;
+		else
+			egAdd = shift + 1;
+	}
+
+	if (egTimerRem || egState) {
+		if (egTimer == 0xfffffffffULL) {
+			egTimer = 0;
+			egTimerRem = 1;
+		} else {
+			++egTimer;
+			egTimerRem = 0;
+		}
+	}
+
+	egState ^= 1;
+
+	clockTimers();
+}
+
+void Chip::generateResampled(int16 *buf) {
+	while (sampleCnt >= rateRatio) {
+		oldSamples[0] = samples[0];
+		oldSamples[1] = samples[1];
+		generate(samples);
+		sampleCnt -= rateRatio;
+	}
+
+	buf[0] = (int16)((oldSamples[0] * (rateRatio - sampleCnt) + samples[0] * sampleCnt) / rateRatio);
+	buf[1] = (int16)((oldSamples[1] * (rateRatio - sampleCnt) + samples[1] * sampleCnt) / rateRatio);
+	sampleCnt += 1 << kResampleFrac;
+}
+
+// OPL API implementation
+
+OPL::OPL(Config::OplType type) : _type(type), _chip(0) {
+	_address[0] = _address[1] = 0;
+}
+
+OPL::~OPL() {
+	stop();
+	delete[] _chip;
+	_chip = 0;
+}
+
+bool OPL::init() {
+	delete[] _chip;
+
+	// Dual OPL2 is modelled as two independent YM3812 chips, hard panned
+	// to the left and right output.
+	const int chips = (_type == Config::kDualOpl2) ? 2 : 1;
+	_chip = new Chip[chips];
+
+	const uint32 rate = g_system->getMixer()->getOutputRate();
+	for (int i = 0; i < chips; ++i)
+		_chip[i].reset(rate, _type != Config::kOpl3);
+
+	_address[0] = _address[1] = 0;
+	return true;
+}
+
+void OPL::reset() {
+	init();
+}
+
+void OPL::write(int port, int val) {
+	val &= 0xff;
+
+	if (port & 1)
+		countWrite();
+
+	if (_type == Config::kDualOpl2) {
+		// Ports 0x?88/0x?89 address both chips, otherwise bit 1 of the
+		// port selects the chip.
+		const bool both = (port & 0x8) != 0;
+		const int index = (port & 2) >> 1;
+
+		for (int i = 0; i < 2; ++i) {
+			if (!both && i != index)
+				continue;
+
+			if (port & 1)
+				_chip[i].writeReg(_address[i], val);
+			else
+				_address[i] = val;
+		}
+		return;
+	}
+
+	if (port & 1) {
+		_chip[0].writeReg(_address[0], val);
+	} else {
+		// On OPL3 the second register bank is addressed via port 0x222
+		if (_type == Config::kOpl3 && (port & 2))
+			_address[0] = val | 0x100;
+		else
+			_address[0] = val;
+	}
+}
+
+byte OPL::read(int port) {
+	if (port & 1)
+		return (_type == Config::kDualOpl2) ? 0xff : 0;
+
+	switch (_type) {
+	case Config::kOpl2:
+		// Make sure the low bits are 6 on opl2
+		return _chip[0].readStatus() | 0x6;
+	case Config::kDualOpl2:
+		return _chip[(port >> 1) & 1].readStatus() | 0x6;
+	case Config::kOpl3:
+		return _chip[0].readStatus();
+	}
+
+	return 0;
+}
+
+void OPL::writeReg(int r, int v) {
+	countWrite();
+
+	if (_type == Config::kDualOpl2) {
+		_chip[0].writeReg(r & 0xff, v);
+		_chip[1].writeReg(r & 0xff, v);
+	} else if (_type == Config::kOpl3) {
+		_chip[0].writeReg(r & 0x1ff, v);
+	} else {
+		_chip[0].writeReg(r & 0xff, v);
+	}
+}
+
+void OPL::generateSamples(int16 *buffer, int length) {
+	int16 frame[2];
+
+	switch (_type) {
+	case Config::kOpl2:
+		for (int i = 0; i < length; ++i) {
+			_chip[0].generateResampled(frame);
+			buffer[i] = frame[0];
+		}
+		break;
+
+	case Config::kDualOpl2:
+		for (int i = 0; i < length; i += 2) {
+			_chip[0].generateResampled(frame);
+			buffer[i] = frame[0];
+			_chip[1].generateResampled(frame);
+			buffer[i + 1] = frame[0];
+		}
+		break;
+
+	case Config::kOpl3:
+		for (int i = 0; i < length; i += 2) {
+			_chip[0].generateResampled(frame);
+			buffer[i] = frame[0];
+			buffer[i + 1] = frame[1];
+		}
+		break;
+	}
+}
+
+} // End of namespace Reference
+} // End of namespace OPL
@@ -0,0 +1,230 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Based on the Nuked OPL3 emulator
+ * Copyright (C) 2013-2020 Nuke.YKT
+ * Licensed under LGPLv2.1+
+ * https://github.com/nukeykt/Nuked-OPL3
+ */
+
+/*
+ * Reference YM3812/YMF262 emulator.
+ *
+ * This core models the chip at the level of its internal sample clock
+ * (OSC / 288, i.e. ~49716 Hz): every operator runs through the same
+ * envelope, phase and log-sin/exp pipeline stages as the hardware, in
+ * hardware slot order, and the LFO, noise and envelope timers are clocked
+ * exactly once per chip cycle. It is intentionally slow and is not meant
+ * for regular playback; it serves as the accuracy baseline for the fast
+ * DOSBox and MAME cores (see audio/softsynth/opl/harness.h).
+ */
+
+#ifndef AUDIO_SOFTSYNTH_OPL_REFERENCE_H
+#define AUDIO_SOFTSYNTH_OPL_REFERENCE_H
+
+#include "audio/fmopl.h"
+
+namespace OPL {
+namespace Reference {
+
+struct Chip;
+struct Channel;
+
+struct Slot {
+	Channel *channel;
+	Chip *chip;
+	int16 out;
+	int16 fbmod;
+	int16 *mod;
+	int16 prout;
+	uint16 egRout;
+	uint16 egOut;
+	uint8 egGen;
+	uint8 egKsl;
+	uint8 *trem;
+	uint8 regVib;
+	uint8 regType;
+	uint8 regKsr;
+	uint8 regMult;
+	uint8 regKsl;
+	uint8 regTl;
+	uint8 regAr;
+	uint8 regDr;
+	uint8 regSl;
+	uint8 regRr;
+	uint8 regWf;
+	uint8 key;
+	bool pgReset;
+	uint32 pgPhase;
+	uint16 pgPhaseOut;
+	uint8 slotNum;
+
+	void write20(uint8 val);
+	void write40(uint8 val);
+	void write60(uint8 val);
+	void write80(uint8 val);
+	void writeE0(uint8 val);
+
+	void updateKsl();
+	void keyOn(uint8 type);
+	void keyOff(uint8 type);
+
+	void calcFeedback();
+	void calcEnvelope();
+	void generatePhase();
+	void generate();
+};
+
+struct Channel {
+	Slot *slots[2];
+	Channel *pair;
+	Chip *chip;
+	int16 *out[4];
+	uint8 chType;
+	uint16 fNum;
+	uint8 block;
+	uint8 fb;
+	uint8 con;
+	uint8 alg;
+	uint8 ksv;
+	uint16 cha, chb;
+	uint8 chNum;
+
+	void writeA0(uint8 val);
+	void writeB0(uint8 val);
+	void writeC0(uint8 val);
+
+	void setupAlg();
+	void updateAlg();
+	void keyOn();
+	void keyOff();
+};
+
+/**
+ * State of a single YMF262 chip. A YM3812 is modelled by leaving the chip
+ * in OPL2 compatibility mode (NEW bit cleared) and honouring the OPL2-only
+ * waveform select enable bit.
+ */
+struct Chip {
+	enum {
+		kChipRate = 49716,
+		kResampleFrac = 10
+	};
+
+	Channel channel[18];
+	Slot slot[36];
+	uint16 timer;
+	uint64 egTimer;
+	uint8 egTimerRem;
+	uint8 egState;
+	uint8 egAdd;
+	uint8 newm;
+	uint8 nts;
+	uint8 rhy;
+	uint8 vibPos;
+	uint8 vibShift;
+	uint8 tremolo;
+	uint8 tremoloPos;
+	uint8 tremoloShift;
+	uint32 noise;
+	int16 zeroMod;
+	int32 mixBuff[2];
+	uint8 rmHhBit2, rmHhBit3, rmHhBit7, rmHhBit8;
+	uint8 rmTcBit3, rmTcBit5;
+
+	/** True when emulating a YM3812 (OPL2-only waveform select) */
+	bool opl2;
+	/** Waveform select enable, register 0x01 bit 5 (YM3812 only) */
+	bool waveSelect;
+
+	/** Hardware timers, clocked from the chip cycle counter */
+	uint8 timerCounter[2];
+	uint8 timerReload[2];
+	bool timerEnabled[2];
+	bool timerMasked[2];
+	uint8 status;
+	uint32 timerCycles;
+
+	/** Linear resampler from the chip rate to the output rate */
+	int32 rateRatio;
+	int32 sampleCnt;
+	int16 oldSamples[2];
+	int16 samples[2];
+
+	/**
+	 * Resets the chip to its power-on state.
+	 *
+	 * @param rate	output sample rate used by generateResampled()
+	 * @param isOpl2	emulate a YM3812 instead of a YMF262
+	 */
+	void reset(uint32 rate, bool isOpl2);
+
+	void writeReg(uint16 reg, uint8 val);
+	uint8 readStatus() const { return status; }
+
+	/**
+	 * Runs the chip for exactly one internal sample cycle and stores the
+	 * left and right outputs in buf.
+	 */
+	void generate(int16 *buf);
+
+	/**
+	 * Produces one stereo sample at the output rate passed to reset().
+	 */
+	void generateResampled(int16 *buf);
+
+private:
+	void updateRhythm(uint8 val);
+	void set4Op(uint8 val);
+	void writeTimerControl(uint8 val);
+	void clockTimers();
+};
+
+class OPL : public ::OPL::EmulatedOPL {
+private:
+	Config::OplType _type;
+	Chip *_chip;
+	uint16 _address[2];
+
+public:
+	OPL(Config::OplType type);
+	~OPL();
+
+	bool init();
+	void reset();
+
+	void write(int a, int v);
+	byte read(int a);
+
+	void writeReg(int r, int v);
+
+	bool isStereo() const { return _type != Config::kOpl2; }
+
+protected:
+	void generateSamples(int16 *buffer, int length);
+};
+
+} // End of namespace Reference
+} // End of namespace OPL
+
+#endif
@@ -173,6 +173,26 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Returns the time of the last modification of the object referred by
+	 * this node, in seconds since an arbitrary, backend specific epoch.
+	 *
+	 * Backends which can not determine the time return 0, which is also
+	 * the default implementation.
+	 *
+	 * @return modification time, 0 if unknown
+	 */
+	virtual uint32 getModificationTime() const { return 0; }
+
+	/**
+	 * Returns the size of the file referred by this node without opening it.
+	 *
+	 * Backends which can not determine the size return -1, which is also
+	 * the default implementation.
+	 *
+	 * @return size in bytes, -1 if unknown
+	 */
+	virtual int32 getFileSize() const { return -1; }
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
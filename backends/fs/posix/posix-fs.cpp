@@ -46,6 +46,22 @@
 #include <os2.h>
 #endif
 
+// Ports opt in to mapping files by adding POSIX_USE_MMAP to their DEFINES.
+// No port does so by default: a mapped file which is truncated (e.g. a
+// save file being rewritten) or whose medium is removed raises SIGBUS on
+// access.
+#if defined(POSIX_USE_MMAP) && !defined(__OS2__)
+#include "backends/fs/posix/posix-mapped-stream.h"
+#define USE_MAPPED_STREAMS
+
+// Smaller files are read through stdio, mapping them is not worth it.
+// Larger files are not mapped either, to save address space.
+enum {
+	kMinMappedFileSize = 64 * 1024,
+	kMaxMappedFileSize = 64 * 1024 * 1024
+};
+#endif
+
 
 void POSIXFilesystemNode::setFlags() {
 	struct stat st;
@@ -54,6 +70,22 @@ void POSIXFilesystemNode::setFlags() {
 	_isDirectory = _isValid ? S_ISDIR(st.st_mode) : false;
 }
 
+uint32 POSIXFilesystemNode::getModificationTime() const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0)
+		return 0;
+	return (uint32)st.st_mtime;
+}
+
+int32 POSIXFilesystemNode::getFileSize() const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0 || S_ISDIR(st.st_mode))
+		return -1;
+	return (int32)st.st_size;
+}
+
 POSIXFilesystemNode::POSIXFilesystemNode(const Common::String &p) {
 	assert(p.size() > 0);
 
@@ -246,6 +278,12 @@ AbstractFSNode *POSIXFilesystemNode::getParent() const {
 }
 
 Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
+#ifdef USE_MAPPED_STREAMS
+	Common::SeekableReadStream *stream = PosixMappedStream::makeFromPath(getPath(), kMinMappedFileSize, kMaxMappedFileSize);
+	if (stream)
+		return stream;
+#endif
+
 	return StdioStream::makeFromPath(getPath(), false);
 }
 
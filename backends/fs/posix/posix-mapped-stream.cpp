@@ -0,0 +1,71 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#if defined(POSIX_USE_MMAP) && !defined(__OS2__)
+
+// Re-enable some forbidden symbols to avoid clashes with stat.h and unistd.h.
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_mkdir
+#define FORBIDDEN_SYMBOL_EXCEPTION_exit		//Needed for IRIX's unistd.h
+
+#include "backends/fs/posix/posix-mapped-stream.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+PosixMappedStream *PosixMappedStream::makeFromPath(const Common::String &path, uint32 minSize, uint32 maxSize) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return 0;
+
+	// Only map regular files within the given size range
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+	    st.st_size < (off_t)minSize || st.st_size <= 0 || st.st_size > (off_t)maxSize) {
+		close(fd);
+		return 0;
+	}
+
+	void *mapping = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping keeps its own reference to the file
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+		return 0;
+
+	return new PosixMappedStream(mapping, (uint32)st.st_size);
+}
+
+PosixMappedStream::PosixMappedStream(void *mapping, uint32 size)
+	: Common::MemoryReadStream((const byte *)mapping, size, DisposeAfterUse::NO),
+	  _mapping(mapping), _mappingSize(size) {
+}
+
+PosixMappedStream::~PosixMappedStream() {
+	munmap(_mapping, _mappingSize);
+}
+
+#endif
@@ -0,0 +1,56 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_MAPPED_STREAM_H
+#define BACKENDS_FS_POSIX_MAPPED_STREAM_H
+
+#include "common/memstream.h"
+#include "common/str.h"
+
+/**
+ * Read only stream on a file which is mapped into memory with mmap().
+ *
+ * Reads are served straight from the page cache and getDirectData() gives
+ * access to the complete file without copying it. Only available on ports
+ * which define POSIX_USE_MMAP.
+ */
+class PosixMappedStream : public Common::MemoryReadStream {
+public:
+	/**
+	 * Maps the file with the given path. Files smaller than minSize are
+	 * not mapped, since reading them normally is cheaper, and files larger
+	 * than maxSize are not mapped to save address space.
+	 *
+	 * @return the new stream, or 0 if the file could not be mapped
+	 */
+	static PosixMappedStream *makeFromPath(const Common::String &path, uint32 minSize, uint32 maxSize);
+
+	~PosixMappedStream();
+
+private:
+	PosixMappedStream(void *mapping, uint32 size);
+
+	void *_mapping;
+	uint32 _mappingSize;
+};
+
+#endif
@@ -303,6 +303,8 @@ void GPHGraphicsManager::internUpdateScreen() {
 	updateOSD();
 #endif
 
+	coalesceDirtyRects();
+
 	// Force a full redraw if requested
 	if (_forceFull) {
 		_numDirtyRects = 1;
@@ -38,6 +38,8 @@ void Context::reset() {
 	shadersSupported = false;
 	multitextureSupported = false;
 	framebufferObjectSupported = false;
+	pixelBufferObjectSupported = false;
+	unpackSubImageSupported = false;
 
 #define GL_FUNC_DEF(ret, name, param) name = nullptr;
 #include "backends/graphics/opengl/opengl-func.h"
@@ -119,6 +121,7 @@ void OpenGLGraphicsManager::initializeGLContext() {
 	bool ARBShadingLanguage100 = false;
 	bool ARBVertexShader = false;
 	bool ARBFragmentShader = false;
+	bool ARBPixelBufferObject = false;
 
 	Common::StringTokenizer tokenizer(extString, " ");
 	while (!tokenizer.empty()) {
@@ -138,6 +141,10 @@ void OpenGLGraphicsManager::initializeGLContext() {
 			g_context.multitextureSupported = true;
 		} else if (token == "GL_EXT_framebuffer_object") {
 			g_context.framebufferObjectSupported = true;
+		} else if (token == "GL_ARB_pixel_buffer_object") {
+			ARBPixelBufferObject = true;
+		} else if (token == "GL_EXT_unpack_subimage") {
+			g_context.unpackSubImageSupported = true;
 		}
 	}
 
@@ -157,6 +164,18 @@ void OpenGLGraphicsManager::initializeGLContext() {
 		g_context.shadersSupported = ARBShaderObjects & ARBShadingLanguage100 & ARBVertexShader & ARBFragmentShader;
 	}
 
+	if (g_context.type == kContextGL) {
+		// Desktop GL always supports GL_UNPACK_ROW_LENGTH.
+		g_context.unpackSubImageSupported = true;
+
+		// The buffer object functions are only used with the ARB extension,
+		// so make sure they could all be loaded.
+		g_context.pixelBufferObjectSupported = ARBPixelBufferObject
+		    && g_context.glGenBuffersARB && g_context.glDeleteBuffersARB
+		    && g_context.glBindBufferARB && g_context.glBufferDataARB
+		    && g_context.glMapBufferARB && g_context.glUnmapBufferARB;
+	}
+
 	// Log context type.
 	switch (g_context.type) {
 	case kContextGL:
@@ -177,6 +196,8 @@ void OpenGLGraphicsManager::initializeGLContext() {
 	debug(5, "OpenGL: Shader support: %d", g_context.shadersSupported);
 	debug(5, "OpenGL: Multitexture support: %d", g_context.multitextureSupported);
 	debug(5, "OpenGL: FBO support: %d", g_context.framebufferObjectSupported);
+	debug(5, "OpenGL: PBO support: %d", g_context.pixelBufferObjectSupported);
+	debug(5, "OpenGL: Unpack subimage support: %d", g_context.unpackSubImageSupported);
 }
 
 } // End of namespace OpenGL
@@ -126,6 +126,15 @@ struct Context {
 	/** Whether FBO support is available or not. */
 	bool framebufferObjectSupported;
 
+	/** Whether GL_ARB_pixel_buffer_object is available or not. */
+	bool pixelBufferObjectSupported;
+
+	/**
+	 * Whether GL_UNPACK_ROW_LENGTH is available or not, which allows to
+	 * upload parts of an image row.
+	 */
+	bool unpackSubImageSupported;
+
 #define GL_FUNC_DEF(ret, name, param) ret (GL_CALL_CONV *name)param
 #include "backends/graphics/opengl/opengl-func.h"
 #undef GL_FUNC_DEF
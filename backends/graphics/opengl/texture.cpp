@@ -48,12 +48,17 @@ GLTexture::GLTexture(GLenum glIntFormat, GLenum glFormat, GLenum glType)
     : _glIntFormat(glIntFormat), _glFormat(glFormat), _glType(glType),
       _width(0), _height(0), _logicalWidth(0), _logicalHeight(0),
       _texCoords(), _glFilter(GL_NEAREST),
-      _glTexture(0) {
+      _glTexture(0), _nextPixelBuffer(0) {
+	_pixelBuffers[0] = _pixelBuffers[1] = 0;
 	create();
 }
 
 GLTexture::~GLTexture() {
 	GL_CALL_SAFE(glDeleteTextures, (1, &_glTexture));
+
+	if (_pixelBuffers[0]) {
+		GL_CALL_SAFE(glDeleteBuffersARB, (2, _pixelBuffers));
+	}
 }
 
 void GLTexture::enableLinearFiltering(bool enable) {
@@ -72,6 +77,11 @@ void GLTexture::enableLinearFiltering(bool enable) {
 void GLTexture::destroy() {
 	GL_CALL(glDeleteTextures(1, &_glTexture));
 	_glTexture = 0;
+
+	if (_pixelBuffers[0]) {
+		GL_CALL(glDeleteBuffersARB(2, _pixelBuffers));
+		_pixelBuffers[0] = _pixelBuffers[1] = 0;
+	}
 }
 
 void GLTexture::create() {
@@ -147,25 +157,112 @@ void GLTexture::updateArea(const Common::Rect &area, const Graphics::Surface &sr
 	bind();
 
 	// Update the actual texture.
-	// Although we have the area of the texture buffer we want to update we
-	// cannot take advantage of the left/right boundries here because it is
-	// not possible to specify a pitch to glTexSubImage2D. To be precise, with
-	// plain OpenGL we could set GL_UNPACK_ROW_LENGTH to achieve this. However,
-	// OpenGL ES 1.0 does not support GL_UNPACK_ROW_LENGTH. Thus, we are left
-	// with the following options:
-	//
-	// 1) (As we do right now) Simply always update the whole texture lines of
-	//    rect changed. This is simplest to implement. In case performance is
-	//    really an issue we can think of switching to another method.
-	//
-	// 2) Copy the dirty rect to a temporary buffer and upload that by using
-	//    glTexSubImage2D. This is what the Android backend does. It is more
-	//    complicated though.
-	//
-	// 3) Use glTexSubImage2D per line changed. This is what the old OpenGL
-	//    graphics manager did but it is much slower! Thus, we do not use it.
-	GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, area.top, src.w, area.height(),
-	                       _glFormat, _glType, src.getBasePtr(0, area.top)));
+	if (g_context.unpackSubImageSupported) {
+		// GL_UNPACK_ROW_LENGTH tells glTexSubImage2D the pitch of the source
+		// data, thus we can upload exactly the area.
+		GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, src.pitch / src.format.bytesPerPixel));
+		GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, area.left, area.top, area.width(), area.height(),
+		                        _glFormat, _glType, src.getBasePtr(area.left, area.top)));
+		GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+	} else {
+		// OpenGL ES 1.0 and 2.0 do not support GL_UNPACK_ROW_LENGTH. Instead of
+		// copying the area to a temporary buffer, like the Android backend
+		// does, or uploading each line separately, which is much slower, we
+		// simply update the whole texture lines of the area.
+		GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, area.top, src.w, area.height(),
+		                        _glFormat, _glType, src.getBasePtr(0, area.top)));
+	}
+}
+
+void GLTexture::updateAreas(const Common::Array<Common::Rect> &areas, const Graphics::Surface &src) {
+	if (!g_context.pixelBufferObjectSupported) {
+		if (g_context.unpackSubImageSupported) {
+			for (uint i = 0; i < areas.size(); ++i) {
+				updateArea(areas[i], src);
+			}
+		} else if (!areas.empty()) {
+			// Without GL_UNPACK_ROW_LENGTH updateArea uploads whole lines, so
+			// overlapping lines would be uploaded once for every area. Upload
+			// the lines of all areas in one go instead.
+			Common::Rect bounds = areas[0];
+			for (uint i = 1; i < areas.size(); ++i) {
+				bounds.extend(areas[i]);
+			}
+			updateArea(bounds, src);
+		}
+		return;
+	}
+
+	// Pixel buffer objects are only used for desktop GL contexts, which
+	// always allow to upload parts of lines.
+	assert(g_context.unpackSubImageSupported);
+
+	const uint bytesPerPixel = src.format.bytesPerPixel;
+
+	uint32 size = 0;
+	for (uint i = 0; i < areas.size(); ++i) {
+		size += areas[i].width() * areas[i].height() * bytesPerPixel;
+	}
+
+	if (!size) {
+		return;
+	}
+
+	if (!_pixelBuffers[0]) {
+		GL_CALL(glGenBuffersARB(2, _pixelBuffers));
+	}
+
+	// Specifying the buffer data store anew allows the driver to hand out
+	// fresh memory in case the old data is still being transferred.
+	GL_CALL(glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, _pixelBuffers[_nextPixelBuffer]));
+	GL_CALL(glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, size, nullptr, GL_STREAM_DRAW_ARB));
+	_nextPixelBuffer ^= 1;
+
+	GLvoid *buffer;
+	GL_ASSIGN(buffer, glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB));
+
+	if (buffer) {
+		// Store the areas one after another without any padding.
+		byte *dst = (byte *)buffer;
+		for (uint i = 0; i < areas.size(); ++i) {
+			const uint lineSize = areas[i].width() * bytesPerPixel;
+			const byte *srcLine = (const byte *)src.getBasePtr(areas[i].left, areas[i].top);
+
+			for (int y = areas[i].height(); y > 0; --y) {
+				memcpy(dst, srcLine, lineSize);
+				dst += lineSize;
+				srcLine += src.pitch;
+			}
+		}
+
+		GLboolean unmapped;
+		GL_ASSIGN(unmapped, glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB));
+
+		// The buffer contents can get lost, for example on a mode switch.
+		if (unmapped) {
+			bind();
+
+			size_t offset = 0;
+			for (uint i = 0; i < areas.size(); ++i) {
+				const Common::Rect &area = areas[i];
+
+				// With a pixel unpack buffer bound the data pointer is an
+				// offset into the buffer.
+				GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, area.left, area.top, area.width(), area.height(),
+				                        _glFormat, _glType, (const GLvoid *)offset));
+				offset += area.width() * area.height() * bytesPerPixel;
+			}
+
+			GL_CALL(glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0));
+			return;
+		}
+	}
+
+	// Upload directly from the surface if the buffer could not be used.
+	GL_CALL(glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0));
+	for (uint i = 0; i < areas.size(); ++i) {
+		updateArea(areas[i], src);
+	}
 }
 
 //
@@ -173,7 +270,7 @@ void GLTexture::updateArea(const Common::Rect &area, const Graphics::Surface &sr
 //
 
 Surface::Surface()
-    : _allDirty(false), _dirtyArea() {
+    : _allDirty(false), _dirtyRects() {
 }
 
 void Surface::copyRectToTexture(uint x, uint y, uint w, uint h, const void *srcPtr, uint srcPitch) {
@@ -181,16 +278,17 @@ void Surface::copyRectToTexture(uint x, uint y, uint w, uint h, const void *srcP
 	assert(x + w <= dstSurf->w);
 	assert(y + h <= dstSurf->h);
 
-	// *sigh* Common::Rect::extend behaves unexpected whenever one of the two
-	// parameters is an empty rect. Thus, we check whether the current dirty
-	// area is valid. In case it is not we simply use the parameters as new
-	// dirty area. Otherwise, we simply call extend.
-	if (_dirtyArea.isEmpty()) {
-		_dirtyArea = Common::Rect(x, y, x + w, y + h);
-	} else {
-		_dirtyArea.extend(Common::Rect(x, y, x + w, y + h));
+	// The size of the surface is only known once it is allocated, thus we
+	// set up the dirty rect tracking here.
+	if (_dirtyRects.getWidth() != dstSurf->w || _dirtyRects.getHeight() != dstSurf->h) {
+		if (!_dirtyRects.isEmpty()) {
+			flagDirty();
+		}
+		_dirtyRects.setSize(dstSurf->w, dstSurf->h, kDirtyTileSize, kDirtyTileSize);
 	}
 
+	_dirtyRects.addRect(Common::Rect(x, y, x + w, y + h));
+
 	const byte *src = (const byte *)srcPtr;
 	byte *dst = (byte *)dstSurf->getBasePtr(x, y);
 	const uint pitch = dstSurf->pitch;
@@ -218,7 +316,15 @@ Common::Rect Surface::getDirtyArea() const {
 	if (_allDirty) {
 		return Common::Rect(getWidth(), getHeight());
 	} else {
-		return _dirtyArea;
+		return _dirtyRects.getBounds();
+	}
+}
+
+void Surface::getDirtyRects(Common::Array<Common::Rect> &rects) const {
+	// Each rect is uploaded separately, thus we fall back to the bounding
+	// box in case there are too many of them.
+	if (_allDirty || !_dirtyRects.getRects(rects, kMaxDirtyRects)) {
+		rects.push_back(getDirtyArea());
 	}
 }
 
@@ -279,11 +385,14 @@ void Texture::updateGLTexture() {
 		return;
 	}
 
-	Common::Rect dirtyArea = getDirtyArea();
+	Common::Array<Common::Rect> dirtyRects;
+	getDirtyRects(dirtyRects);
 
 	// In case we use linear filtering we might need to duplicate the last
 	// pixel row/column to avoid glitches with filtering.
-	if (_glTexture.isLinearFilteringEnabled()) {
+	for (uint i = 0; i < dirtyRects.size() && _glTexture.isLinearFilteringEnabled(); ++i) {
+		Common::Rect &dirtyArea = dirtyRects[i];
+
 		if (dirtyArea.right == _userPixelData.w && _userPixelData.w != _textureData.w) {
 			uint height = dirtyArea.height();
 
@@ -310,7 +419,7 @@ void Texture::updateGLTexture() {
 		}
 	}
 
-	_glTexture.updateArea(dirtyArea, _textureData);
+	_glTexture.updateAreas(dirtyRects, _textureData);
 
 	// We should have handled everything, thus not dirty anymore.
 	clearDirty();
@@ -410,20 +519,26 @@ void TextureCLUT8::updateGLTexture() {
 	// Do the palette look up
 	Graphics::Surface *outSurf = Texture::getSurface();
 
-	Common::Rect dirtyArea = getDirtyArea();
-
-	if (outSurf->format.bytesPerPixel == 2) {
-		doPaletteLookUp<uint16>((uint16 *)outSurf->getBasePtr(dirtyArea.left, dirtyArea.top),
-		                        (const byte *)_clut8Data.getBasePtr(dirtyArea.left, dirtyArea.top),
-		                        dirtyArea.width(), dirtyArea.height(),
-		                        outSurf->pitch, _clut8Data.pitch, (const uint16 *)_palette);
-	} else if (outSurf->format.bytesPerPixel == 4) {
-		doPaletteLookUp<uint32>((uint32 *)outSurf->getBasePtr(dirtyArea.left, dirtyArea.top),
-		                        (const byte *)_clut8Data.getBasePtr(dirtyArea.left, dirtyArea.top),
-		                        dirtyArea.width(), dirtyArea.height(),
-		                        outSurf->pitch, _clut8Data.pitch, (const uint32 *)_palette);
-	} else {
-		warning("TextureCLUT8::updateTexture: Unsupported pixel depth: %d", outSurf->format.bytesPerPixel);
+	Common::Array<Common::Rect> dirtyRects;
+	getDirtyRects(dirtyRects);
+
+	for (uint i = 0; i < dirtyRects.size(); ++i) {
+		const Common::Rect &dirtyArea = dirtyRects[i];
+
+		if (outSurf->format.bytesPerPixel == 2) {
+			doPaletteLookUp<uint16>((uint16 *)outSurf->getBasePtr(dirtyArea.left, dirtyArea.top),
+			                        (const byte *)_clut8Data.getBasePtr(dirtyArea.left, dirtyArea.top),
+			                        dirtyArea.width(), dirtyArea.height(),
+			                        outSurf->pitch, _clut8Data.pitch, (const uint16 *)_palette);
+		} else if (outSurf->format.bytesPerPixel == 4) {
+			doPaletteLookUp<uint32>((uint32 *)outSurf->getBasePtr(dirtyArea.left, dirtyArea.top),
+			                        (const byte *)_clut8Data.getBasePtr(dirtyArea.left, dirtyArea.top),
+			                        dirtyArea.width(), dirtyArea.height(),
+			                        outSurf->pitch, _clut8Data.pitch, (const uint32 *)_palette);
+		} else {
+			warning("TextureCLUT8::updateTexture: Unsupported pixel depth: %d", outSurf->format.bytesPerPixel);
+			break;
+		}
 	}
 
 	// Do generic handling of updating the texture.
@@ -609,14 +724,17 @@ void TextureCLUT8GPU::updateGLTexture() {
 
 	// Update CLUT8 texture if necessary.
 	if (Surface::isDirty()) {
-		_clut8Texture.updateArea(getDirtyArea(), _clut8Data);
+		Common::Array<Common::Rect> dirtyRects;
+		getDirtyRects(dirtyRects);
+
+		_clut8Texture.updateAreas(dirtyRects, _clut8Data);
 		clearDirty();
 	}
 
 	// Update palette if necessary.
 	if (_paletteDirty) {
 		Graphics::Surface palSurface;
-		palSurface.init(256, 1, 256, _palette,
+		palSurface.init(256, 1, 256 * 4, _palette,
 #ifdef SCUMM_LITTLE_ENDIAN
 		                Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24) // ABGR8888
 #else
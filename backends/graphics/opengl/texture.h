@@ -28,6 +28,8 @@
 #include "graphics/pixelformat.h"
 #include "graphics/surface.h"
 
+#include "common/array.h"
+#include "common/dirtyrects.h"
 #include "common/rect.h"
 
 namespace OpenGL {
@@ -99,6 +101,20 @@ public:
 	 */
 	void updateArea(const Common::Rect &area, const Graphics::Surface &src);
 
+	/**
+	 * Copy several areas of image data to the texture.
+	 *
+	 * If pixel buffer objects are supported, the areas are first copied to
+	 * a buffer object, so the actual transfer to the texture can happen
+	 * asynchronously. If only whole lines can be uploaded, the bounding box
+	 * of the areas is uploaded at once.
+	 *
+	 * @param areas    The areas to update.
+	 * @param src      Surface for the whole texture containing the pixel data
+	 *                 to upload.
+	 */
+	void updateAreas(const Common::Array<Common::Rect> &areas, const Graphics::Surface &src);
+
 	/**
 	 * Query the GL texture's width.
 	 */
@@ -143,6 +159,14 @@ private:
 	GLint _glFilter;
 
 	GLuint _glTexture;
+
+	/**
+	 * Pixel buffer objects used alternately by updateAreas, so filling one
+	 * does not have to wait for the transfer from the other one. They are
+	 * created on first use.
+	 */
+	GLuint _pixelBuffers[2];
+	uint _nextPixelBuffer;
 };
 
 /**
@@ -201,7 +225,7 @@ public:
 	void fill(uint32 color);
 
 	void flagDirty() { _allDirty = true; }
-	virtual bool isDirty() const { return _allDirty || !_dirtyArea.isEmpty(); }
+	virtual bool isDirty() const { return _allDirty || !_dirtyRects.isEmpty(); }
 
 	virtual uint getWidth() const = 0;
 	virtual uint getHeight() const = 0;
@@ -239,12 +263,29 @@ public:
 	 */
 	virtual const GLTexture &getGLTexture() const = 0;
 protected:
-	void clearDirty() { _allDirty = false; _dirtyArea = Common::Rect(); }
+	void clearDirty() { _allDirty = false; _dirtyRects.clear(); }
 
+	/**
+	 * @return The bounding box of all dirty areas.
+	 */
 	Common::Rect getDirtyArea() const;
+
+	/**
+	 * Obtain a small set of rects covering all dirty areas.
+	 *
+	 * @param rects The array to append the rects to.
+	 */
+	void getDirtyRects(Common::Array<Common::Rect> &rects) const;
 private:
+	enum {
+		/** Size of the tiles the dirty areas are collected on */
+		kDirtyTileSize = 32,
+		/** Maximum number of separate rects to upload in one update */
+		kMaxDirtyRects = 16
+	};
+
 	bool _allDirty;
-	Common::Rect _dirtyArea;
+	Common::DirtyRectTracker _dirtyRects;
 };
 
 /**
@@ -25,6 +25,7 @@
 #if defined(SDL_BACKEND)
 
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
+#include "backends/graphics/surfacesdl/surfacesdl-scalerpool.h"
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/platform/sdl/sdl.h"
 #include "common/config-manager.h"
@@ -89,6 +90,98 @@ static const int s_gfxModeSwitchTable[][4] = {
 static int cursorStretch200To240(uint8 *buf, uint32 pitch, int width, int height, int srcX, int srcY, int origSrcY);
 #endif
 
+// Whether the given graphics mode is slow enough that skipping the scaling
+// of unchanged tiles is worth comparing their source pixels
+static bool isExpensiveScaler(int mode) {
+	switch (mode) {
+	case GFX_2XSAI:
+	case GFX_SUPER2XSAI:
+	case GFX_SUPEREAGLE:
+	case GFX_ADVMAME2X:
+	case GFX_ADVMAME3X:
+	case GFX_HQ2X:
+	case GFX_HQ3X:
+		return true;
+	default:
+		return false;
+	}
+}
+
+enum {
+	// Dirty rects with fewer lines are scaled on a single thread
+	kMinScalerBandHeight = 20
+};
+
+namespace {
+
+/**
+ * A dirty rect split into horizontal bands, which are scaled (and aspect
+ * ratio corrected) independently of each other.
+ *
+ * The bands are split on source lines which are multiples of five, since
+ * those start a new group of six lines after the aspect ratio stretching.
+ * This way, a band only ever reads the lines it scaled itself and the
+ * in-place stretching of one band does not overwrite the lines of the next
+ * one. The split lines are also an even number of lines into the rect, so
+ * that the pattern of the DotMatrix scaler does not change.
+ */
+struct ScalerBands {
+	ScalerProc *scalerProc;
+	const byte *src;
+	uint32 srcPitch;
+	byte *dst;
+	uint32 dstPitch;
+	int width;
+	int height;
+	int y;		///< Screen line of the first line of the rect
+	int dstX;	///< Scaled x coordinate of the rect
+	int scale;
+	bool aspectRatioCorrection;
+
+	int firstSplit;
+	int bandHeight;
+	int numBands;
+
+	void split(int numThreads) {
+		firstSplit = (5 - y % 5) % 5;
+		if (firstSplit & 1)
+			firstSplit += 5;
+
+		bandHeight = MAX<int>(height / numThreads, kMinScalerBandHeight);
+		bandHeight = (bandHeight + 9) / 10 * 10;
+
+		numBands = MAX(1, (height - firstSplit + bandHeight - 1) / bandHeight);
+	}
+
+	void getBand(int band, int &start, int &end) const {
+		start = band ? firstSplit + band * bandHeight : 0;
+		end = MIN(height, firstSplit + (band + 1) * bandHeight);
+	}
+
+	static void scaleBand(void *data, int band) {
+		const ScalerBands &bands = *(const ScalerBands *)data;
+
+		int start, end;
+		bands.getBand(band, start, end);
+
+		const int origDstY = (bands.y + start) * bands.scale;
+		int dstY = origDstY;
+		if (bands.aspectRatioCorrection)
+			dstY = real2Aspect(dstY);
+
+		bands.scalerProc(bands.src + start * bands.srcPitch, bands.srcPitch,
+			bands.dst + bands.dstX * 2 + dstY * bands.dstPitch, bands.dstPitch, bands.width, end - start);
+
+#ifdef USE_SCALERS
+		if (bands.aspectRatioCorrection)
+			stretch200To240(bands.dst, bands.dstPitch, bands.width * bands.scale, (end - start) * bands.scale,
+				bands.dstX, dstY, origDstY);
+#endif
+	}
+};
+
+} // End of anonymous namespace
+
 AspectRatio::AspectRatio(int w, int h) {
 	// TODO : Validation and so on...
 	// Currently, we just ensure the program don't instantiate non-supported aspect ratios
@@ -139,7 +232,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #endif
 	_overlayVisible(false),
 	_overlayscreen(0), _tmpscreen2(0),
-	_scalerProc(0), _screenChangeCount(0),
+	_scalerProc(0), _scalerPool(0), _screenChangeCount(0), _scaledTilesProc(0),
 	_mouseVisible(false), _mouseNeedsRedraw(false), _mouseData(0), _mouseSurface(0),
 	_mouseOrigSurface(0), _cursorDontScale(false), _cursorPaletteDisabled(true),
 	_currentShakePos(0), _newShakePos(0),
@@ -201,6 +294,7 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 		SDL_FreeSurface(_mouseOrigSurface);
 	_mouseOrigSurface = 0;
 	g_system->deleteMutex(_graphicsMutex);
+	delete _scalerPool;
 
 	free(_currentPalette);
 	free(_cursorPalette);
@@ -564,6 +658,15 @@ bool SurfaceSdlGraphicsManager::setGraphicsMode(int mode) {
 	return true;
 }
 
+bool SurfaceSdlGraphicsManager::isScalerReentrant(ScalerProc *scalerProc) {
+#if defined(USE_HQ_SCALERS) && defined(USE_NASM)
+	// The assembly versions of the HQ scalers keep their state in globals
+	if (scalerProc == HQ2x || scalerProc == HQ3x)
+		return false;
+#endif
+	return true;
+}
+
 void SurfaceSdlGraphicsManager::setGraphicsModeIntern() {
 	Common::StackLock lock(_graphicsMutex);
 	ScalerProc *newScalerProc = 0;
@@ -1070,6 +1173,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	updateOSD();
 #endif
 
+	coalesceDirtyRects();
+
 	// Force a full redraw if requested
 	if (_forceFull) {
 		_numDirtyRects = 1;
@@ -1096,11 +1201,36 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		}
 
 		SDL_LockSurface(srcSurf);
+
+		// Tiles which were already scaled from the same pixels do not have
+		// to be scaled again. Comparing the pixels only pays off for the
+		// expensive scalers, and the scaled tiles are not kept while
+		// anything else covers the screen.
+		bool useScaledTiles = !_overlayVisible && isExpensiveScaler(_videoMode.mode) && _currentShakePos == 0;
+#ifdef USE_SDL_DEBUG_FOCUSRECT
+		if (_enableFocusRect)
+			useScaledTiles = false;
+#endif
+		if (useScaledTiles) {
+			skipScaledTiles(srcSurf, scalerProc);
+			lastRect = _dirtyRectList + _numDirtyRects;
+		} else {
+			_scaledTiles.invalidate();
+		}
+
 		SDL_LockSurface(_hwscreen);
 
 		srcPitch = srcSurf->pitch;
 		dstPitch = _hwscreen->pitch;
 
+		bool useScalerPool = isScalerReentrant(scalerProc);
+#ifndef USE_SCALERS
+		if (_videoMode.aspectRatioCorrection && !_overlayVisible)
+			useScalerPool = false;
+#endif
+		if (useScalerPool && !_scalerPool)
+			_scalerPool = new SdlScalerPool();
+
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			register int dst_y = r->y + _currentShakePos;
 			register int dst_h = 0;
@@ -1123,6 +1253,33 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
+				if (useScalerPool && dst_h >= 2 * kMinScalerBandHeight && _scalerPool->getNumThreads() > 1) {
+					// Scale and stretch the rect on several threads
+					ScalerBands bands;
+					bands.scalerProc = scalerProc;
+					bands.src = (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch;
+					bands.srcPitch = srcPitch;
+					bands.dst = (byte *)_hwscreen->pixels;
+					bands.dstPitch = dstPitch;
+					bands.width = r->w;
+					bands.height = dst_h;
+					bands.y = r->y + _currentShakePos;
+					bands.dstX = rx1;
+					bands.scale = scale1;
+					bands.aspectRatioCorrection = _videoMode.aspectRatioCorrection && !_overlayVisible;
+					bands.split(_scalerPool->getNumThreads());
+
+					_scalerPool->run(ScalerBands::scaleBand, &bands, bands.numBands);
+
+					r->x = rx1;
+					r->y = dst_y;
+					r->w = r->w * scale1;
+					r->h = dst_h * scale1;
+					if (bands.aspectRatioCorrection)
+						r->h = 1 + real2Aspect((bands.y + dst_h) * scale1 - 1) - dst_y;
+					continue;
+				}
+
 				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
 					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
 			}
@@ -1372,7 +1529,7 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	if (_forceFull)
 		return;
 
-	if (_numDirtyRects == NUM_DIRTY_RECT) {
+	if (realCoordinates && _numDirtyRects == NUM_DIRTY_RECT) {
 		_forceFull = true;
 		return;
 	}
@@ -1426,14 +1583,105 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 		return;
 	}
 
-	if (w > 0 && h > 0) {
+	if (w <= 0 || h <= 0)
+		return;
+
+	if (realCoordinates) {
+		// These are only added after the screen has been scaled, so they
+		// go straight to the final list
 		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
 
 		r->x = x;
 		r->y = y;
 		r->w = w;
 		r->h = h;
+		return;
+	}
+
+	// Tiles which are a multiple of five lines high start on lines which
+	// are not changed by the aspect ratio stretching, so the merged rects
+	// stay stretchable.
+	const int tileHeight = _videoMode.aspectRatioCorrection && !_overlayVisible ? 15 : 16;
+	if (_dirtyRects.getWidth() != width || _dirtyRects.getHeight() != height || _dirtyRects.getTileHeight() != tileHeight) {
+		if (!_dirtyRects.isEmpty()) {
+			// The areas collected so far use other coordinates
+			_forceFull = true;
+			return;
+		}
+		_dirtyRects.setSize(width, height, 16, tileHeight);
+	}
+
+	_dirtyRects.addRect(Common::Rect(x, y, x + w, y + h));
+}
+
+void SurfaceSdlGraphicsManager::coalesceDirtyRects() {
+	if (_dirtyRects.isEmpty())
+		return;
+
+	if (!_forceFull) {
+		// Keep some room for the rects of the mouse cursor, which are
+		// added after scaling
+		const int maxRects = NUM_DIRTY_RECT - _numDirtyRects - 4;
+
+		Common::Array<Common::Rect> rects;
+		if (maxRects > 0 && _dirtyRects.getRects(rects, maxRects)) {
+			for (uint i = 0; i < rects.size(); ++i) {
+				SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+
+				r->x = rects[i].left;
+				r->y = rects[i].top;
+				r->w = rects[i].width();
+				r->h = rects[i].height();
+			}
+		} else {
+			_forceFull = true;
+		}
 	}
+
+	_dirtyRects.clear();
+}
+
+void SurfaceSdlGraphicsManager::skipScaledTiles(const SDL_Surface *srcSurf, ScalerProc *scalerProc) {
+	assert(_dirtyRects.isEmpty());
+
+	// Use the same tiles as for collecting the dirty rects, so the
+	// remaining tiles stay stretchable
+	const int16 tileHeight = _videoMode.aspectRatioCorrection ? 15 : 16;
+	_scaledTiles.setSize(_videoMode.screenWidth, _videoMode.screenHeight, 16, tileHeight, srcSurf->format->BytesPerPixel);
+	if (_dirtyRects.getWidth() != _scaledTiles.getWidth() || _dirtyRects.getHeight() != _scaledTiles.getHeight() || _dirtyRects.getTileHeight() != tileHeight)
+		_dirtyRects.setSize(_scaledTiles.getWidth(), _scaledTiles.getHeight(), 16, tileHeight);
+
+	if (_forceFull || scalerProc != _scaledTilesProc) {
+		_scaledTiles.invalidate();
+		_scaledTilesProc = scalerProc;
+	}
+
+	const SDL_Rect *lastRect = _dirtyRectList + _numDirtyRects;
+	for (const SDL_Rect *r = _dirtyRectList; r != lastRect; ++r) {
+		_scaledTiles.update(Common::Rect(r->x, r->y, r->x + r->w, r->y + r->h), (const byte *)srcSurf->pixels,
+		                    srcSurf->pitch, _dirtyRects);
+	}
+
+	// A full update redraws everything anyway, the tiles only had to be
+	// brought up to date
+	if (!_forceFull) {
+		// If the tiles to scale do not fit into the list, the original
+		// dirty rects are scaled instead, which is just as correct
+		Common::Array<Common::Rect> rects;
+		if (_dirtyRects.getRects(rects, NUM_DIRTY_RECT - 4)) {
+			_numDirtyRects = 0;
+			for (uint i = 0; i < rects.size(); ++i) {
+				SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+
+				r->x = rects[i].left;
+				r->y = rects[i].top;
+				r->w = rects[i].width();
+				r->h = rects[i].height();
+			}
+		}
+	}
+
+	_dirtyRects.clear();
 }
 
 int16 SurfaceSdlGraphicsManager::getHeight() {
@@ -2054,6 +2302,11 @@ void SurfaceSdlGraphicsManager::drawMouse() {
 	_mouseBackup.w = dst.w;
 	_mouseBackup.h = dst.h;
 
+	// The cursor covers the scaled tiles below it until it is undrawn, which
+	// includes the border added by addDirtyRect()
+	if (!_overlayVisible)
+		_scaledTiles.invalidate(Common::Rect(_mouseBackup.x - 1, _mouseBackup.y - 1, _mouseBackup.x + dst.w + 1, _mouseBackup.y + dst.h + 1));
+
 	// We draw the pre-scaled cursor image, so now we need to adjust for
 	// scaling, shake position and aspect ratio correction manually.
 
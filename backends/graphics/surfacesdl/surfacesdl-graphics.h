@@ -27,13 +27,17 @@
 #include "backends/graphics/sdl/sdl-graphics.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
+#include "common/dirtyrects.h"
 #include "common/events.h"
 #include "common/system.h"
 
 #include "backends/events/sdl/sdl-events.h"
+#include "backends/graphics/surfacesdl/surfacesdl-tilecache.h"
 
 #include "backends/platform/sdl/sdl-sys.h"
 
+class SdlScalerPool;
+
 #ifndef RELEASE_BUILD
 // Define this to allow for focus rectangle debugging
 #define USE_SDL_DEBUG_FOCUSRECT
@@ -284,6 +288,15 @@ protected:
 
 	ScalerProc *_scalerProc;
 	int _scalerType;
+
+	/** Worker threads running the scaler on large dirty rects, created on first use */
+	SdlScalerPool *_scalerPool;
+
+	/**
+	 * Returns whether the given scaler may run on several parts of the
+	 * screen at the same time.
+	 */
+	static bool isScalerReentrant(ScalerProc *scalerProc);
 	int _transactionMode;
 
 	// Indicates whether it is needed to free _hwsurface in destructor
@@ -303,6 +316,17 @@ protected:
 	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
+	/**
+	 * Dirty areas of the game screen or overlay since the last update. They
+	 * are turned into entries of _dirtyRectList by coalesceDirtyRects().
+	 */
+	Common::DirtyRectTracker _dirtyRects;
+
+	/** Tiles of the game screen whose scaled output in _hwscreen is still valid */
+	SdlScaledTileCache _scaledTiles;
+	/** The scaler which produced the tiles in _scaledTiles */
+	ScalerProc *_scaledTilesProc;
+
 	struct MousePos {
 		// The mouse position, using either virtual (game) or real
 		// (overlay) coordinates.
@@ -371,6 +395,20 @@ protected:
 
 	virtual void addDirtyRect(int x, int y, int w, int h, bool realCoordinates = false);
 
+	/**
+	 * Adds the dirty areas collected since the last screen update to the
+	 * dirty rect list, as a set of non-overlapping rects. Falls back to a
+	 * full screen update when too many rects would be needed.
+	 */
+	void coalesceDirtyRects();
+
+	/**
+	 * Removes the tiles whose scaled output is still up to date from the
+	 * dirty rect list. Must be called after the dirty rects have been
+	 * copied to srcSurf.
+	 */
+	void skipScaledTiles(const SDL_Surface *srcSurf, ScalerProc *scalerProc);
+
 	virtual void drawMouse();
 	virtual void undrawMouse();
 	virtual void blitCursor();
@@ -0,0 +1,153 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "backends/graphics/surfacesdl/surfacesdl-scalerpool.h"
+
+#include "common/textconsole.h"
+#include "common/util.h"
+
+enum {
+	// There is little to gain from more threads at the resolutions we scale
+	kMaxScalerThreads = 8
+};
+
+SdlScalerPool::SdlScalerPool(int numThreads)
+	: _mutex(0), _startCond(0), _doneCond(0), _quit(false),
+	  _proc(0), _data(0), _numBands(0), _nextBand(0), _bandsDone(0) {
+
+	if (numThreads <= 0) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		numThreads = SDL_GetCPUCount();
+#else
+		// SDL 1.2 has no way to query the number of CPUs
+		numThreads = 1;
+#endif
+	}
+	numThreads = CLIP<int>(numThreads, 1, kMaxScalerThreads);
+
+	if (numThreads == 1)
+		return;
+
+	_mutex = SDL_CreateMutex();
+	_startCond = SDL_CreateCond();
+	_doneCond = SDL_CreateCond();
+
+	for (int i = 1; i < numThreads; ++i) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		SDL_Thread *thread = SDL_CreateThread(workerThreadEntry, "ScummVM Scaler", this);
+#else
+		SDL_Thread *thread = SDL_CreateThread(workerThreadEntry, this);
+#endif
+		if (!thread) {
+			warning("Could not create scaler thread: %s", SDL_GetError());
+			break;
+		}
+		_threads.push_back(thread);
+	}
+}
+
+SdlScalerPool::~SdlScalerPool() {
+	if (!_mutex)
+		return;
+
+	SDL_LockMutex(_mutex);
+	_quit = true;
+	SDL_CondBroadcast(_startCond);
+	SDL_UnlockMutex(_mutex);
+
+	for (uint i = 0; i < _threads.size(); ++i)
+		SDL_WaitThread(_threads[i], NULL);
+
+	SDL_DestroyCond(_doneCond);
+	SDL_DestroyCond(_startCond);
+	SDL_DestroyMutex(_mutex);
+}
+
+void SdlScalerPool::run(BandProc proc, void *data, int numBands) {
+	if (_threads.empty() || numBands <= 1) {
+		for (int band = 0; band < numBands; ++band)
+			proc(data, band);
+		return;
+	}
+
+	SDL_LockMutex(_mutex);
+	_proc = proc;
+	_data = data;
+	_numBands = numBands;
+	_nextBand = 0;
+	_bandsDone = 0;
+	SDL_CondBroadcast(_startCond);
+	SDL_UnlockMutex(_mutex);
+
+	while (runNextBand())
+		;
+
+	// Wait for the bands still being worked on by the other threads
+	SDL_LockMutex(_mutex);
+	while (_bandsDone < _numBands)
+		SDL_CondWait(_doneCond, _mutex);
+	SDL_UnlockMutex(_mutex);
+}
+
+bool SdlScalerPool::runNextBand() {
+	SDL_LockMutex(_mutex);
+	if (_nextBand >= _numBands) {
+		SDL_UnlockMutex(_mutex);
+		return false;
+	}
+
+	const int band = _nextBand++;
+	BandProc proc = _proc;
+	void *data = _data;
+	SDL_UnlockMutex(_mutex);
+
+	proc(data, band);
+
+	SDL_LockMutex(_mutex);
+	if (++_bandsDone == _numBands)
+		SDL_CondSignal(_doneCond);
+	SDL_UnlockMutex(_mutex);
+
+	return true;
+}
+
+void SdlScalerPool::workerThread() {
+	SDL_LockMutex(_mutex);
+	while (!_quit) {
+		if (_nextBand < _numBands) {
+			SDL_UnlockMutex(_mutex);
+			while (runNextBand())
+				;
+			SDL_LockMutex(_mutex);
+		} else {
+			SDL_CondWait(_startCond, _mutex);
+		}
+	}
+	SDL_UnlockMutex(_mutex);
+}
+
+int SDLCALL SdlScalerPool::workerThreadEntry(void *arg) {
+	SdlScalerPool *pool = (SdlScalerPool *)arg;
+	assert(pool);
+	pool->workerThread();
+	return 0;
+}
@@ -0,0 +1,82 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_GRAPHICS_SURFACESDL_SCALERPOOL_H
+#define BACKENDS_GRAPHICS_SURFACESDL_SCALERPOOL_H
+
+#include "backends/platform/sdl/sdl-sys.h"
+
+#include "common/array.h"
+
+/**
+ * A small pool of worker threads used to run the scalers on several
+ * horizontal bands of a dirty rect at the same time.
+ *
+ * The thread calling run() works on the bands itself as well, so a pool
+ * with a single thread does not start any worker threads at all.
+ */
+class SdlScalerPool {
+public:
+	typedef void (*BandProc)(void *data, int band);
+
+	/**
+	 * Creates a pool which runs the bands on numThreads threads, including
+	 * the calling one. If numThreads is 0 one thread per CPU is used.
+	 */
+	explicit SdlScalerPool(int numThreads = 0);
+	~SdlScalerPool();
+
+	/** Number of threads working on the bands, including the calling one */
+	int getNumThreads() const { return _threads.size() + 1; }
+
+	/**
+	 * Calls proc for each of the given bands and returns once all of them
+	 * are done. The bands may be processed in any order and concurrently,
+	 * so they must not write to the same memory.
+	 */
+	void run(BandProc proc, void *data, int numBands);
+
+private:
+	SDL_mutex *_mutex;
+	SDL_cond *_startCond;
+	SDL_cond *_doneCond;
+	Common::Array<SDL_Thread *> _threads;
+	bool _quit;
+
+	BandProc _proc;
+	void *_data;
+	int _numBands;
+	int _nextBand;
+	int _bandsDone;
+
+	/**
+	 * Processes the next pending band.
+	 *
+	 * @return false if there was no band left
+	 */
+	bool runNextBand();
+
+	void workerThread();
+	static int SDLCALL workerThreadEntry(void *arg);
+};
+
+#endif
@@ -0,0 +1,118 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "backends/graphics/surfacesdl/surfacesdl-tilecache.h"
+
+SdlScaledTileCache::SdlScaledTileCache()
+	: _width(0), _height(0), _tileWidth(16), _tileHeight(16), _bytesPerPixel(0), _tilesX(0), _tilesY(0),
+	  _copyPitch(0), _copySize(0) {
+}
+
+void SdlScaledTileCache::setSize(int16 width, int16 height, int16 tileWidth, int16 tileHeight, uint bytesPerPixel) {
+	assert(tileWidth > 0 && tileHeight > 0);
+
+	if (width == _width && height == _height && tileWidth == _tileWidth && tileHeight == _tileHeight &&
+	    bytesPerPixel == _bytesPerPixel)
+		return;
+
+	_width = width;
+	_height = height;
+	_tileWidth = tileWidth;
+	_tileHeight = tileHeight;
+	_bytesPerPixel = bytesPerPixel;
+	_tilesX = (width + tileWidth - 1) / tileWidth;
+	_tilesY = (height + tileHeight - 1) / tileHeight;
+
+	_copyPitch = (tileWidth + 3) * bytesPerPixel;
+	_copySize = _copyPitch * (tileHeight + 3);
+
+	_pixels.resize(_tilesX * _tilesY * _copySize);
+	_valid.resize(_tilesX * _tilesY);
+	invalidate();
+}
+
+void SdlScaledTileCache::invalidate() {
+	for (uint i = 0; i < _valid.size(); ++i)
+		_valid[i] = false;
+}
+
+void SdlScaledTileCache::invalidate(const Common::Rect &r) {
+	Common::Rect area(r);
+	area.clip(Common::Rect(_width, _height));
+	if (area.isEmpty())
+		return;
+
+	for (int ty = area.top / _tileHeight; ty <= (area.bottom - 1) / _tileHeight; ++ty) {
+		for (int tx = area.left / _tileWidth; tx <= (area.right - 1) / _tileWidth; ++tx)
+			_valid[ty * _tilesX + tx] = false;
+	}
+}
+
+void SdlScaledTileCache::update(const Common::Rect &r, const byte *src, uint32 srcPitch, Common::DirtyRectTracker &tiles) {
+	Common::Rect area(r);
+	area.clip(Common::Rect(_width, _height));
+	if (area.isEmpty())
+		return;
+
+	for (int ty = area.top / _tileHeight; ty <= (area.bottom - 1) / _tileHeight; ++ty) {
+		for (int tx = area.left / _tileWidth; tx <= (area.right - 1) / _tileWidth; ++tx) {
+			const Common::Rect tile = getTileRect(tx, ty);
+
+			// The source surface has its one pixel border at the top and
+			// left, so this covers the tile plus one pixel on the top and
+			// left and two pixels on the bottom and right, which is all
+			// the scalers ever look at.
+			const int index = ty * _tilesX + tx;
+			if (storePixels(&_pixels[index * _copySize], _copyPitch,
+			                src + tile.top * srcPitch + tile.left * _bytesPerPixel, srcPitch,
+			                (tile.width() + 3) * _bytesPerPixel, tile.height() + 3, _valid[index]))
+				continue;
+
+			_valid[index] = true;
+			tiles.addRect(tile);
+		}
+	}
+}
+
+Common::Rect SdlScaledTileCache::getTileRect(int tx, int ty) const {
+	const int16 left = tx * _tileWidth;
+	const int16 top = ty * _tileHeight;
+
+	return Common::Rect(left, top, MIN<int16>(left + _tileWidth, _width), MIN<int16>(top + _tileHeight, _height));
+}
+
+bool SdlScaledTileCache::storePixels(byte *copy, uint32 copyPitch, const byte *src, uint32 srcPitch, uint rowSize, int rows, bool valid) {
+	bool unchanged = valid;
+
+	while (rows--) {
+		// Once a row differs, the remaining rows are copied without
+		// comparing them first
+		if (!unchanged || memcmp(copy, src, rowSize) != 0) {
+			memcpy(copy, src, rowSize);
+			unchanged = false;
+		}
+		copy += copyPitch;
+		src += srcPitch;
+	}
+
+	return unchanged;
+}
@@ -0,0 +1,97 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_GRAPHICS_SURFACESDL_TILECACHE_H
+#define BACKENDS_GRAPHICS_SURFACESDL_TILECACHE_H
+
+#include "common/array.h"
+#include "common/dirtyrects.h"
+#include "common/rect.h"
+
+/**
+ * Remembers which parts of the scaled screen are still up to date.
+ *
+ * The screen is divided into tiles, and for each tile a copy of its source
+ * pixels, including the border the scalers look at, is kept. As long as the
+ * source pixels of a tile do not change and nothing was drawn over its
+ * scaled output, the tile does not have to be scaled again, even when it is
+ * marked as dirty.
+ */
+class SdlScaledTileCache {
+public:
+	SdlScaledTileCache();
+
+	/**
+	 * Sets up the tiles for a screen of the given size and pixel size.
+	 * Changing any of the sizes invalidates all tiles.
+	 */
+	void setSize(int16 width, int16 height, int16 tileWidth, int16 tileHeight, uint bytesPerPixel);
+
+	int16 getWidth() const { return _width; }
+	int16 getHeight() const { return _height; }
+	int16 getTileWidth() const { return _tileWidth; }
+	int16 getTileHeight() const { return _tileHeight; }
+
+	/** Marks all tiles as missing from the scaled output. */
+	void invalidate();
+
+	/** Marks the tiles touching the given rect as missing from the scaled output. */
+	void invalidate(const Common::Rect &r);
+
+	/**
+	 * Checks the tiles touching a dirty rect and adds all of them which
+	 * have to be scaled again to the tracker, each one as a whole. They
+	 * are considered to be up to date afterwards.
+	 *
+	 * @param r				the dirty rect
+	 * @param src			the source surface, which has a border of one
+	 *						pixel at the top and left and of two pixels at
+	 *						the bottom and right of the screen
+	 * @param srcPitch		pitch of the source surface
+	 * @param tiles			the tracker to add the tiles to
+	 */
+	void update(const Common::Rect &r, const byte *src, uint32 srcPitch, Common::DirtyRectTracker &tiles);
+
+private:
+	int16 _width, _height;
+	int16 _tileWidth, _tileHeight;
+	uint _bytesPerPixel;
+	int _tilesX, _tilesY;
+
+	/** Pitch of the stored source pixels of a tile, including its border */
+	uint32 _copyPitch;
+	/** Size of the stored source pixels of a tile, including its border */
+	uint32 _copySize;
+
+	Common::Array<byte> _pixels;
+	Common::Array<bool> _valid;
+
+	Common::Rect getTileRect(int tx, int ty) const;
+
+	/**
+	 * Compares the source pixels with the stored copy and updates it.
+	 * Returns true if the pixels did not change.
+	 */
+	static bool storePixels(byte *copy, uint32 copyPitch, const byte *src, uint32 srcPitch, uint rowSize, int rows, bool valid);
+};
+
+#endif
@@ -145,6 +145,35 @@ Common::String OSystem_POSIX::getDefaultConfigFileName() {
 	return configFile;
 }
 
+Common::String OSystem_POSIX::getDefaultCachePath() {
+	Common::String prefix;
+#ifdef MACOSX
+	const char *envVar = getenv("HOME");
+	if (envVar && *envVar && Posix::assureDirectoryExists("Library/Caches", envVar)) {
+		prefix = envVar;
+		prefix += "/Library/Caches";
+	}
+#elif !defined(SAMSUNGTV)
+	// Follow the XDG Base Directory Specification, like for the
+	// configuration file
+	const char *envVar = getenv("XDG_CACHE_HOME");
+	if (!envVar || !*envVar) {
+		envVar = getenv("HOME");
+		if (envVar && *envVar && Posix::assureDirectoryExists(".cache", envVar)) {
+			prefix = envVar;
+			prefix += "/.cache";
+		}
+	} else {
+		prefix = envVar;
+	}
+#endif
+
+	if (prefix.empty() || !Posix::assureDirectoryExists("scummvm", prefix.c_str()))
+		return Common::String();
+
+	return prefix + "/scummvm";
+}
+
 void OSystem_POSIX::addSysArchivesToSearchSet(Common::SearchSet &s, int priority) {
 #ifdef DATA_PATH
 	const char *snap = getenv("SNAP");
@@ -27,6 +27,7 @@
 
 #include <limits.h>
 
+#include "engines/detectioncache.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
@@ -790,6 +791,7 @@ static void runDetectorTest() {
 		}
 
 		GameList candidates(EngineMan.detectGames(files));
+		DetectionCacheMan.flush();
 		bool gameidDiffers = false;
 		GameList::iterator x;
 		for (x = candidates.begin(); x != candidates.end(); ++x) {
@@ -868,6 +870,7 @@ void upgradeTargets() {
 		Common::String desc(dom.getVal("description"));
 
 		GameList candidates(EngineMan.detectGames(files));
+		DetectionCacheMan.flush();
 		GameDescriptor *g = 0;
 
 		// We proceed as follows:
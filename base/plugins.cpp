@@ -444,6 +444,7 @@ void PluginManager::addToPluginsInMemList(Plugin *plugin) {
 
 // Engine plugins
 
+#include "engines/advancedDetector.h"
 #include "engines/metaengine.h"
 
 namespace Common {
@@ -518,6 +519,9 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 	GameList candidates;
 	EnginePlugin::List plugins;
 	EnginePlugin::List::const_iterator iter;
+	// Let the engines share the listing of the directory
+	AdvancedMetaEngine::beginDetectionRun();
+
 	PluginManager::instance().loadFirstPlugin();
 	do {
 		plugins = getPlugins();
@@ -527,6 +531,8 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 			candidates.push_back((**iter)->detectGames(fslist));
 		}
 	} while (PluginManager::instance().loadNextPlugin());
+
+	AdvancedMetaEngine::endDetectionRun();
 	return candidates;
 }
 
@@ -62,6 +62,13 @@ int Archive::listMatchingMembers(ArchiveMemberList &list, const String &pattern)
 
 
 
+// Changes of any SearchSet so far. SearchSets can be nested, so a change
+// of one set can change the lookup results of another one.
+static uint32 s_searchSetChanges = 0;
+
+SearchSet::SearchSet() : _cachedChanges(s_searchSetChanges) {
+}
+
 SearchSet::ArchiveNodeList::iterator SearchSet::find(const String &name) {
 	ArchiveNodeList::iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
@@ -86,6 +93,8 @@ SearchSet::ArchiveNodeList::const_iterator SearchSet::find(const String &name) c
     order prevails.
 */
 void SearchSet::insert(const Node &node) {
+	invalidateCaches();
+
 	ArchiveNodeList::iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
 		if (it->_priority < node._priority)
@@ -170,6 +179,7 @@ void SearchSet::addSubDirectoriesMatching(const FSNode &directory, String origPa
 void SearchSet::remove(const String &name) {
 	ArchiveNodeList::iterator it = find(name);
 	if (it != _list.end()) {
+		invalidateCaches();
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
@@ -181,6 +191,8 @@ bool SearchSet::hasArchive(const String &name) const {
 }
 
 void SearchSet::clear() {
+	invalidateCaches();
+
 	for (ArchiveNodeList::iterator i = _list.begin(); i != _list.end(); ++i) {
 		if (i->_autoFree)
 			delete i->_arc;
@@ -205,17 +217,59 @@ void SearchSet::setPriority(const String &name, int priority) {
 	insert(node);
 }
 
-bool SearchSet::hasFile(const String &name) const {
-	if (name.empty())
-		return false;
+void SearchSet::invalidateCaches() {
+	StackLock lock(_cacheMutex);
+	++s_searchSetChanges;
+	dropCaches();
+}
+
+void SearchSet::checkCaches() const {
+	if (_cachedChanges != s_searchSetChanges)
+		dropCaches();
+}
+
+void SearchSet::dropCaches() const {
+	_archiveCache.clear();
+	_cachedChanges = s_searchSetChanges;
+}
+
+Archive *SearchSet::getCachedArchive(const String &name) const {
+	StackLock lock(_cacheMutex);
+	checkCaches();
+
+	ArchiveCache::const_iterator cached = _archiveCache.find(name);
+	if (cached != _archiveCache.end())
+		return cached->_value;
+	return 0;
+}
+
+void SearchSet::cacheArchive(const String &name, Archive *archive) const {
+	StackLock lock(_cacheMutex);
+	checkCaches();
+	_archiveCache[name] = archive;
+}
+
+Archive *SearchSet::findArchive(const String &name) const {
+	Archive *cached = getCachedArchive(name);
+	if (cached && cached->hasFile(name))
+		return cached;
 
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return true;
+		if (it->_arc->hasFile(name)) {
+			cacheArchive(name, it->_arc);
+			return it->_arc;
+		}
 	}
 
-	return false;
+	return 0;
+}
+
+bool SearchSet::hasFile(const String &name) const {
+	if (name.empty())
+		return false;
+
+	return findArchive(name) != 0;
 }
 
 int SearchSet::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
@@ -242,11 +296,9 @@ const ArchiveMemberPtr SearchSet::getMember(const String &name) const {
 	if (name.empty())
 		return ArchiveMemberPtr();
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for (; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return it->_arc->getMember(name);
-	}
+	Archive *archive = findArchive(name);
+	if (archive)
+		return archive->getMember(name);
 
 	return ArchiveMemberPtr();
 }
@@ -255,11 +307,20 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 	if (name.empty())
 		return 0;
 
+	Archive *cached = getCachedArchive(name);
+	if (cached) {
+		SeekableReadStream *stream = cached->createReadStreamForMember(name);
+		if (stream)
+			return stream;
+	}
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
 		SeekableReadStream *stream = it->_arc->createReadStreamForMember(name);
-		if (stream)
+		if (stream) {
+			cacheArchive(name, it->_arc);
 			return stream;
+		}
 	}
 
 	return 0;
@@ -24,7 +24,10 @@
 #define COMMON_ARCHIVE_H
 
 #include "common/str.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/list.h"
+#include "common/mutex.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
 
@@ -126,6 +129,10 @@ public:
  * contained Archives, hence the simplistic policy of always looking for the first
  * match. SearchSet *DOES* guarantee that searches are performed in *DESCENDING*
  * priority order. In case of conflicting priorities, insertion order prevails.
+ *
+ * Lookups may be done from several threads at once, they only share a cache
+ * which is guarded by a mutex. Adding or removing archives must not happen
+ * while the set is in use by other threads.
  */
 class SearchSet : public Archive {
 	struct Node {
@@ -140,13 +147,46 @@ class SearchSet : public Archive {
 	typedef List<Node> ArchiveNodeList;
 	ArchiveNodeList _list;
 
+	// Archive which contained a member the last time it was looked up.
+	// Archives are expected not to change their contents while they are
+	// part of the set, so this is only reset when a SearchSet changes.
+	// That includes other sets, since they may be nested in this one.
+	typedef HashMap<String, Archive *, IgnoreCase_Hash, IgnoreCase_EqualTo> ArchiveCache;
+	mutable ArchiveCache _archiveCache;
+
+	// Number of SearchSet changes the caches are up to date with.
+	mutable uint32 _cachedChanges;
+
+	// Guards the caches, which are updated by const lookups.
+	mutable Mutex _cacheMutex;
+
 	ArchiveNodeList::iterator find(const String &name);
 	ArchiveNodeList::const_iterator find(const String &name) const;
 
 	// Add an archive keeping the list sorted by descending priority.
 	void insert(const Node& node);
 
+	// Returns the archive which contains the given member, or 0.
+	Archive *findArchive(const String &name) const;
+
+	// Records a change of this set and drops its caches.
+	void invalidateCaches();
+
+	// Drops the caches if any SearchSet changed since they were filled.
+	// Must be called with _cacheMutex locked.
+	void checkCaches() const;
+
+	// Drops the cached lookups. Must be called with _cacheMutex locked.
+	void dropCaches() const;
+
+	// Returns the archive cached for the given member, or 0.
+	Archive *getCachedArchive(const String &name) const;
+
+	// Remembers the archive which contains the given member.
+	void cacheArchive(const String &name, Archive *archive) const;
+
 public:
+	SearchSet();
 	virtual ~SearchSet() { clear(); }
 
 	/**
@@ -0,0 +1,190 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/dirtyrects.h"
+
+namespace Common {
+
+namespace {
+
+/** A block of tiles whose rows all have the same dirty span */
+struct TileBlock {
+	int left, right;	///< first and last + 1 tile column
+	Rect bounds;		///< dirty part of the tiles in the block
+	bool extended;		///< whether the current tile row extended the block
+};
+
+} // End of anonymous namespace
+
+DirtyRectTracker::DirtyRectTracker()
+	: _width(0), _height(0), _tileWidth(16), _tileHeight(16), _tilesX(0), _tilesY(0) {
+}
+
+void DirtyRectTracker::setSize(int16 width, int16 height, int16 tileWidth, int16 tileHeight) {
+	assert(tileWidth > 0 && tileHeight > 0);
+
+	_width = width;
+	_height = height;
+	_tileWidth = tileWidth;
+	_tileHeight = tileHeight;
+	_tilesX = (width + tileWidth - 1) / tileWidth;
+	_tilesY = (height + tileHeight - 1) / tileHeight;
+
+	_tiles.clear();
+	_tiles.resize(_tilesX * _tilesY);
+	_bounds = Rect();
+}
+
+void DirtyRectTracker::addRect(const Rect &r) {
+	const Rect clipped = r.findIntersectingRect(Rect(_width, _height));
+	if (clipped.isEmpty())
+		return;
+
+	if (_bounds.isEmpty())
+		_bounds = clipped;
+	else
+		_bounds.extend(clipped);
+
+	const int tx1 = clipped.left / _tileWidth;
+	const int tx2 = (clipped.right - 1) / _tileWidth;
+	const int ty1 = clipped.top / _tileHeight;
+	const int ty2 = (clipped.bottom - 1) / _tileHeight;
+
+	for (int ty = ty1; ty <= ty2; ++ty) {
+		const int16 top = MAX<int16>(clipped.top, ty * _tileHeight);
+		const int16 bottom = MIN<int16>(clipped.bottom, (ty + 1) * _tileHeight);
+
+		Rect *tile = &_tiles[ty * _tilesX + tx1];
+		for (int tx = tx1; tx <= tx2; ++tx, ++tile) {
+			const Rect part(MAX<int16>(clipped.left, tx * _tileWidth), top,
+			                MIN<int16>(clipped.right, (tx + 1) * _tileWidth), bottom);
+
+			if (tile->isEmpty())
+				*tile = part;
+			else
+				tile->extend(part);
+		}
+	}
+}
+
+void DirtyRectTracker::clear() {
+	if (_bounds.isEmpty())
+		return;
+
+	// Only the tiles within the bounds can be dirty
+	const int tx1 = _bounds.left / _tileWidth;
+	const int tx2 = (_bounds.right - 1) / _tileWidth;
+	const int ty1 = _bounds.top / _tileHeight;
+	const int ty2 = (_bounds.bottom - 1) / _tileHeight;
+
+	for (int ty = ty1; ty <= ty2; ++ty) {
+		for (int tx = tx1; tx <= tx2; ++tx)
+			_tiles[ty * _tilesX + tx] = Rect();
+	}
+
+	_bounds = Rect();
+}
+
+bool DirtyRectTracker::getRects(Array<Rect> &rects, uint maxRects) const {
+	if (_bounds.isEmpty())
+		return true;
+
+	return collectRects(rects, maxRects, false) || collectRects(rects, maxRects, true);
+}
+
+bool DirtyRectTracker::collectRects(Array<Rect> &rects, uint maxRects, bool joinRuns) const {
+	const uint oldSize = rects.size();
+	Array<TileBlock> blocks;
+
+	const int tx1 = _bounds.left / _tileWidth;
+	const int tx2 = (_bounds.right - 1) / _tileWidth + 1;
+	const int ty1 = _bounds.top / _tileHeight;
+	const int ty2 = (_bounds.bottom - 1) / _tileHeight + 1;
+
+	for (int ty = ty1; ty <= ty2; ++ty) {
+		for (uint i = 0; i < blocks.size(); ++i)
+			blocks[i].extended = false;
+
+		// Walk the runs of dirty tiles in this row. The row after the last
+		// one has no runs, so that all blocks are finished there.
+		const Rect *row = ty < ty2 ? &_tiles[ty * _tilesX] : 0;
+		int tx = tx1;
+		while (row) {
+			while (tx < tx2 && row[tx].isEmpty())
+				++tx;
+			if (tx == tx2)
+				break;
+
+			TileBlock run;
+			run.left = tx;
+			run.right = tx + 1;
+			run.bounds = row[tx];
+			run.extended = true;
+
+			if (joinRuns) {
+				// A single run from the first to the last dirty tile
+				for (++tx; tx < tx2; ++tx) {
+					if (!row[tx].isEmpty()) {
+						run.bounds.extend(row[tx]);
+						run.right = tx + 1;
+					}
+				}
+			} else {
+				for (++tx; tx < tx2 && !row[tx].isEmpty(); ++tx)
+					run.bounds.extend(row[tx]);
+				run.right = tx;
+			}
+
+			// Extend the block above, if it spans the same tiles
+			bool merged = false;
+			for (uint i = 0; i < blocks.size(); ++i) {
+				if (blocks[i].left == run.left && blocks[i].right == run.right && !blocks[i].extended) {
+					blocks[i].bounds.extend(run.bounds);
+					blocks[i].extended = true;
+					merged = true;
+					break;
+				}
+			}
+			if (!merged)
+				blocks.push_back(run);
+		}
+
+		// Blocks which did not continue into this row are finished
+		for (uint i = 0; i < blocks.size();) {
+			if (blocks[i].extended) {
+				++i;
+				continue;
+			}
+
+			if (rects.size() - oldSize == maxRects) {
+				rects.resize(oldSize);
+				return false;
+			}
+			rects.push_back(blocks[i].bounds);
+			blocks.remove_at(i);
+		}
+	}
+
+	return true;
+}
+
+} // End of namespace Common
@@ -0,0 +1,94 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_DIRTYRECTS_H
+#define COMMON_DIRTYRECTS_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Common {
+
+/**
+ * Collects the dirty areas of a screen on a grid of tiles and turns them
+ * into a small set of non-overlapping rects.
+ *
+ * Each tile remembers the bounding box of the dirty areas inside it, so
+ * the resulting rects are never larger than necessary at tile granularity.
+ * Overlapping updates, like those of several sprites moving across the
+ * same spot, are only reported once.
+ */
+class DirtyRectTracker {
+public:
+	DirtyRectTracker();
+
+	/**
+	 * Set the size of the tracked area and of the tiles. This also marks
+	 * the whole area as clean.
+	 */
+	void setSize(int16 width, int16 height, int16 tileWidth = 16, int16 tileHeight = 16);
+
+	int16 getWidth() const { return _width; }
+	int16 getHeight() const { return _height; }
+	int16 getTileWidth() const { return _tileWidth; }
+	int16 getTileHeight() const { return _tileHeight; }
+
+	/** Mark the given area as dirty. It is clipped to the tracked area. */
+	void addRect(const Rect &r);
+
+	/** Mark the whole area as clean. */
+	void clear();
+
+	bool isEmpty() const { return _bounds.isEmpty(); }
+
+	/** The bounding box of all dirty areas. */
+	const Rect &getBounds() const { return _bounds; }
+
+	/**
+	 * Compute a set of non-overlapping rects which covers all dirty areas.
+	 *
+	 * Runs of dirty tiles are merged horizontally and vertically. If that
+	 * gives more than maxRects rects, each row of tiles is instead covered
+	 * by a single span, which may include some clean tiles.
+	 *
+	 * @param rects		the array to append the rects to
+	 * @param maxRects	the maximum number of rects to return
+	 * @return false if the dirty areas could not be covered by maxRects
+	 *         rects, in which case rects is left unchanged
+	 */
+	bool getRects(Array<Rect> &rects, uint maxRects = 0xFFFFFFFF) const;
+
+private:
+	int16 _width, _height;
+	int16 _tileWidth, _tileHeight;
+	int _tilesX, _tilesY;
+
+	/** The dirty part of each tile, empty for clean tiles */
+	Array<Rect> _tiles;
+	Rect _bounds;
+
+	bool collectRects(Array<Rect> &rects, uint maxRects, bool joinRuns) const;
+};
+
+} // End of namespace Common
+
+#endif
@@ -133,6 +133,11 @@ int32 File::size() const {
 	return _handle->size();
 }
 
+const byte *File::getDirectData() const {
+	assert(_handle);
+	return _handle->getDirectData();
+}
+
 bool File::seek(int32 offs, int whence) {
 	assert(_handle);
 	return _handle->seek(offs, whence);
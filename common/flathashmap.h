@@ -0,0 +1,569 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/func.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLATHASHMAP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * FlatHashMap<Key,Val> is an open addressing alternative to HashMap with the
+ * same interface, meant for maps which are queried a lot.
+ *
+ * Keys and values are stored directly in one array instead of separately
+ * allocated nodes. A second array holds one control byte per slot, which
+ * marks the slot as empty or deleted, or contains 7 bits of the hash of the
+ * key stored there. Lookups check the control bytes of 16 slots at once,
+ * using SSE2 where available, and only compare the keys whose hash bits
+ * match.
+ *
+ * Unlike HashMap, adding a key may move the existing entries. Pointers and
+ * references to values as well as iterators are therefore invalidated by
+ * operator[], getVal and setVal whenever they add a new key.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+
+	struct Node {
+		const Key _key;
+		Val _value;
+		explicit Node(const Key &key) : _key(key), _value() {}
+		Node(const Key &key, const Val &value) : _key(key), _value(value) {}
+	};
+
+	enum {
+		FLATHASHMAP_GROUP_SIZE = 16,
+		FLATHASHMAP_MIN_CAPACITY = FLATHASHMAP_GROUP_SIZE,
+
+		// Control bytes of unused slots have the top bit set
+		FLATHASHMAP_EMPTY = 0x80,
+		FLATHASHMAP_DELETED = 0xFE,
+
+		// Used and deleted slots together may fill up to this fraction of
+		// the storage before it is rebuilt.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 7,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	byte *_control;		///< control bytes, one per slot
+	Node *_nodes;		///< slots, only constructed if their control byte marks them as used
+	size_type _mask;	///< Capacity of the FlatHashMap minus one; the capacity is a power of two and at least one group
+	size_type _size;
+	size_type _deleted;	///< Number of slots marked as deleted
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	/** The 7 hash bits stored in the control byte of a used slot. */
+	static byte hashBits(size_type hash) {
+		return (byte)((hash * 2654435761U) >> 25);
+	}
+
+	/** Returns a bit for each slot in the group at ctrl whose control byte equals value. */
+	static uint32 matchGroup(const byte *ctrl, byte value) {
+#ifdef FLATHASHMAP_USE_SSE2
+		const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+		return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)value)));
+#else
+		uint32 match = 0;
+		for (int i = 0; i < FLATHASHMAP_GROUP_SIZE; ++i) {
+			if (ctrl[i] == value)
+				match |= 1 << i;
+		}
+		return match;
+#endif
+	}
+
+	/** Returns a bit for each empty or deleted slot in the group at ctrl. */
+	static uint32 matchUnused(const byte *ctrl) {
+#ifdef FLATHASHMAP_USE_SSE2
+		return (uint32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+		uint32 match = 0;
+		for (int i = 0; i < FLATHASHMAP_GROUP_SIZE; ++i) {
+			if (ctrl[i] & 0x80)
+				match |= 1 << i;
+		}
+		return match;
+#endif
+	}
+
+	/** Index of the lowest set bit of a non-zero group match. */
+	static size_type firstMatch(uint32 match) {
+#if GCC_ATLEAST(3, 4)
+		return __builtin_ctz(match);
+#else
+		size_type bit = 0;
+		while (!(match & 1)) {
+			match >>= 1;
+			++bit;
+		}
+		return bit;
+#endif
+	}
+
+	bool isUsed(size_type slot) const {
+		return !(_control[slot] & 0x80);
+	}
+
+	void allocate(size_type capacity);
+	void destroyNodes();
+	void assign(const HM_t &map);
+	size_type lookup(const Key &key, size_type hash) const;
+	size_type lookup(const Key &key) const { return lookup(key, _hash(key)); }
+	size_type findUnusedSlot(size_type hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void expandStorage(size_type newCapacity);
+	void eraseSlot(size_type slot);
+
+#if !defined(__sgi) || defined(__GNUC__)
+	template<class T> friend class IteratorImpl;
+#endif
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+#if (defined(__sgi) && !defined(__GNUC__)) || defined(__INTEL_COMPILER)
+		template<class T> friend class Common::IteratorImpl;
+#else
+		template<class T> friend class IteratorImpl;
+#endif
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != 0);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->isUsed(_idx));
+			return &_hashmap->_nodes[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx <= _hashmap->_mask && !_hashmap->isUsed(_idx));
+			if (_idx > _hashmap->_mask)
+				_idx = (size_type)-1;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const HM_t &map);
+	~FlatHashMap();
+
+	HM_t &operator=(const HM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		destroyNodes();
+		free(_control);
+		free(_nodes);
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first used slot
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isUsed(ctr))
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first used slot
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isUsed(ctr))
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator	find(const Key &key) const {
+		size_type ctr = lookup(key);
+		if (ctr <= _mask)
+			return const_iterator(ctr, this);
+		return end();
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocate(FLATHASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const HM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	destroyNodes();
+	free(_control);
+	free(_nodes);
+}
+
+/**
+ * Internal method for allocating empty storage of the given capacity.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocate(size_type capacity) {
+	_mask = capacity - 1;
+	_control = (byte *)malloc(capacity);
+	_nodes = (Node *)malloc(capacity * sizeof(Node));
+	assert(_control != NULL && _nodes != NULL);
+	memset(_control, FLATHASHMAP_EMPTY, capacity);
+
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::destroyNodes() {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isUsed(ctr))
+			_nodes[ctr].~Node();
+	}
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+	allocate(map._mask + 1);
+
+	// With the same capacity every entry can stay in its slot
+	memcpy(_control, map._control, _mask + 1);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isUsed(ctr))
+			new (&_nodes[ctr]) Node(map._nodes[ctr]._key, map._nodes[ctr]._value);
+	}
+
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	destroyNodes();
+
+	if (shrinkArray && _mask >= FLATHASHMAP_MIN_CAPACITY) {
+		free(_control);
+		free(_nodes);
+		allocate(FLATHASHMAP_MIN_CAPACITY);
+	} else {
+		memset(_control, FLATHASHMAP_EMPTY, _mask + 1);
+		_size = 0;
+		_deleted = 0;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(size_type newCapacity) {
+#ifndef NDEBUG
+	const size_type old_size = _size;
+#endif
+	const size_type old_mask = _mask;
+	byte *old_control = _control;
+	Node *old_nodes = _nodes;
+
+	allocate(newCapacity);
+
+	// Rehash all the old elements. Since we know that no key exists twice
+	// in the old table, we only need to find a free slot for each.
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_control[ctr] & 0x80)
+			continue;
+
+		Node &node = old_nodes[ctr];
+		const size_type slot = findUnusedSlot(_hash(node._key));
+		new (&_nodes[slot]) Node(node._key, node._value);
+		_control[slot] = old_control[ctr];
+		_size++;
+
+		node.~Node();
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == old_size);
+
+	free(old_control);
+	free(old_nodes);
+}
+
+/**
+ * Probes the groups for the given hash. Groups are visited in triangular
+ * order, which reaches every group when the group count is a power of two.
+ *
+ * @return the slot of the key, or _mask + 1 if the key is not contained
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key, size_type hash) const {
+	const byte bits = hashBits(hash);
+	const size_type groupMask = _mask / FLATHASHMAP_GROUP_SIZE;
+	size_type group = hash & groupMask;
+
+	for (size_type step = 1; ; ++step) {
+		const byte *ctrl = _control + group * FLATHASHMAP_GROUP_SIZE;
+		for (uint32 match = matchGroup(ctrl, bits); match; match &= match - 1) {
+			const size_type slot = group * FLATHASHMAP_GROUP_SIZE + firstMatch(match);
+			if (_equal(_nodes[slot]._key, key))
+				return slot;
+		}
+
+		// A key is only stored behind groups which were full when it was
+		// added. Groups with an empty slot have never been full.
+		if (matchGroup(ctrl, FLATHASHMAP_EMPTY))
+			return _mask + 1;
+
+		group = (group + step) & groupMask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findUnusedSlot(size_type hash) const {
+	const size_type groupMask = _mask / FLATHASHMAP_GROUP_SIZE;
+	size_type group = hash & groupMask;
+
+	for (size_type step = 1; ; ++step) {
+		const uint32 match = matchUnused(_control + group * FLATHASHMAP_GROUP_SIZE);
+		if (match)
+			return group * FLATHASHMAP_GROUP_SIZE + firstMatch(match);
+
+		group = (group + step) & groupMask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	const size_type hash = _hash(key);
+	size_type ctr = lookup(key, hash);
+	if (ctr <= _mask)
+		return ctr;
+
+	// Keep the load factor below a certain threshold. Deleted slots are
+	// also counted, since they lengthen the probe sequences just the same.
+	// Rebuilding the storage gets rid of them.
+	if ((_size + _deleted + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR >
+	        (_mask + 1) * FLATHASHMAP_LOADFACTOR_NUMERATOR) {
+		size_type capacity = FLATHASHMAP_MIN_CAPACITY;
+		while (capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR < (_size + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR * 2)
+			capacity *= 2;
+		expandStorage(capacity);
+	}
+
+	ctr = findUnusedSlot(hash);
+	if (_control[ctr] == FLATHASHMAP_DELETED)
+		_deleted--;
+
+	new (&_nodes[ctr]) Node(key);
+	_control[ctr] = hashBits(hash);
+	_size++;
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type slot) {
+	_nodes[slot].~Node();
+	_size--;
+
+	// A slot in a group which still has an empty slot can become empty
+	// again, since no probe sequence continues past such a group.
+	if (matchGroup(_control + (slot & ~(size_type)(FLATHASHMAP_GROUP_SIZE - 1)), FLATHASHMAP_EMPTY)) {
+		_control[slot] = FLATHASHMAP_EMPTY;
+	} else {
+		_control[slot] = FLATHASHMAP_DELETED;
+		_deleted++;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) <= _mask;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	return _nodes[ctr]._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		return _nodes[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	_nodes[ctr]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	const size_type ctr = entry._idx;
+	assert(ctr <= _mask);
+	assert(isUsed(ctr));
+
+	eraseSlot(ctr);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr <= _mask)
+		eraseSlot(ctr);
+}
+
+} // End of namespace Common
+
+#endif
@@ -125,6 +125,14 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+uint32 FSNode::getModificationTime() const {
+	return _realNode ? _realNode->getModificationTime() : 0;
+}
+
+int32 FSNode::getFileSize() const {
+	return _realNode ? _realNode->getFileSize() : -1;
+}
+
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == 0)
 		return 0;
@@ -191,8 +199,9 @@ FSNode *FSDirectory::lookupCache(NodeCache &cache, const String &name) const {
 	if (!name.empty()) {
 		ensureCached();
 
-		if (cache.contains(name))
-			return &cache[name];
+		NodeCache::iterator node = cache.find(name);
+		if (node != cache.end())
+			return &node->_value;
 	}
 
 	return 0;
@@ -25,8 +25,8 @@
 
 #include "common/array.h"
 #include "common/archive.h"
+#include "common/flathashmap.h"
 #include "common/hash-str.h"
-#include "common/hashmap.h"
 #include "common/ptr.h"
 #include "common/str.h"
 
@@ -213,6 +213,23 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Returns the time of the last modification of the object referred by
+	 * this node. The value is only meant to be compared against earlier
+	 * results for the same node, e.g. to detect changed files.
+	 *
+	 * @return modification time, 0 if unknown or not supported
+	 */
+	uint32 getModificationTime() const;
+
+	/**
+	 * Returns the size of the file referred by this node, without opening
+	 * it.
+	 *
+	 * @return size in bytes, -1 if unknown or not supported
+	 */
+	int32 getFileSize() const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -274,7 +291,7 @@ class FSDirectory : public Archive {
 
 	// Caches are case insensitive, clashes are dealt with when creating
 	// Key is stored in lowercase.
-	typedef HashMap<String, FSNode, IgnoreCase_Hash, IgnoreCase_EqualTo> NodeCache;
+	typedef FlatHashMap<String, FSNode, IgnoreCase_Hash, IgnoreCase_EqualTo> NodeCache;
 	mutable NodeCache	_fileCache, _subDirCache;
 	mutable bool _cached;
 	mutable int	_depth;
@@ -71,6 +71,80 @@ public:
 	int32 size() const { return _size; }
 
 	bool seek(int32 offs, int whence = SEEK_SET);
+
+	const byte *getDirectData() const { return _ptrOrig; }
+
+	// Inline versions of the ReadStream helpers, which read straight from
+	// the buffer instead of going through the virtual read(). They are
+	// used whenever the static type of the stream is a MemoryReadStream.
+
+	byte readByte() {
+		if (_pos < _size) {
+			_pos++;
+			return *_ptr++;
+		}
+		return ReadStream::readByte();
+	}
+
+	FORCEINLINE int8 readSByte() {
+		return (int8)readByte();
+	}
+
+	uint16 readUint16LE() {
+		if (_size - _pos >= 2) {
+			const uint16 val = READ_LE_UINT16(_ptr);
+			_ptr += 2;
+			_pos += 2;
+			return val;
+		}
+		return ReadStream::readUint16LE();
+	}
+
+	uint16 readUint16BE() {
+		if (_size - _pos >= 2) {
+			const uint16 val = READ_BE_UINT16(_ptr);
+			_ptr += 2;
+			_pos += 2;
+			return val;
+		}
+		return ReadStream::readUint16BE();
+	}
+
+	uint32 readUint32LE() {
+		if (_size - _pos >= 4) {
+			const uint32 val = READ_LE_UINT32(_ptr);
+			_ptr += 4;
+			_pos += 4;
+			return val;
+		}
+		return ReadStream::readUint32LE();
+	}
+
+	uint32 readUint32BE() {
+		if (_size - _pos >= 4) {
+			const uint32 val = READ_BE_UINT32(_ptr);
+			_ptr += 4;
+			_pos += 4;
+			return val;
+		}
+		return ReadStream::readUint32BE();
+	}
+
+	FORCEINLINE int16 readSint16LE() {
+		return (int16)readUint16LE();
+	}
+
+	FORCEINLINE int16 readSint16BE() {
+		return (int16)readUint16BE();
+	}
+
+	FORCEINLINE int32 readSint32LE() {
+		return (int32)readUint32LE();
+	}
+
+	FORCEINLINE int32 readSint32BE() {
+		return (int32)readUint32BE();
+	}
 };
 
 
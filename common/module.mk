@@ -6,6 +6,7 @@ MODULE_OBJS := \
 	coroutines.o \
 	dcl.o \
 	debug.o \
+	dirtyrects.o \
 	error.o \
 	EventDispatcher.o \
 	EventMapper.o \
@@ -26,8 +26,45 @@
 #include "common/substream.h"
 #include "common/str.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STREAM_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Common {
 
+namespace {
+
+void swapArray16(uint16 *data, uint32 count) {
+	uint32 i = 0;
+#ifdef STREAM_USE_SSE2
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i *)(data + i), v);
+	}
+#endif
+	for (; i < count; ++i)
+		data[i] = SWAP_BYTES_16(data[i]);
+}
+
+void swapArray32(uint32 *data, uint32 count) {
+	uint32 i = 0;
+#ifdef STREAM_USE_SSE2
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+		// Swap the two halves of each word, then the bytes of each half
+		v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i *)(data + i), v);
+	}
+#endif
+	for (; i < count; ++i)
+		data[i] = SWAP_BYTES_32(data[i]);
+}
+
+} // End of anonymous namespace
+
 void WriteStream::writeString(const String &str) {
 	write(str.c_str(), str.size());
 }
@@ -39,6 +76,38 @@ SeekableReadStream *ReadStream::readStream(uint32 dataSize) {
 	return new MemoryReadStream((byte *)buf, dataSize, DisposeAfterUse::YES);
 }
 
+uint32 ReadStream::readUint16ArrayLE(uint16 *dst, uint32 count) {
+	count = read(dst, count * 2) / 2;
+#ifdef SCUMM_BIG_ENDIAN
+	swapArray16(dst, count);
+#endif
+	return count;
+}
+
+uint32 ReadStream::readUint16ArrayBE(uint16 *dst, uint32 count) {
+	count = read(dst, count * 2) / 2;
+#ifndef SCUMM_BIG_ENDIAN
+	swapArray16(dst, count);
+#endif
+	return count;
+}
+
+uint32 ReadStream::readUint32ArrayLE(uint32 *dst, uint32 count) {
+	count = read(dst, count * 4) / 4;
+#ifdef SCUMM_BIG_ENDIAN
+	swapArray32(dst, count);
+#endif
+	return count;
+}
+
+uint32 ReadStream::readUint32ArrayBE(uint32 *dst, uint32 count) {
+	count = read(dst, count * 4) / 4;
+#ifndef SCUMM_BIG_ENDIAN
+	swapArray32(dst, count);
+#endif
+	return count;
+}
+
 
 uint32 MemoryReadStream::read(void *dataPtr, uint32 dataSize) {
 	// Read at most as many bytes as are still available...
@@ -216,6 +285,11 @@ SeekableSubReadStream::SeekableSubReadStream(SeekableReadStream *parentStream, u
 	_eos = false;
 }
 
+const byte *SeekableSubReadStream::getDirectData() const {
+	const byte *data = _parentStream->getDirectData();
+	return data ? data + _begin : 0;
+}
+
 bool SeekableSubReadStream::seek(int32 offset, int whence) {
 	assert(_pos >= _begin);
 	assert(_pos <= _end);
@@ -241,6 +315,21 @@ bool SeekableSubReadStream::seek(int32 offset, int whence) {
 }
 
 uint32 SafeSeekableSubReadStream::read(void *dataPtr, uint32 dataSize) {
+	// Memory backed parent streams can be copied from directly, which
+	// saves repositioning them on every read
+	const byte *data = _parentStream->getDirectData();
+	if (data) {
+		const uint32 end = MIN<uint32>(_end, _parentStream->size());
+		const uint32 avail = _pos < end ? end - _pos : 0;
+		if (dataSize > avail) {
+			dataSize = avail;
+			_eos = true;
+		}
+		memcpy(dataPtr, data + _pos, dataSize);
+		_pos += dataSize;
+		return dataSize;
+	}
+
 	// Make sure the parent stream is at the right position
 	seek(0, SEEK_CUR);
 
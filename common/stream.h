@@ -401,6 +401,75 @@ public:
 	}
 #endif
 
+	/**
+	 * Read an array of unsigned 16-bit words stored in little endian
+	 * (LSB first) order from the stream. The data is read with a single
+	 * call to read() and then converted in place, which is a lot faster
+	 * than reading the words one by one.
+	 *
+	 * @param dst	the buffer to store the words in
+	 * @param count	the number of words to read
+	 * @return the number of words which were read completely
+	 */
+	uint32 readUint16ArrayLE(uint16 *dst, uint32 count);
+
+	/**
+	 * Read an array of unsigned 16-bit words stored in big endian
+	 * (MSB first) order from the stream.
+	 * @see readUint16ArrayLE
+	 */
+	uint32 readUint16ArrayBE(uint16 *dst, uint32 count);
+
+	/**
+	 * Read an array of unsigned 32-bit words stored in little endian
+	 * (LSB first) order from the stream.
+	 * @see readUint16ArrayLE
+	 */
+	uint32 readUint32ArrayLE(uint32 *dst, uint32 count);
+
+	/**
+	 * Read an array of unsigned 32-bit words stored in big endian
+	 * (MSB first) order from the stream.
+	 * @see readUint16ArrayLE
+	 */
+	uint32 readUint32ArrayBE(uint32 *dst, uint32 count);
+
+	/**
+	 * Read an array of signed 16-bit words stored in little endian
+	 * (LSB first) order from the stream.
+	 * @see readUint16ArrayLE
+	 */
+	FORCEINLINE uint32 readSint16ArrayLE(int16 *dst, uint32 count) {
+		return readUint16ArrayLE((uint16 *)dst, count);
+	}
+
+	/**
+	 * Read an array of signed 16-bit words stored in big endian
+	 * (MSB first) order from the stream.
+	 * @see readUint16ArrayLE
+	 */
+	FORCEINLINE uint32 readSint16ArrayBE(int16 *dst, uint32 count) {
+		return readUint16ArrayBE((uint16 *)dst, count);
+	}
+
+	/**
+	 * Read an array of signed 32-bit words stored in little endian
+	 * (LSB first) order from the stream.
+	 * @see readUint16ArrayLE
+	 */
+	FORCEINLINE uint32 readSint32ArrayLE(int32 *dst, uint32 count) {
+		return readUint32ArrayLE((uint32 *)dst, count);
+	}
+
+	/**
+	 * Read an array of signed 32-bit words stored in big endian
+	 * (MSB first) order from the stream.
+	 * @see readUint16ArrayLE
+	 */
+	FORCEINLINE uint32 readSint32ArrayBE(int32 *dst, uint32 count) {
+		return readUint32ArrayBE((uint32 *)dst, count);
+	}
+
 	/**
 	 * Read the specified amount of data into a malloc'ed buffer
 	 * which then is wrapped into a MemoryReadStream.
@@ -461,6 +530,17 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Gives direct access to the data of streams which are backed by a
+	 * block of memory, like memory streams or memory mapped files. The
+	 * data stays valid for the lifetime of the stream and must not be
+	 * modified.
+	 *
+	 * @return a pointer to the size() bytes of the stream, or 0 if the
+	 *         data is not directly accessible
+	 */
+	virtual const byte *getDirectData() const { return 0; }
+
 	/**
 	 * Reads at most one less than the number of characters specified
 	 * by bufSize from the and stores them in the string buf. Reading
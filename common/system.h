@@ -1193,6 +1193,15 @@ public:
 	 */
 	virtual Common::String getDefaultConfigFileName();
 
+	/**
+	 * Get the directory where ScummVM may store cache files, i.e. data
+	 * which can be regenerated at any time.
+	 *
+	 * @return path of the directory, or an empty string if the port has
+	 *         no such place. Caches are only kept in memory then.
+	 */
+	virtual Common::String getDefaultCachePath();
+
 	/**
 	 * Logs a given message.
 	 *
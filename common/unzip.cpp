@@ -106,6 +106,9 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/substream.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -373,8 +376,13 @@ typedef struct {
 	uLong current_file_ok;			/* flag about the usability of the current file*/
 	unz_file_info cur_file_info;					/* public info about the current file in zip*/
 	unz_file_info_internal cur_file_info_internal;	/* private info about it*/
+	uLong data_offset;				/* offset of the file data in the stream, 0 if
+									   the local header is invalid, UNZ_UNKNOWN_OFFSET
+									   until the member is opened */
 } cached_file_in_zip;
 
+#define UNZ_UNKNOWN_OFFSET ((uLong)-1)
+
 typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_Hash,
 	Common::IgnoreCase_EqualTo> ZipHash;
 
@@ -517,6 +525,26 @@ static uLong unzlocal_SearchCentralDir(Common::SeekableReadStream &fin) {
 	return uPosFound;
 }
 
+/*
+  Get the offset of the data of a file in the stream, behind its local
+  header at the given offset. Returns 0 if the local header is invalid.
+*/
+static uLong unzlocal_GetFileDataOffset(Common::SeekableReadStream *stream, uLong offset_local_header) {
+	uLong uMagic,size_filename,size_extra_field;
+
+	stream->seek(offset_local_header, SEEK_SET);
+	if (unzlocal_getLong(stream,&uMagic) != UNZ_OK || uMagic != 0x04034b50)
+		return 0;
+
+	/* skip version, flags, compression method, date/time, crc and sizes */
+	stream->seek(offset_local_header + 26, SEEK_SET);
+	if (unzlocal_getShort(stream,&size_filename) != UNZ_OK ||
+	    unzlocal_getShort(stream,&size_extra_field) != UNZ_OK)
+		return 0;
+
+	return offset_local_header + SIZEZIPLOCALHEADER + size_filename + size_extra_field;
+}
+
 /*
   Open a Zip file. path contain the full pathname (by example,
      on a Windows NT computer "c:\\test\\zlib109.zip" or on an Unix computer
@@ -620,6 +648,9 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		fe.current_file_ok = us->current_file_ok;
 		fe.cur_file_info = us->cur_file_info;
 		fe.cur_file_info_internal = us->cur_file_info_internal;
+		// The local header is only read when the file is opened. Reading it
+		// here would seek through the whole archive.
+		fe.data_offset = UNZ_UNKNOWN_OFFSET;
 
 		us->_hash[Common::String(szCurrentFileName)] = fe;
 
@@ -1419,12 +1450,478 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 
 namespace Common {
 
+namespace {
+
+/** Members up to this size are read into memory at once. */
+enum {
+	kMaxInMemorySize = 64 * 1024
+};
+
+#ifdef USE_ZLIB
+
+/**
+ * Computes the CRC of an archive member while it is read. Only data which
+ * continues the part checked so far is added, so reading a member again
+ * after seeking back does not disturb the check.
+ */
+class ZipCRCCheck {
+public:
+	ZipCRCCheck(uint32 size, uint32 crc)
+		: _size(size), _crc(crc), _pos(0), _runningCRC(crc32(0, Z_NULL, 0)) {
+	}
+
+	/**
+	 * Adds the data read at the given member offset. Returns false if this
+	 * completed the member and its CRC does not match.
+	 */
+	bool update(const byte *data, uint32 pos, uint32 len) {
+		const uint32 end = pos + len;
+		if (pos > _pos || end <= _pos)
+			return true;
+
+		_runningCRC = crc32(_runningCRC, data + (_pos - pos), end - _pos);
+		_pos = end;
+
+		if (_pos == _size && _runningCRC != _crc) {
+			warning("Zip: CRC mismatch in archive member");
+			return false;
+		}
+		return true;
+	}
+
+private:
+	const uint32 _size;
+	const uint32 _crc;
+	uint32 _pos;			///< amount of data covered by _runningCRC
+	uLong _runningCRC;
+};
+
+#endif
+
+/**
+ * A stored (uncompressed) archive member. The archive stream is not
+ * repositioned before reads, so it must not be used by anything else while
+ * the member is read.
+ */
+class ZipStoredStream : public SeekableSubReadStream {
+public:
+	ZipStoredStream(SeekableReadStream *archiveStream, DisposeAfterUse::Flag disposeArchiveStream,
+	                uint32 dataStart, uint32 size, uint32 crc)
+		: SeekableSubReadStream(archiveStream, dataStart, dataStart + size, disposeArchiveStream),
+#ifdef USE_ZLIB
+		  _crcCheck(size, crc),
+#endif
+		  _crcErr(false) {
+	}
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		const uint32 start = pos();
+		const uint32 len = SeekableSubReadStream::read(dataPtr, dataSize);
+#ifdef USE_ZLIB
+		if (!_crcCheck.update((const byte *)dataPtr, start, len))
+			_crcErr = true;
+#endif
+		return len;
+	}
+
+	virtual bool err() const { return _crcErr || SeekableSubReadStream::err(); }
+	virtual void clearErr() { _crcErr = false; SeekableSubReadStream::clearErr(); }
+
+private:
+#ifdef USE_ZLIB
+	ZipCRCCheck _crcCheck;
+#endif
+	bool _crcErr;
+};
+
+#ifdef USE_ZLIB
+
+/**
+ * Inflates a deflated archive member on the fly.
+ *
+ * While the member is decompressed for the first time, a copy of the
+ * decompressor state is kept at regular intervals of the uncompressed data.
+ * Seeking restarts decompression from the closest of these checkpoints in
+ * front of the target position, so random access never has to go back to
+ * the start of the member. The CRC of the member is checked the first time
+ * its end is reached.
+ */
+class ZipInflateStream : public SeekableReadStream {
+public:
+	ZipInflateStream(SeekableReadStream *archiveStream, DisposeAfterUse::Flag disposeArchiveStream,
+	                 uint32 dataStart, uint32 compressedSize, uint32 size, uint32 crc);
+	~ZipInflateStream();
+
+	/** Initializes the decompressor, returns false on failure. */
+	bool init();
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize);
+	virtual bool eos() const { return _eos; }
+	virtual bool err() const { return _err; }
+	virtual void clearErr() { _eos = _err = false; }
+
+	virtual int32 pos() const { return _pos; }
+	virtual int32 size() const { return _size; }
+	virtual bool seek(int32 offset, int whence = SEEK_SET);
+
+private:
+	enum {
+		kInputBufferSize = 4096,
+		kMinCheckpointInterval = 256 * 1024,
+		kMaxCheckpoints = 32
+	};
+
+	/** Decompressor state at uncompressed offset (index + 1) * _checkpointInterval. */
+	struct Checkpoint {
+		uint32 inputPos;
+		z_stream *state;	///< allocated separately, zlib keeps a pointer back to it
+	};
+
+	bool fillInput();
+	uint32 inflateData(byte *dst, uint32 len);
+	bool restart(uint32 checkpoint);
+
+	DisposablePtr<SeekableReadStream> _archiveStream;
+	const uint32 _dataStart;
+	const uint32 _compressedSize;
+	const uint32 _size;
+
+	z_stream _zStream;
+	bool _initialized;
+	byte _inputBuffer[kInputBufferSize];
+	uint32 _inputPos;		///< compressed bytes handed to the decompressor so far
+
+	uint32 _pos;
+	uint32 _checkpointInterval;
+	Array<Checkpoint> _checkpoints;
+
+	ZipCRCCheck _crcCheck;
+
+	bool _eos;
+	bool _err;
+};
+
+ZipInflateStream::ZipInflateStream(SeekableReadStream *archiveStream, DisposeAfterUse::Flag disposeArchiveStream,
+                                   uint32 dataStart, uint32 compressedSize, uint32 size, uint32 crc)
+	: _archiveStream(archiveStream, disposeArchiveStream), _dataStart(dataStart),
+	  _compressedSize(compressedSize), _size(size), _initialized(false), _inputPos(0), _pos(0),
+	  _crcCheck(size, crc), _eos(false), _err(false) {
+	memset(&_zStream, 0, sizeof(_zStream));
+	_checkpointInterval = MAX<uint32>(kMinCheckpointInterval, size / kMaxCheckpoints + 1);
+}
+
+ZipInflateStream::~ZipInflateStream() {
+	if (_initialized)
+		inflateEnd(&_zStream);
+	for (uint i = 0; i < _checkpoints.size(); ++i) {
+		inflateEnd(_checkpoints[i].state);
+		delete _checkpoints[i].state;
+	}
+}
+
+bool ZipInflateStream::init() {
+	// Raw deflate data without zlib header, see unzOpenCurrentFile
+	_initialized = (inflateInit2(&_zStream, -MAX_WBITS) == Z_OK);
+	return _initialized;
+}
+
+bool ZipInflateStream::fillInput() {
+	if (_inputPos >= _compressedSize)
+		return true;
+
+	const uint32 len = MIN<uint32>(kInputBufferSize, _compressedSize - _inputPos);
+	if (!_archiveStream->seek(_dataStart + _inputPos, SEEK_SET) ||
+	    _archiveStream->read(_inputBuffer, len) != len) {
+		_err = true;
+		return false;
+	}
+
+	_zStream.next_in = _inputBuffer;
+	_zStream.avail_in = len;
+	_inputPos += len;
+	return true;
+}
+
+uint32 ZipInflateStream::inflateData(byte *dst, uint32 len) {
+	uint32 done = 0;
+
+	while (done < len && !_err) {
+		// Stop at the next checkpoint position if it has not been recorded yet
+		uint32 chunk = len - done;
+		const uint32 nextCheckpoint = (_checkpoints.size() + 1) * _checkpointInterval;
+		if (_pos < nextCheckpoint && _pos + chunk > nextCheckpoint)
+			chunk = nextCheckpoint - _pos;
+
+		if (_zStream.avail_in == 0 && !fillInput())
+			break;
+
+		_zStream.next_out = dst + done;
+		_zStream.avail_out = chunk;
+		const int result = inflate(&_zStream, Z_SYNC_FLUSH);
+		const uint32 produced = chunk - _zStream.avail_out;
+
+		if (!_crcCheck.update(dst + done, _pos, produced))
+			_err = true;
+		_pos += produced;
+		done += produced;
+
+		if (_pos == nextCheckpoint && _pos < _size) {
+			Checkpoint checkpoint;
+			checkpoint.inputPos = _inputPos - _zStream.avail_in;
+			checkpoint.state = new z_stream;
+			if (inflateCopy(checkpoint.state, &_zStream) == Z_OK)
+				_checkpoints.push_back(checkpoint);
+			else
+				delete checkpoint.state;
+		}
+
+		// The member ends before its recorded size, or the data is corrupt
+		if ((result != Z_OK || produced == 0) && done < len) {
+			warning("ZipInflateStream: Failed to inflate archive member");
+			_err = true;
+		}
+	}
+
+	return done;
+}
+
+bool ZipInflateStream::restart(uint32 checkpoint) {
+	_zStream.avail_in = 0;
+
+	if (checkpoint == 0) {
+		if (inflateReset(&_zStream) != Z_OK)
+			return false;
+		_inputPos = 0;
+		_pos = 0;
+		return true;
+	}
+
+	inflateEnd(&_zStream);
+	_initialized = (inflateCopy(&_zStream, _checkpoints[checkpoint - 1].state) == Z_OK);
+	if (!_initialized)
+		return false;
+
+	_zStream.avail_in = 0;
+	_inputPos = _checkpoints[checkpoint - 1].inputPos;
+	_pos = checkpoint * _checkpointInterval;
+	return true;
+}
+
+uint32 ZipInflateStream::read(void *dataPtr, uint32 dataSize) {
+	if (_err)
+		return 0;
+
+	uint32 len = dataSize;
+	if (len > _size - _pos) {
+		len = _size - _pos;
+		_eos = true;
+	}
+
+	return inflateData((byte *)dataPtr, len);
+}
+
+bool ZipInflateStream::seek(int32 offset, int whence) {
+	int32 target;
+	switch (whence) {
+	case SEEK_END:
+		target = _size + offset;
+		break;
+	case SEEK_SET:
+		target = offset;
+		break;
+	case SEEK_CUR:
+	default:
+		target = _pos + offset;
+		break;
+	}
+
+	if (target < 0 || target > (int32)_size || _err)
+		return false;
+
+	_eos = false;
+
+	// Use the closest checkpoint in front of the target, unless we can get
+	// there cheaper by decompressing from the current position.
+	const uint32 checkpoint = MIN<uint32>(target / _checkpointInterval, _checkpoints.size());
+	if ((uint32)target < _pos || checkpoint * _checkpointInterval > _pos) {
+		if (!restart(checkpoint)) {
+			_err = true;
+			return false;
+		}
+	}
+
+	byte buffer[kInputBufferSize];
+	while (_pos < (uint32)target && !_err)
+		inflateData(buffer, MIN<uint32>(sizeof(buffer), target - _pos));
+
+	return !_err;
+}
+
+#endif
+
+/**
+ * The stream of an archive, shared by the archive and the streams of its
+ * members through ZipSharedStream views. The stream is only accessed with
+ * the mutex held, so the views can be read on different threads. It is
+ * deleted together with its last user, so member streams stay valid after
+ * their archive was deleted.
+ */
+class ZipSharedArchiveStream {
+public:
+	/** Takes ownership of the stream, the creator is the first user. */
+	explicit ZipSharedArchiveStream(SeekableReadStream *stream)
+		: _stream(stream), _size(stream->size()), _users(1) {
+	}
+
+	void addUser() {
+		StackLock lock(_mutex);
+		++_users;
+	}
+
+	void removeUser() {
+		bool last;
+		{
+			StackLock lock(_mutex);
+			last = (--_users == 0);
+		}
+		if (last)
+			delete this;
+	}
+
+	int32 size() const { return _size; }
+
+	/**
+	 * Reads from the given position of the stream.
+	 *
+	 * @param err	set to true if the stream failed
+	 * @return number of bytes read
+	 */
+	uint32 read(uint32 pos, void *dataPtr, uint32 dataSize, bool &err) {
+		StackLock lock(_mutex);
+
+		uint32 len = 0;
+		if (_stream->seek(pos, SEEK_SET))
+			len = _stream->read(dataPtr, dataSize);
+
+		err = _stream->err();
+		_stream->clearErr();
+		return len;
+	}
+
+private:
+	~ZipSharedArchiveStream() {
+		delete _stream;
+	}
+
+	SeekableReadStream *const _stream;
+	const int32 _size;
+	uint _users;
+	Mutex _mutex;
+};
+
+/**
+ * A view with its own position on a shared archive stream.
+ */
+class ZipSharedStream : public SeekableReadStream {
+public:
+	explicit ZipSharedStream(ZipSharedArchiveStream *archiveStream)
+		: _archiveStream(archiveStream), _pos(0), _eos(false), _err(false) {
+		_archiveStream->addUser();
+	}
+
+	~ZipSharedStream() {
+		_archiveStream->removeUser();
+	}
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		bool err = false;
+		const uint32 len = _archiveStream->read(_pos, dataPtr, dataSize, err);
+		_pos += len;
+
+		if (err)
+			_err = true;
+		else if (len < dataSize)
+			_eos = true;
+		return len;
+	}
+
+	virtual bool eos() const { return _eos; }
+	virtual bool err() const { return _err; }
+	virtual void clearErr() { _eos = _err = false; }
+
+	virtual int32 pos() const { return _pos; }
+	virtual int32 size() const { return _archiveStream->size(); }
+
+	virtual bool seek(int32 offset, int whence = SEEK_SET) {
+		int32 target;
+		switch (whence) {
+		case SEEK_END:
+			target = size() + offset;
+			break;
+		case SEEK_CUR:
+			target = _pos + offset;
+			break;
+		case SEEK_SET:
+		default:
+			target = offset;
+			break;
+		}
+
+		if (target < 0 || target > size())
+			return false;
+
+		_pos = target;
+		_eos = false;
+		return true;
+	}
+
+private:
+	ZipSharedArchiveStream *const _archiveStream;
+	uint32 _pos;
+	bool _eos;
+	bool _err;
+};
+
+/**
+ * Creates a stream for an archive member from its data in the archive
+ * stream. Returns 0 if the member cannot be decompressed.
+ */
+SeekableReadStream *createMemberStream(SeekableReadStream *archiveStream, DisposeAfterUse::Flag disposeArchiveStream,
+                                       uint32 dataStart, const unz_file_info &fileInfo) {
+	if (fileInfo.compression_method == 0)
+		return new ZipStoredStream(archiveStream, disposeArchiveStream, dataStart,
+		                           fileInfo.uncompressed_size, fileInfo.crc);
+
+#ifdef USE_ZLIB
+	ZipInflateStream *stream = new ZipInflateStream(archiveStream, disposeArchiveStream, dataStart,
+	                                                fileInfo.compressed_size, fileInfo.uncompressed_size, fileInfo.crc);
+	if (!stream->init()) {
+		delete stream;
+		return 0;
+	}
+	return stream;
+#else
+	// Cannot decompress the member without zlib
+	if (disposeArchiveStream == DisposeAfterUse::YES)
+		delete archiveStream;
+	return 0;
+#endif
+}
+
+} // End of anonymous namespace
 
 class ZipArchive : public Archive {
 	unzFile _zipFile;
+	ZipSharedArchiveStream *_stream;
+	FSNode _node;
+
+	/** Guards resolving the data offsets of the members */
+	mutable Mutex _dataOffsetMutex;
+
+	uint32 getDataOffset(cached_file_in_zip &entry) const;
 
 public:
-	ZipArchive(unzFile zipFile);
+	ZipArchive(unzFile zipFile, SeekableReadStream *stream, const FSNode &node);
 
 
 	~ZipArchive();
@@ -1453,16 +1950,20 @@ public:
 };
 */
 
-ZipArchive::ZipArchive(unzFile zipFile) : _zipFile(zipFile) {
+ZipArchive::ZipArchive(unzFile zipFile, SeekableReadStream *stream, const FSNode &node)
+	: _zipFile(zipFile), _stream(new ZipSharedArchiveStream(stream)), _node(node) {
 	assert(_zipFile);
 }
 
 ZipArchive::~ZipArchive() {
+	// unzClose() only deletes its view on the archive stream. The stream
+	// itself lives on while member streams still read from it.
 	unzClose(_zipFile);
+	_stream->removeUser();
 }
 
 bool ZipArchive::hasFile(const String &name) const {
-	return (unzLocateFile(_zipFile, name.c_str(), 2) == UNZ_OK);
+	return ((const unz_s *)_zipFile)->_hash.contains(name);
 }
 
 int ZipArchive::listMembers(ArchiveMemberList &list) const {
@@ -1485,56 +1986,95 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 	return ArchiveMemberPtr(new GenericArchiveMember(name, this));
 }
 
+uint32 ZipArchive::getDataOffset(cached_file_in_zip &entry) const {
+	StackLock lock(_dataOffsetMutex);
+
+	if (entry.data_offset == UNZ_UNKNOWN_OFFSET) {
+		const unz_s *const archive = (const unz_s *)_zipFile;
+		ZipSharedStream stream(_stream);
+		entry.data_offset = unzlocal_GetFileDataOffset(&stream,
+			entry.cur_file_info_internal.offset_curfile + archive->byte_before_the_zipfile);
+	}
+
+	return entry.data_offset;
+}
+
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
-	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
+	unz_s *const archive = (unz_s *)_zipFile;
+	ZipHash::iterator member = archive->_hash.find(name);
+	if (member == archive->_hash.end())
+		return 0;
+
+	// The unzip state is not touched here, the data offset is resolved
+	// from the local header on the first access.
+	cached_file_in_zip &entry = member->_value;
+	const unz_file_info &fileInfo = entry.cur_file_info;
+	const uint32 dataStart = getDataOffset(entry);
+	if (!dataStart)
 		return 0;
 
-	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
+	if (fileInfo.compression_method == 0 && fileInfo.uncompressed_size != fileInfo.compressed_size)
 		return 0;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+	// Larger members are streamed. Archives opened from a file give each of
+	// them an own handle on the file, so they do not have to take turns on
+	// the shared archive stream.
+	if (fileInfo.uncompressed_size > kMaxInMemorySize) {
+		SeekableReadStream *archiveStream = _node.createReadStream();
+		if (!archiveStream)
+			archiveStream = new ZipSharedStream(_stream);
+		return createMemberStream(archiveStream, DisposeAfterUse::YES, dataStart, fileInfo);
+	}
+
+	// Smaller members are read into memory right away
+	SeekableReadStream *stream = createMemberStream(new ZipSharedStream(_stream), DisposeAfterUse::YES, dataStart, fileInfo);
+	if (!stream)
 		return 0;
 
 	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
 	assert(buffer);
 
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
-		return 0;
-	}
+	// Reading up to the end also verifies the CRC
+	const uint32 size = stream->read(buffer, fileInfo.uncompressed_size);
+	const bool success = (size == fileInfo.uncompressed_size && !stream->err());
+	delete stream;
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
+	if (!success) {
 		free(buffer);
 		return 0;
 	}
 
 	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+}
+
+namespace {
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+Archive *createZipArchive(SeekableReadStream *stream, const FSNode &node) {
+	if (!stream)
+		return 0;
+	unzFile zipFile = unzOpen(new SeekableSubReadStream(stream, 0, stream->size(), DisposeAfterUse::NO));
+	if (!zipFile) {
+		// The view gets deleted by unzOpen() call if something
+		// goes wrong, but not the stream itself.
+		delete stream;
+		return 0;
+	}
+	return new ZipArchive(zipFile, stream, node);
 }
 
+} // End of anonymous namespace
+
 Archive *makeZipArchive(const String &name) {
 	return makeZipArchive(SearchMan.createReadStreamForMember(name));
 }
 
 Archive *makeZipArchive(const FSNode &node) {
-	return makeZipArchive(node.createReadStream());
+	// Members of archives opened from a file can be streamed
+	return createZipArchive(node.createReadStream(), node);
 }
 
 Archive *makeZipArchive(SeekableReadStream *stream) {
-	if (!stream)
-		return 0;
-	unzFile zipFile = unzOpen(stream);
-	if (!zipFile) {
-		// stream gets deleted by unzOpen() call if something
-		// goes wrong.
-		return 0;
-	}
-	return new ZipArchive(zipFile);
+	return createZipArchive(stream, FSNode());
 }
 
 } // End of namespace Common
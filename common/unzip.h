@@ -50,8 +50,9 @@ Archive *makeZipArchive(const FSNode &node);
 /**
  * This factory method creates an Archive instance corresponding to the content
  * of the given ZIP compressed datastream.
- * This takes ownership of the stream,  in particular, it is deleted when the
- * ZipArchive is deleted.
+ * This takes ownership of the stream. Larger members are streamed from it, so
+ * it is deleted together with the last of the ZipArchive and its member
+ * streams. All accesses to it are serialized by the archive.
  *
  * May return 0 in case of a failure. In this case stream will still be deleted.
  */
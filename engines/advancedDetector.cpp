@@ -31,6 +31,7 @@
 #include "common/translation.h"
 #include "gui/EventRecorder.h"
 #include "engines/advancedDetector.h"
+#include "engines/detectioncache.h"
 #include "engines/obsolete.h"
 
 static GameDescriptor toGameDescriptor(const ADGameDescription &g, const PlainGameDescriptor *sg) {
@@ -148,16 +149,56 @@ bool cleanupPirated(ADGameDescList &matched) {
 }
 
 
+AdvancedMetaEngine::FileMapCache *AdvancedMetaEngine::_fileMapCache = 0;
+
+void AdvancedMetaEngine::beginDetectionRun() {
+	endDetectionRun();
+	_fileMapCache = new FileMapCache();
+}
+
+void AdvancedMetaEngine::endDetectionRun() {
+	if (!_fileMapCache)
+		return;
+
+	for (FileMapCache::iterator i = _fileMapCache->begin(); i != _fileMapCache->end(); ++i)
+		delete i->_value;
+	delete _fileMapCache;
+	_fileMapCache = 0;
+}
+
 GameList AdvancedMetaEngine::detectGames(const Common::FSList &fslist) const {
 	ADGameDescList matches;
 	GameList detectedGames;
-	FileMap allFiles;
+	FileMap localFiles;
 
 	if (fslist.empty())
 		return detectedGames;
 
-	// Compose a hashmap of all files in fslist.
-	composeFileHashMap(allFiles, fslist, (_maxScanDepth == 0 ? 1 : _maxScanDepth));
+	const int depth = (_maxScanDepth == 0 ? 1 : _maxScanDepth);
+
+	// Compose a hashmap of all files in fslist. During a detection run, the
+	// map is shared by all engines which scan the directory the same way.
+	FileMap *cachedFiles = 0;
+	if (_fileMapCache) {
+		Common::String key = Common::String::format("%d", depth);
+		if (_directoryGlobs) {
+			for (const char * const *glob = _directoryGlobs; *glob; glob++)
+				key += Common::String(":") + *glob;
+		}
+
+		FileMapCache::iterator i = _fileMapCache->find(key);
+		if (i != _fileMapCache->end()) {
+			cachedFiles = i->_value;
+		} else {
+			cachedFiles = new FileMap();
+			composeFileHashMap(*cachedFiles, fslist, depth);
+			(*_fileMapCache)[key] = cachedFiles;
+		}
+	} else {
+		composeFileHashMap(localFiles, fslist, depth);
+	}
+
+	const FileMap &allFiles = cachedFiles ? *cachedFiles : localFiles;
 
 	// Run the detector on this
 	matches = detectGame(fslist.begin()->getParent(), allFiles, Common::UNK_LANG, Common::kPlatformUnknown, "");
@@ -395,21 +436,41 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 		if (!macResMan.open(parent, fname))
 			return false;
 
-		fileProps.md5 = macResMan.computeResForkMD5AsString(_md5Bytes);
+		// The resource fork can come from several files, so the cache entry
+		// has no modification time and only lives for this session.
+		const Common::String cacheName = parent.getPath() + "/" + fname + ":rsrc";
 		fileProps.size = macResMan.getResForkDataSize();
+		if (!DetectionCacheMan.lookup(cacheName, fileProps.size, 0, _md5Bytes, fileProps.md5)) {
+			fileProps.md5 = macResMan.computeResForkMD5AsString(_md5Bytes);
+			DetectionCacheMan.store(cacheName, fileProps.size, 0, _md5Bytes, fileProps.md5);
+		}
 		return true;
 	}
 
 	if (!allFiles.contains(fname))
 		return false;
 
-	Common::File testFile;
+	const Common::FSNode &node = allFiles[fname];
+
+	// Check the cache before opening the file, if the backend can tell the
+	// size of a file without opening it
+	const uint32 mtime = node.getModificationTime();
+	const int32 size = node.getFileSize();
+	if (size >= 0 && DetectionCacheMan.lookup(node.getPath(), size, mtime, _md5Bytes, fileProps.md5)) {
+		fileProps.size = size;
+		return true;
+	}
 
-	if (!testFile.open(allFiles[fname]))
+	Common::File testFile;
+	if (!testFile.open(node))
 		return false;
 
+	// If the size was known, the cache has been checked already
 	fileProps.size = (int32)testFile.size();
-	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+	if (size >= 0 || !DetectionCacheMan.lookup(node.getPath(), fileProps.size, mtime, _md5Bytes, fileProps.md5)) {
+		fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+		DetectionCacheMan.store(node.getPath(), fileProps.size, mtime, _md5Bytes, fileProps.md5);
+	}
 	return true;
 }
 
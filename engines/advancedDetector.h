@@ -268,6 +268,24 @@ public:
 
 	virtual const ExtraGuiOptions getExtraGuiOptions(const Common::String &target) const;
 
+	/**
+	 * Starts a detection run over a single directory. Until endDetectionRun
+	 * is called, all engines with the same scan depth and directory globs
+	 * share one file map of the directory, instead of each listing it (and
+	 * its subdirectories) again. EngineManager::detectGames takes care of
+	 * this, the file system must not change during a run.
+	 *
+	 * The engines still run one after another on the calling thread, and
+	 * the shared file maps are not locked. MD5 sums are not computed in
+	 * parallel either; repeated hashing is avoided by DetectionCache.
+	 */
+	static void beginDetectionRun();
+
+	/**
+	 * Ends a detection run and frees the shared file maps.
+	 */
+	static void endDetectionRun();
+
 protected:
 	// To be implemented by subclasses
 	virtual bool createInstance(OSystem *syst, Engine **engine, const ADGameDescription *desc) const = 0;
@@ -285,6 +303,10 @@ protected:
 private:
 	void initSubSystems(const ADGameDescription *gameDesc) const;
 
+	typedef Common::HashMap<Common::String, FileMap *> FileMapCache;
+	/** File maps shared during a detection run, 0 outside of a run */
+	static FileMapCache *_fileMapCache;
+
 protected:
 	/**
 	 * Detect games in specified directory.
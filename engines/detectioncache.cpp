@@ -0,0 +1,197 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/detectioncache.h"
+
+#include "common/debug.h"
+#include "common/endian.h"
+#include "common/fs.h"
+#include "common/stream.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Common {
+DECLARE_SINGLETON(DetectionCache);
+}
+
+static const char *const kCacheFileName = "detection.cache";
+
+enum {
+	kCacheMagic = MKTAG('D', 'C', 'C', 'H'),
+	kCacheVersion = 1
+};
+
+DetectionCache::DetectionCache() : _useDefaultDirectory(true), _loaded(false), _dirty(false) {
+}
+
+DetectionCache::DetectionCache(const Common::String &directory) :
+	_directory(directory), _useDefaultDirectory(false), _loaded(false), _dirty(false) {
+}
+
+DetectionCache::~DetectionCache() {
+}
+
+Common::String DetectionCache::makeKey(const Common::String &path, uint32 md5Bytes) {
+	return Common::String::format("%u:", md5Bytes) + path;
+}
+
+bool DetectionCache::lookup(const Common::String &path, int32 size, uint32 mtime, uint32 md5Bytes, Common::String &md5) {
+	if (!_loaded)
+		load();
+
+	EntryMap::const_iterator i = _entries.find(makeKey(path, md5Bytes));
+	if (i == _entries.end())
+		return false;
+
+	// A changed file invalidates the entry
+	if (i->_value.size != size || i->_value.mtime != mtime)
+		return false;
+
+	md5 = i->_value.md5;
+	return true;
+}
+
+void DetectionCache::store(const Common::String &path, int32 size, uint32 mtime, uint32 md5Bytes, const Common::String &md5) {
+	if (!_loaded)
+		load();
+
+	Entry &entry = _entries[makeKey(path, md5Bytes)];
+	entry.path = path;
+	entry.size = size;
+	entry.mtime = mtime;
+	entry.md5Bytes = md5Bytes;
+	entry.md5 = md5;
+
+	// Entries without modification time are not written to disk
+	if (mtime)
+		_dirty = true;
+}
+
+void DetectionCache::load() {
+	_loaded = true;
+
+	if (_useDefaultDirectory)
+		_directory = g_system->getDefaultCachePath();
+	if (_directory.empty())
+		return;
+
+	Common::SeekableReadStream *file = Common::FSNode(_directory).getChild(kCacheFileName).createReadStream();
+	if (!file)
+		return;
+
+	// The header has 12 bytes
+	if (file->size() < 12) {
+		debug(2, "DetectionCache: Ignoring truncated cache file");
+		delete file;
+		return;
+	}
+
+	// Parse the cache from memory instead of reading it byte by byte
+	Common::SeekableReadStream *data = file->readStream(file->size());
+	delete file;
+
+	if (data->readUint32BE() != kCacheMagic || data->readUint32LE() != kCacheVersion) {
+		debug(2, "DetectionCache: Ignoring cache file with unknown format");
+		delete data;
+		return;
+	}
+
+	const char *const start = (const char *)data->getDirectData();
+	const uint32 count = data->readUint32LE();
+	for (uint32 i = 0; i < count; ++i) {
+		Entry entry;
+
+		// The path is followed by 13 bytes up to the MD5 sum
+		const uint16 pathLength = data->readUint16LE();
+		if (data->eos() || data->pos() + pathLength + 13 > data->size())
+			break;
+		entry.path = Common::String(start + data->pos(), pathLength);
+		data->skip(pathLength);
+
+		entry.size = data->readSint32LE();
+		entry.mtime = data->readUint32LE();
+		entry.md5Bytes = data->readUint32LE();
+
+		const byte md5Length = data->readByte();
+		if (data->pos() + md5Length > data->size())
+			break;
+		entry.md5 = Common::String(start + data->pos(), md5Length);
+		data->skip(md5Length);
+
+		_entries[makeKey(entry.path, entry.md5Bytes)] = entry;
+	}
+
+	debug(2, "DetectionCache: Loaded %d entries", _entries.size());
+	delete data;
+}
+
+void DetectionCache::flush() {
+	if (!_dirty)
+		return;
+	_dirty = false;
+
+	if (_directory.empty())
+		return;
+
+	// Forget files which were removed since they were hashed. Erasing
+	// does not invalidate the other iterators of a HashMap.
+	uint32 count = 0;
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (!i->_value.mtime)
+			continue;
+
+		if (Common::FSNode(i->_value.path).exists())
+			++count;
+		else
+			_entries.erase(i);
+	}
+
+	const Common::FSNode node = Common::FSNode(_directory).getChild(kCacheFileName);
+	Common::WriteStream *file = node.createWriteStream();
+	if (!file) {
+		warning("DetectionCache: Could not write '%s'", node.getPath().c_str());
+		return;
+	}
+
+	file->writeUint32BE(kCacheMagic);
+	file->writeUint32LE(kCacheVersion);
+	file->writeUint32LE(count);
+
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		const Entry &entry = i->_value;
+		if (!entry.mtime)
+			continue;
+
+		file->writeUint16LE(entry.path.size());
+		file->writeString(entry.path);
+		file->writeSint32LE(entry.size);
+		file->writeUint32LE(entry.mtime);
+		file->writeUint32LE(entry.md5Bytes);
+		file->writeByte(entry.md5.size());
+		file->writeString(entry.md5);
+	}
+
+	file->finalize();
+	if (file->err())
+		warning("DetectionCache: Error while writing '%s'", node.getPath().c_str());
+	delete file;
+}
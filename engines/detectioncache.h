@@ -0,0 +1,108 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_DETECTIONCACHE_H
+#define ENGINES_DETECTIONCACHE_H
+
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+/**
+ * Cache for the MD5 sums computed while detecting games.
+ *
+ * During detection, every engine hashes the files it is interested in, and
+ * many engines look at the same files (e.g. a generic data file name). With
+ * mass add, the same files are hashed again on every run. This cache stores
+ * the MD5 sums by file path, size, modification time and number of hashed
+ * bytes, for the whole process and in a file in the cache directory of the
+ * port (see OSystem::getDefaultCachePath), so each file only has to be read
+ * once as long as it does not change.
+ *
+ * Only files with a known modification time are stored on disk. Other
+ * entries, e.g. for Mac resource forks which may come from several files or
+ * for file systems without modification times, are only kept in memory.
+ */
+class DetectionCache : public Common::Singleton<DetectionCache> {
+public:
+	/**
+	 * Creates a cache which is stored in the given directory. The global
+	 * instance uses the cache directory of the port instead.
+	 *
+	 * @param directory	directory of the cache file, empty to only keep
+	 *					the cache in memory
+	 */
+	explicit DetectionCache(const Common::String &directory);
+	~DetectionCache();
+
+	/**
+	 * Looks up the MD5 sum of a file.
+	 *
+	 * @param path		path of the file, or any other unique name for it
+	 * @param size		current size of the file
+	 * @param mtime		current modification time, 0 if unknown
+	 * @param md5Bytes	number of bytes hashed, 0 for the whole file
+	 * @param md5		receives the MD5 sum on success
+	 * @return true if the cache has a valid entry
+	 */
+	bool lookup(const Common::String &path, int32 size, uint32 mtime, uint32 md5Bytes, Common::String &md5);
+
+	/**
+	 * Stores the MD5 sum of a file, see lookup for the parameters.
+	 */
+	void store(const Common::String &path, int32 size, uint32 mtime, uint32 md5Bytes, const Common::String &md5);
+
+	/**
+	 * Writes the cache file if there are new entries. Entries of files
+	 * which do not exist anymore are dropped.
+	 */
+	void flush();
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	DetectionCache();
+
+	void load();
+	static Common::String makeKey(const Common::String &path, uint32 md5Bytes);
+
+	struct Entry {
+		Common::String path;
+		int32 size;
+		uint32 mtime;
+		uint32 md5Bytes;
+		Common::String md5;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+	EntryMap _entries;
+
+	Common::String _directory;
+	bool _useDefaultDirectory;
+	bool _loaded;
+	bool _dirty;
+};
+
+/** Shortcut for accessing the detection cache. */
+#define DetectionCacheMan DetectionCache::instance()
+
+#endif
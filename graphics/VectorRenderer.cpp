@@ -32,8 +32,7 @@ namespace Graphics {
 /********************************************************************
  * DRAWSTEP handling functions
  ********************************************************************/
-void VectorRenderer::drawStep(const Common::Rect &area, const DrawStep &step, uint32 extra) {
-
+void VectorRenderer::setupStep(const DrawStep &step, uint32 extra) {
 	if (step.bgColor.set)
 		setBgColor(step.bgColor.r, step.bgColor.g, step.bgColor.b);
 
@@ -54,33 +53,17 @@ void VectorRenderer::drawStep(const Common::Rect &area, const DrawStep &step, ui
 	setFillMode((FillMode)step.fillMode);
 
 	_dynamicData = extra;
+}
+
+void VectorRenderer::drawStep(const Common::Rect &area, const DrawStep &step, uint32 extra) {
+	setupStep(step, extra);
 
 	Common::Rect noClip = Common::Rect(0, 0, 0, 0);
 	(this->*(step.drawingCall))(area, step, noClip);
 }
 
 void VectorRenderer::drawStepClip(const Common::Rect &area, const Common::Rect &clip, const DrawStep &step, uint32 extra) {
-
-	if (step.bgColor.set)
-		setBgColor(step.bgColor.r, step.bgColor.g, step.bgColor.b);
-
-	if (step.fgColor.set)
-		setFgColor(step.fgColor.r, step.fgColor.g, step.fgColor.b);
-
-	if (step.bevelColor.set)
-		setBevelColor(step.bevelColor.r, step.bevelColor.g, step.bevelColor.b);
-
-	if (step.gradColor1.set && step.gradColor2.set)
-		setGradientColors(step.gradColor1.r, step.gradColor1.g, step.gradColor1.b,
-			step.gradColor2.r, step.gradColor2.g, step.gradColor2.b);
-
-	setShadowOffset(_disableShadows ? 0 : step.shadow);
-	setBevel(step.bevel);
-	setGradientFactor(step.factor);
-	setStrokeWidth(step.stroke);
-	setFillMode((FillMode)step.fillMode);
-
-	_dynamicData = extra;
+	setupStep(step, extra);
 
 	(this->*(step.drawingCall))(area, step, clip);
 }
@@ -289,6 +289,13 @@ public:
 		_activeSurface = surface;
 	}
 
+	/**
+	 * Returns the active drawing surface.
+	 */
+	TransparentSurface *getSurface() const {
+		return _activeSurface;
+	}
+
 	/**
 	 * Fills the active surface with the specified fg/bg color or the active gradient.
 	 * Defaults to using the active Foreground color for filling.
@@ -451,6 +458,42 @@ public:
 	virtual void drawStep(const Common::Rect &area, const DrawStep &step, uint32 extra = 0);
 	virtual void drawStepClip(const Common::Rect &area, const Common::Rect &clip, const DrawStep &step, uint32 extra = 0);
 
+	/**
+	 * Sets up the colors and drawing options of a draw step, without
+	 * drawing anything. drawStep and drawStepClip call this first.
+	 *
+	 * @param step The DrawStep to set up.
+	 * @param extra Dynamic data from the GUI theme.
+	 */
+	void setupStep(const DrawStep &step, uint32 extra = 0);
+
+	/**
+	 * The settings a draw step inherits from the steps drawn before it.
+	 * A DrawStep only changes the colors it explicitly sets.
+	 */
+	struct InheritedState {
+		uint32 fgColor, bgColor, bevelColor;
+		uint32 gradientStart, gradientEnd;
+		ShadowFillMode shadowFillMode;
+		bool disableShadows;
+
+		bool operator==(const InheritedState &state) const {
+			return fgColor == state.fgColor && bgColor == state.bgColor && bevelColor == state.bevelColor
+			    && gradientStart == state.gradientStart && gradientEnd == state.gradientEnd
+			    && shadowFillMode == state.shadowFillMode && disableShadows == state.disableShadows;
+		}
+	};
+
+	/**
+	 * Queries the settings the next draw step would inherit.
+	 */
+	virtual void getInheritedState(InheritedState &state) const {
+		state.fgColor = state.bgColor = state.bevelColor = 0;
+		state.gradientStart = state.gradientEnd = 0;
+		state.shadowFillMode = _shadowFillMode;
+		state.disableShadows = _disableShadows;
+	}
+
 	/**
 	 * Copies the part of the current frame to the system overlay.
 	 *
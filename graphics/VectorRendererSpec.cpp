@@ -33,6 +33,11 @@
 #include "graphics/VectorRenderer.h"
 #include "graphics/VectorRendererSpec.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VECTOR_RENDERER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #define VECTOR_RENDERER_FAST_TRIANGLES
 
 /** Fixed point SQUARE ROOT **/
@@ -443,8 +448,22 @@ namespace Graphics {
  */
 template<typename PixelType>
 void colorFill(PixelType *first, PixelType *last, PixelType color) {
+#ifdef VECTOR_RENDERER_USE_SSE2
+	const int step = 16 / sizeof(PixelType);
+	if (last - first >= 2 * step && !((size_t)first & (sizeof(PixelType) - 1))) {
+		// Align the destination, then store whole vectors
+		while ((size_t)first & 15)
+			*first++ = color;
+
+		const __m128i pattern = (sizeof(PixelType) == 4) ? _mm_set1_epi32((int)color) : _mm_set1_epi16((short)color);
+		PixelType *end = first + ((last - first) & ~(step - 1));
+		for (; first != end; first += step)
+			_mm_store_si128((__m128i *)first, pattern);
+	}
+#endif
+
 	register int count = (last - first);
-	if (!count)
+	if (count <= 0)
 		return;
 	register int n = (count + 7) >> 3;
 	switch (count % 8) {
@@ -461,45 +480,129 @@ void colorFill(PixelType *first, PixelType *last, PixelType color) {
 	}
 }
 
+/**
+ * Fills several pixels in a row with two alternating colors, as used by
+ * the dithered gradients.
+ *
+ * @param first Pointer to the first pixel to fill.
+ * @param last Pointer to the last pixel to fill.
+ * @param color1 Color of the first pixel and every second pixel after it.
+ * @param color2 Color of the pixels in between.
+ */
 template<typename PixelType>
-void colorFillClip(PixelType *first, PixelType *last, PixelType color, int realX, int realY, Common::Rect &clippingArea) {
-	if (realY < clippingArea.top || realY >= clippingArea.bottom)
+void patternFill(PixelType *first, PixelType *last, PixelType color1, PixelType color2) {
+	if (color1 == color2) {
+		colorFill<PixelType>(first, last, color1);
 		return;
+	}
 
-	register int count = (last - first);
-
-	if (realX > clippingArea.right || realX + count < clippingArea.left)
-		return;
+#ifdef VECTOR_RENDERER_USE_SSE2
+	const int step = 16 / sizeof(PixelType);
+	if (last - first >= 2 * step && !((size_t)first & (sizeof(PixelType) - 1))) {
+		while ((size_t)first & 15) {
+			*first++ = color1;
+			SWAP(color1, color2);
+		}
 
-	if (realX < clippingArea.left) {
-		register int diff = (clippingArea.left - realX);
-		realX += diff;
-		count -= diff;
+		// A vector holds an even number of pixels, so the pattern is the
+		// same for all of them
+		const __m128i pattern = (sizeof(PixelType) == 4)
+		                        ? _mm_set_epi32((int)color2, (int)color1, (int)color2, (int)color1)
+		                        : _mm_set1_epi32((int)(color1 | (color2 << 16)));
+		PixelType *end = first + ((last - first) & ~(step - 1));
+		for (; first != end; first += step)
+			_mm_store_si128((__m128i *)first, pattern);
 	}
+#endif
 
-	if (clippingArea.right <= realX + count) {
-		register int diff = (realX + count - clippingArea.right);
-		count -= diff;
+	while (first < last) {
+		*first++ = color1;
+		SWAP(color1, color2);
 	}
+}
 
-	if (!count)
+template<typename PixelType>
+void colorFillClip(PixelType *first, PixelType *last, PixelType color, int realX, int realY, Common::Rect &clippingArea) {
+	if (realY < clippingArea.top || realY >= clippingArea.bottom)
 		return;
 
-	register int n = (count + 7) >> 3;
-	switch (count % 8) {
-	case 0: do {
-		*first++ = color;
-	case 7:		*first++ = color;
-	case 6:		*first++ = color;
-	case 5:		*first++ = color;
-	case 4:		*first++ = color;
-	case 3:		*first++ = color;
-	case 2:		*first++ = color;
-	case 1:		*first++ = color;
-	} while (--n > 0);
+	int start = MAX(clippingArea.left - realX, 0);
+	int end = MIN<int>(clippingArea.right - realX, last - first);
+
+	if (start < end)
+		colorFill<PixelType>(first + start, first + end, color);
+}
+
+#ifdef VECTOR_RENDERER_USE_SSE2
+/**
+ * Blends a row of 32 bit pixels with a color, for formats whose channels
+ * are whole bytes. Gives the same results as blendPixelPtr.
+ *
+ * @param color The color, with the alpha channel (if any) fully opaque
+ * @param mask The mask of all color channels
+ * @return Pointer to the first pixel left to blend.
+ */
+static uint32 *blendSpan(uint32 *first, uint32 *last, uint32 color, uint32 mask, uint8 alpha) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i srcColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)color), zero);
+
+	// d + ((s - d) * a >> 8) == (d * (256 - a) + s * a) >> 8, which fits in
+	// 16 bits for all inputs.
+	const __m128i srcPart = _mm_mullo_epi16(_mm_unpacklo_epi64(srcColor, srcColor), _mm_set1_epi16((short)alpha));
+	const __m128i dstFactor = _mm_set1_epi16((short)(256 - alpha));
+	const __m128i channelMask = _mm_set1_epi32((int)mask);
+
+	for (; last - first >= 4; first += 4) {
+		__m128i dst = _mm_loadu_si128((const __m128i *)first);
+		__m128i lo = _mm_unpacklo_epi8(dst, zero);
+		__m128i hi = _mm_unpackhi_epi8(dst, zero);
+
+		lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, dstFactor), srcPart), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, dstFactor), srcPart), 8);
+
+		_mm_storeu_si128((__m128i *)first, _mm_and_si128(_mm_packus_epi16(lo, hi), channelMask));
 	}
+
+	return first;
 }
 
+/**
+ * Blends a row of 16 bit pixels with a color. Gives the same results as
+ * blendPixelPtr.
+ *
+ * @param color The color, with the alpha channel (if any) fully opaque
+ * @return Pointer to the first pixel left to blend.
+ */
+static uint16 *blendSpan(uint16 *first, uint16 *last, uint16 color, const PixelFormat &format, uint8 alpha) {
+	const int channels = format.aBits() ? 4 : 3;
+	const int shifts[4] = { format.rShift, format.gShift, format.bShift, format.aShift };
+	const int losses[4] = { format.rLoss, format.gLoss, format.bLoss, format.aLoss };
+
+	__m128i shift[4], max[4], srcPart[4];
+	for (int i = 0; i < channels; ++i) {
+		const int channelMax = 0xFF >> losses[i];
+		shift[i] = _mm_cvtsi32_si128(shifts[i]);
+		max[i] = _mm_set1_epi16(channelMax);
+		srcPart[i] = _mm_set1_epi16((short)(((color >> shifts[i]) & channelMax) * alpha));
+	}
+	const __m128i dstFactor = _mm_set1_epi16((short)(256 - alpha));
+
+	for (; last - first >= 8; first += 8) {
+		const __m128i dst = _mm_loadu_si128((const __m128i *)first);
+		__m128i result = _mm_setzero_si128();
+
+		for (int i = 0; i < channels; ++i) {
+			__m128i c = _mm_and_si128(_mm_srl_epi16(dst, shift[i]), max[i]);
+			c = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(c, dstFactor), srcPart[i]), 8);
+			result = _mm_or_si128(result, _mm_sll_epi16(c, shift[i]));
+		}
+
+		_mm_storeu_si128((__m128i *)first, result);
+	}
+
+	return first;
+}
+#endif
 
 VectorRenderer *createRenderer(int mode) {
 #ifdef DISABLE_FANCY_THEMES
@@ -599,15 +702,22 @@ precalcGradient(int h) {
 			_gradIndexes.push_back(i);
 		}
 	}
+
+	// Precalculate the dithered colors of all rows, so filling a row of the
+	// gradient does not have to look for its strip
+	_gradRows.resize(2 * (h + 2));
+
+	int curGrad = 0;
+	for (int i = 0; i < h + 2; i++)
+		calcGradientRow(i, curGrad, &_gradRows[2 * i]);
 }
 
 template<typename PixelType>
 void VectorRendererSpec<PixelType>::
-gradientFill(PixelType *ptr, int width, int x, int y) {
+calcGradientRow(int y, int &curGrad, PixelType *colors) const {
 	bool ox = ((y & 1) == 1);
-	int curGrad = 0;
 
-	while (_gradIndexes[curGrad + 1] <= y)
+	while (curGrad + 2 < (int)_gradIndexes.size() && _gradIndexes[curGrad + 1] <= y)
 		curGrad++;
 
 	// precalcGradient assures that _gradIndexes entries always differ in
@@ -625,64 +735,44 @@ gradientFill(PixelType *ptr, int width, int x, int y) {
 	if (grad == 0 ||
 		_gradCache[curGrad] == _gradCache[curGrad + 1] || // no color change
 		stripSize < 2) { // the stip is small
-		colorFill<PixelType>(ptr, ptr + width, _gradCache[curGrad]);
-	} else if (grad == 3 && ox) {
-		colorFill<PixelType>(ptr, ptr + width, _gradCache[curGrad + 1]);
+		colors[0] = colors[1] = _gradCache[curGrad];
 	} else {
-		for (int j = x; j < x + width; j++, ptr++) {
-			bool oy = ((j & 1) == 1);
-
-			if ((ox && oy) ||
-				((grad == 2 || grad == 3) && ox && !oy) ||
-				(grad == 3 && oy))
-				*ptr = _gradCache[curGrad + 1];
-			else
-				*ptr = _gradCache[curGrad];
-		}
+		// Colors of the pixels in even and odd columns
+		colors[0] = ((grad == 2 || grad == 3) && ox) ? _gradCache[curGrad + 1] : _gradCache[curGrad];
+		colors[1] = (ox || grad == 3) ? _gradCache[curGrad + 1] : _gradCache[curGrad];
 	}
 }
 
 template<typename PixelType>
 void VectorRendererSpec<PixelType>::
-gradientFillClip(PixelType *ptr, int width, int x, int y, int realX, int realY) {
-	if (realY < _clippingArea.top || realY >= _clippingArea.bottom) return;
-	bool ox = ((y & 1) == 1);
-	int curGrad = 0;
+gradientFill(PixelType *ptr, int width, int x, int y) {
+	PixelType rowColors[2];
+	const PixelType *colors = rowColors;
 
-	while (_gradIndexes[curGrad + 1] <= y)
-		curGrad++;
+	if (y >= 0 && 2 * y < (int)_gradRows.size()) {
+		colors = &_gradRows[2 * y];
+	} else {
+		int curGrad = 0;
+		calcGradientRow(y, curGrad, rowColors);
+	}
 
-	// precalcGradient assures that _gradIndexes entries always differ in
-	// their value. This assures stripSize is always different from zero.
-	int stripSize = _gradIndexes[curGrad + 1] - _gradIndexes[curGrad];
+	if (x & 1)
+		patternFill<PixelType>(ptr, ptr + width, colors[1], colors[0]);
+	else
+		patternFill<PixelType>(ptr, ptr + width, colors[0], colors[1]);
+}
 
-	int grad = (((y - _gradIndexes[curGrad]) % stripSize) << 2) / stripSize;
+template<typename PixelType>
+void VectorRendererSpec<PixelType>::
+gradientFillClip(PixelType *ptr, int width, int x, int y, int realX, int realY) {
+	if (realY < _clippingArea.top || realY >= _clippingArea.bottom)
+		return;
 
-	// Dithering:
-	//   +--+ +--+ +--+ +--+
-	//   |  | |  | | *| | *|
-	//   |  | | *| |* | |**|
-	//   +--+ +--+ +--+ +--+
-	//     0    1    2    3
-	if (grad == 0 ||
-		_gradCache[curGrad] == _gradCache[curGrad + 1] || // no color change
-		stripSize < 2) { // the stip is small
-		colorFill<PixelType>(ptr, ptr + width, _gradCache[curGrad]);
-	} else if (grad == 3 && ox) {
-		colorFill<PixelType>(ptr, ptr + width, _gradCache[curGrad + 1]);
-	} else {
-		for (int j = x; j < x + width; j++, ptr++) {
-			if (realX + j - x < _clippingArea.left || realX + j - x >= _clippingArea.right) continue;
-			bool oy = ((j & 1) == 1);
-
-			if ((ox && oy) ||
-				((grad == 2 || grad == 3) && ox && !oy) ||
-				(grad == 3 && oy))
-				*ptr = _gradCache[curGrad + 1];
-			else
-				*ptr = _gradCache[curGrad];
-		}
-	}
+	int start = MAX(_clippingArea.left - realX, 0);
+	int end = MIN<int>(_clippingArea.right - realX, width);
+
+	if (start < end)
+		gradientFill(ptr + start, end - start, x + start, y);
 }
 
 template<typename PixelType>
@@ -718,29 +808,25 @@ fillSurfaceClip(Common::Rect clipping) {
 		return;
 	}
 
-	byte *ptr = (byte *)_activeSurface->getPixels();
+	clipping.clip(w, h);
+	if (clipping.isEmpty())
+		return;
+
 	int pitch = _activeSurface->pitch;
+	byte *ptr = (byte *)_activeSurface->getBasePtr(clipping.left, clipping.top);
 
 	if (Base::_fillMode == kFillBackground || Base::_fillMode == kFillForeground) {
 		PixelType color = (Base::_fillMode == kFillBackground ? _bgColor : _fgColor);
-		byte *ptrLeft = (ptr + _clippingArea.left), *ptrRight = ptr + _clippingArea.right;
-		for (int i = 0; i < h; i++) {
-			if (_clippingArea.top <= i && i < _clippingArea.bottom) {
-				colorFill<PixelType>((PixelType *)ptrLeft, (PixelType *)ptrRight, color);
-			}
-
-			ptrLeft += pitch;
-			ptrRight += pitch;
+		for (int i = clipping.top; i < clipping.bottom; i++) {
+			colorFill<PixelType>((PixelType *)ptr, (PixelType *)ptr + clipping.width(), color);
+			ptr += pitch;
 		}
 
 	} else if (Base::_fillMode == kFillGradient) {
 		precalcGradient(h);
 
-		for (int i = 0; i < h; i++) {
-			if (_clippingArea.top <= i && i < _clippingArea.bottom) {
-				gradientFill((PixelType *)ptr + _clippingArea.left, _clippingArea.width(), 0, i);
-			}
-
+		for (int i = clipping.top; i < clipping.bottom; i++) {
+			gradientFill((PixelType *)ptr, clipping.width(), clipping.left, i);
 			ptr += pitch;
 		}
 	}
@@ -1079,6 +1165,44 @@ blendPixelDestAlphaPtr(PixelType *ptr, PixelType color, uint8 alpha) {
 	}
 }
 
+template<typename PixelType>
+void VectorRendererSpec<PixelType>::
+blendFill(PixelType *first, PixelType *last, PixelType color, uint8 alpha) {
+	if (alpha == 0xff) {
+		// fully opaque, don't blend
+		colorFill<PixelType>(first, last, color | _alphaMask);
+		return;
+	}
+
+#ifdef VECTOR_RENDERER_USE_SSE2
+	const PixelType opaqueColor = (color & (_redMask | _greenMask | _blueMask)) | _alphaMask;
+
+	if (sizeof(PixelType) == 2) {
+		first = (PixelType *)blendSpan((uint16 *)first, (uint16 *)last, (uint16)opaqueColor, _format, alpha);
+	} else if (!_format.rLoss && !_format.gLoss && !_format.bLoss && (!_format.aLoss || !_format.aBits())
+	           && !(_format.rShift & 7) && !(_format.gShift & 7) && !(_format.bShift & 7) && !(_format.aShift & 7)) {
+		first = (PixelType *)blendSpan((uint32 *)first, (uint32 *)last, (uint32)opaqueColor,
+		                               _redMask | _greenMask | _blueMask | _alphaMask, alpha);
+	}
+#endif
+
+	while (first < last)
+		blendPixelPtr(first++, color, alpha);
+}
+
+template<typename PixelType>
+void VectorRendererSpec<PixelType>::
+blendFillClip(PixelType *first, PixelType *last, PixelType color, uint8 alpha, int realX, int realY) {
+	if (realY < _clippingArea.top || realY >= _clippingArea.bottom)
+		return;
+
+	int start = MAX(_clippingArea.left - realX, 0);
+	int end = MIN<int>(_clippingArea.right - realX, last - first);
+
+	if (start < end)
+		blendFill(first + start, first + end, color, alpha);
+}
+
 template<typename PixelType>
 inline void VectorRendererSpec<PixelType>::
 darkenFill(PixelType *ptr, PixelType *end) {
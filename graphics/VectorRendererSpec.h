@@ -85,6 +85,15 @@ public:
 	void setBevelColor(uint8 r, uint8 g, uint8 b) { _bevelColor = _format.RGBToColor(r, g, b); }
 	void setGradientColors(uint8 r1, uint8 g1, uint8 b1, uint8 r2, uint8 g2, uint8 b2);
 
+	void getInheritedState(InheritedState &state) const {
+		Base::getInheritedState(state);
+		state.fgColor = _fgColor;
+		state.bgColor = _bgColor;
+		state.bevelColor = _bevelColor;
+		state.gradientStart = _gradientStart;
+		state.gradientEnd = _gradientEnd;
+	}
+
 	void copyFrame(OSystem *sys, const Common::Rect &r);
 	void copyWholeFrame(OSystem *sys) { copyFrame(sys, Common::Rect(0, 0, _activeSurface->w, _activeSurface->h)); }
 
@@ -275,6 +284,17 @@ protected:
 	inline PixelType calcGradient(uint32 pos, uint32 max);
 
 	void precalcGradient(int h);
+
+	/**
+	 * Calculates the dithered colors of a gradient row.
+	 *
+	 * @param y Row of the gradient.
+	 * @param curGrad Index of the gradient strip to start looking for the
+	 *                row at. Updated to the strip of the row.
+	 * @param colors Receives the colors of the even and odd columns.
+	 */
+	void calcGradientRow(int y, int &curGrad, PixelType *colors) const;
+
 	void gradientFill(PixelType *first, int width, int x, int y);
 	void gradientFillClip(PixelType *first, int width, int x, int y, int realX, int realY);
 
@@ -288,21 +308,8 @@ protected:
 	 * @param color Color of the pixel
 	 * @param alpha Alpha intensity of the pixel (0-255)
 	 */
-	inline void blendFill(PixelType *first, PixelType *last, PixelType color, uint8 alpha) {
-		while (first != last) blendPixelPtr(first++, color, alpha);
-	}
-
-	inline void blendFillClip(PixelType *first, PixelType *last, PixelType color, uint8 alpha, int realX, int realY) {
-		if (_clippingArea.top <= realY && realY < _clippingArea.bottom) {
-			while (first != last) {
-				if (_clippingArea.left <= realX && realX < _clippingArea.right)
-					blendPixelPtr(first++, color, alpha);
-				else
-					++first;
-				++realX;
-			}
-		}
-	}
+	void blendFill(PixelType *first, PixelType *last, PixelType color, uint8 alpha);
+	void blendFillClip(PixelType *first, PixelType *last, PixelType color, uint8 alpha, int realX, int realY);
 
 	void darkenFill(PixelType *first, PixelType *last);
 	void darkenFillClip(PixelType *first, PixelType *last, int x, int y);
@@ -320,6 +327,7 @@ protected:
 
 	Common::Array<PixelType> _gradCache;
 	Common::Array<int> _gradIndexes;
+	Common::Array<PixelType> _gradRows; /**< Colors of the even and odd columns of each gradient row */
 
 	PixelType _bevelColor;
 	PixelType _bitmapAlphaColor;
@@ -25,6 +25,11 @@
 
 #include "common/endian.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CONVERSION_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Graphics {
 
 // TODO: YUV to RGB conversion function
@@ -96,6 +101,247 @@ inline void crossBlitLogic3BppSource(byte *dst, const byte *src, const uint w, c
 	}
 }
 
+/**
+ * Precomputed shifts and masks to convert colors between two formats.
+ *
+ * This works for every source format whose components have either 0 or
+ * 4 to 8 bits, which covers all the common formats like RGB565, RGB555,
+ * ARGB4444, RGB888 and (A)RGB8888 in any component order. For these the
+ * expansion done by PixelFormat::colorToARGB boils down to two shifts, so
+ * the conversion needs no branches and can be done on several pixels at
+ * once. The results are identical to colorToARGB followed by ARGBToColor.
+ */
+struct FastConversion {
+	uint32 srcMask[4];
+	uint srcShift[4];
+	uint expandShift[4];
+	uint repeatShift[4];
+	uint dstLoss[4];
+	uint dstShift[4];
+	uint32 constant;
+
+	bool init(const PixelFormat &srcFmt, const PixelFormat &dstFmt) {
+		const uint srcLosses[4] = { srcFmt.rLoss, srcFmt.gLoss, srcFmt.bLoss, srcFmt.aLoss };
+		const uint srcShifts[4] = { srcFmt.rShift, srcFmt.gShift, srcFmt.bShift, srcFmt.aShift };
+		const uint dstLosses[4] = { dstFmt.rLoss, dstFmt.gLoss, dstFmt.bLoss, dstFmt.aLoss };
+		const uint dstShifts[4] = { dstFmt.rShift, dstFmt.gShift, dstFmt.bShift, dstFmt.aShift };
+
+		constant = 0;
+		for (int i = 0; i < 4; ++i) {
+			srcMask[i] = srcShift[i] = expandShift[i] = repeatShift[i] = dstLoss[i] = dstShift[i] = 0;
+
+			if (srcLosses[i] > 8 || dstLosses[i] > 8 || dstShifts[i] >= 32)
+				return false;
+
+			// The destination does not store this component
+			if (dstLosses[i] == 8)
+				continue;
+
+			const uint bits = 8 - srcLosses[i];
+			if (bits == 0) {
+				// A missing alpha component is fully opaque, a missing color
+				// component is black.
+				if (i == 3)
+					constant = (0xFF >> dstLosses[i]) << dstShifts[i];
+				continue;
+			}
+
+			if (bits < 4 || srcShifts[i] >= 32)
+				return false;
+
+			srcMask[i] = (1 << bits) - 1;
+			srcShift[i] = srcShifts[i];
+			expandShift[i] = 8 - bits;
+			repeatShift[i] = 2 * bits - 8;
+			dstLoss[i] = dstLosses[i];
+			dstShift[i] = dstShifts[i];
+		}
+
+		return true;
+	}
+
+	inline uint32 convert(uint32 color) const {
+		uint32 result = constant;
+		for (int i = 0; i < 4; ++i) {
+			const uint32 value = (color >> srcShift[i]) & srcMask[i];
+			const uint32 expanded = (value << expandShift[i]) | (value >> repeatShift[i]);
+			result |= (expanded >> dstLoss[i]) << dstShift[i];
+		}
+		return result;
+	}
+};
+
+template<typename SrcColor>
+inline uint32 readPixel(const byte *src) {
+	return *(const SrcColor *)src;
+}
+
+template<>
+inline uint32 readPixel<byte[3]>(const byte *src) {
+	uint32 color = 0;
+	uint8 *col = (uint8 *)&color;
+#ifdef SCUMM_BIG_ENDIAN
+	col++;
+#endif
+	memcpy(col, src, 3);
+	return color;
+}
+
+#ifdef CONVERSION_USE_SSE2
+/** The shift counts and masks of a FastConversion, ready for SSE2. */
+struct FastConversionSSE2 {
+	__m128i srcMask[4];
+	__m128i srcShift[4];
+	__m128i expandShift[4];
+	__m128i repeatShift[4];
+	__m128i dstLoss[4];
+	__m128i dstShift[4];
+	__m128i constant;
+
+	explicit FastConversionSSE2(const FastConversion &conv) {
+		for (int i = 0; i < 4; ++i) {
+			srcMask[i] = _mm_set1_epi32(conv.srcMask[i]);
+			srcShift[i] = _mm_cvtsi32_si128(conv.srcShift[i]);
+			expandShift[i] = _mm_cvtsi32_si128(conv.expandShift[i]);
+			repeatShift[i] = _mm_cvtsi32_si128(conv.repeatShift[i]);
+			dstLoss[i] = _mm_cvtsi32_si128(conv.dstLoss[i]);
+			dstShift[i] = _mm_cvtsi32_si128(conv.dstShift[i]);
+		}
+		constant = _mm_set1_epi32(conv.constant);
+	}
+
+	/** Converts four pixels stored in 32 bit lanes. */
+	inline __m128i convert(__m128i color) const {
+		__m128i result = constant;
+		for (int i = 0; i < 4; ++i) {
+			const __m128i value = _mm_and_si128(_mm_srl_epi32(color, srcShift[i]), srcMask[i]);
+			const __m128i expanded = _mm_or_si128(_mm_sll_epi32(value, expandShift[i]), _mm_srl_epi32(value, repeatShift[i]));
+			result = _mm_or_si128(result, _mm_sll_epi32(_mm_srl_epi32(expanded, dstLoss[i]), dstShift[i]));
+		}
+		return result;
+	}
+};
+
+template<typename Color>
+inline __m128i loadPixels(const byte *src) {
+	// There is no cheap way to load packed 24 bit pixels with SSE2
+	return _mm_setr_epi32(readPixel<Color>(src), readPixel<Color>(src + sizeof(Color)),
+	                      readPixel<Color>(src + 2 * sizeof(Color)), readPixel<Color>(src + 3 * sizeof(Color)));
+}
+
+template<>
+inline __m128i loadPixels<uint16>(const byte *src) {
+	return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+}
+
+template<>
+inline __m128i loadPixels<uint32>(const byte *src) {
+	return _mm_loadu_si128((const __m128i *)src);
+}
+
+template<typename Color>
+inline void storePixels(byte *dst, __m128i color);
+
+template<>
+inline void storePixels<uint16>(byte *dst, __m128i color) {
+	// Only keep the low 16 bits of every lane like a plain uint16 store.
+	// The sign extension keeps _mm_packs_epi32 from saturating them.
+	color = _mm_srai_epi32(_mm_slli_epi32(color, 16), 16);
+	_mm_storel_epi64((__m128i *)dst, _mm_packs_epi32(color, color));
+}
+
+template<>
+inline void storePixels<uint32>(byte *dst, __m128i color) {
+	_mm_storeu_si128((__m128i *)dst, color);
+}
+#endif
+
+/**
+ * Converts a row of pixels with a FastConversion. A backward conversion
+ * processes the pixels from right to left, so that the row can be
+ * converted in place to a larger pixel size.
+ */
+template<typename SrcColor, typename DstColor, bool backward>
+inline void fastConvertRow(byte *dst, const byte *src, const uint w, const FastConversion &conv
+#ifdef CONVERSION_USE_SSE2
+                           , const FastConversionSSE2 &convSSE2
+#endif
+                           ) {
+	uint x = 0;
+	uint end = w;
+
+#ifdef CONVERSION_USE_SSE2
+	if (backward) {
+		for (; end >= 4; end -= 4) {
+			const __m128i color = loadPixels<SrcColor>(src + (end - 4) * sizeof(SrcColor));
+			storePixels<DstColor>(dst + (end - 4) * sizeof(DstColor), convSSE2.convert(color));
+		}
+	} else {
+		for (; x + 4 <= w; x += 4) {
+			const __m128i color = loadPixels<SrcColor>(src + x * sizeof(SrcColor));
+			storePixels<DstColor>(dst + x * sizeof(DstColor), convSSE2.convert(color));
+		}
+	}
+#endif
+
+	if (backward) {
+		while (end > x) {
+			--end;
+			*(DstColor *)(dst + end * sizeof(DstColor)) = conv.convert(readPixel<SrcColor>(src + end * sizeof(SrcColor)));
+		}
+	} else {
+		for (; x < end; ++x)
+			*(DstColor *)(dst + x * sizeof(DstColor)) = conv.convert(readPixel<SrcColor>(src + x * sizeof(SrcColor)));
+	}
+}
+
+template<typename SrcColor, typename DstColor, bool backward>
+void fastCrossBlit(byte *dst, const byte *src, const uint dstPitch, const uint srcPitch,
+                   uint w, uint h, const FastConversion &conv) {
+	// Contiguous lines can be converted as one long line
+	if (srcPitch == w * sizeof(SrcColor) && dstPitch == w * sizeof(DstColor)) {
+		w *= h;
+		h = 1;
+	}
+
+#ifdef CONVERSION_USE_SSE2
+	const FastConversionSSE2 convSSE2(conv);
+#define CONVERT_ROW(dstRow, srcRow) fastConvertRow<SrcColor, DstColor, backward>(dstRow, srcRow, w, conv, convSSE2)
+#else
+#define CONVERT_ROW(dstRow, srcRow) fastConvertRow<SrcColor, DstColor, backward>(dstRow, srcRow, w, conv)
+#endif
+
+	if (backward) {
+		for (uint y = h; y > 0; --y)
+			CONVERT_ROW(dst + (y - 1) * dstPitch, src + (y - 1) * srcPitch);
+	} else {
+		for (uint y = 0; y < h; ++y)
+			CONVERT_ROW(dst + y * dstPitch, src + y * srcPitch);
+	}
+
+#undef CONVERT_ROW
+}
+
+template<typename DstColor, bool backward>
+void crossBlitMapLogic(byte *dst, const byte *src, const uint dstPitch, const uint srcPitch,
+                       const uint w, const uint h, const uint32 *map) {
+	if (backward) {
+		for (uint y = h; y > 0; --y) {
+			const byte *srcRow = src + (y - 1) * srcPitch;
+			DstColor *dstRow = (DstColor *)(dst + (y - 1) * dstPitch);
+			for (uint x = w; x > 0; --x)
+				dstRow[x - 1] = map[srcRow[x - 1]];
+		}
+	} else {
+		for (uint y = 0; y < h; ++y) {
+			const byte *srcRow = src + y * srcPitch;
+			DstColor *dstRow = (DstColor *)(dst + y * dstPitch);
+			for (uint x = 0; x < w; ++x)
+				dstRow[x] = map[srcRow[x]];
+		}
+	}
+}
+
 } // End of anonymous namespace
 
 // Function to blit a rect from one color format to another
@@ -126,6 +372,29 @@ bool crossBlit(byte *dst, const byte *src,
 		return true;
 	}
 
+	// Use the branchless conversion whenever both formats allow it. It
+	// processes the pixels in the same order as the generic code below.
+	FastConversion conv;
+	if (conv.init(srcFmt, dstFmt)) {
+		if (dstFmt.bytesPerPixel == 2) {
+			if (srcFmt.bytesPerPixel == 2)
+				fastCrossBlit<uint16, uint16, false>(dst, src, dstPitch, srcPitch, w, h, conv);
+			else if (srcFmt.bytesPerPixel == 3)
+				fastCrossBlit<byte[3], uint16, false>(dst, src, dstPitch, srcPitch, w, h, conv);
+			else
+				fastCrossBlit<uint32, uint16, false>(dst, src, dstPitch, srcPitch, w, h, conv);
+			return true;
+		} else if (dstFmt.bytesPerPixel == 4) {
+			if (srcFmt.bytesPerPixel == 2)
+				fastCrossBlit<uint16, uint32, true>(dst, src, dstPitch, srcPitch, w, h, conv);
+			else if (srcFmt.bytesPerPixel == 3)
+				fastCrossBlit<byte[3], uint32, true>(dst, src, dstPitch, srcPitch, w, h, conv);
+			else
+				fastCrossBlit<uint32, uint32, false>(dst, src, dstPitch, srcPitch, w, h, conv);
+			return true;
+		}
+	}
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta = (srcPitch - w * srcFmt.bytesPerPixel);
 	const uint dstDelta = (dstPitch - w * dstFmt.bytesPerPixel);
@@ -167,4 +436,26 @@ bool crossBlit(byte *dst, const byte *src,
 	return true;
 }
 
+bool crossBlitMap(byte *dst, const byte *src,
+                  const uint dstPitch, const uint srcPitch,
+                  const uint w, const uint h,
+                  const uint bytesPerPixel, const uint32 *map) {
+	// Blit from bottom right to top left for larger destination pixels, so
+	// that the conversion works in place like in crossBlit.
+	switch (bytesPerPixel) {
+	case 1:
+		crossBlitMapLogic<byte, false>(dst, src, dstPitch, srcPitch, w, h, map);
+		break;
+	case 2:
+		crossBlitMapLogic<uint16, true>(dst, src, dstPitch, srcPitch, w, h, map);
+		break;
+	case 4:
+		crossBlitMapLogic<uint32, true>(dst, src, dstPitch, srcPitch, w, h, map);
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
 } // End of namespace Graphics
@@ -72,6 +72,30 @@ bool crossBlit(byte *dst, const byte *src,
                const uint w, const uint h,
                const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt);
 
+/**
+ * Blits a rectangle from a paletted format to another format by looking up
+ * each pixel in a color map.
+ *
+ * @param dst			the buffer which will recieve the converted graphics data
+ * @param src			the buffer containing the original paletted graphics data
+ * @param dstPitch		width in bytes of one full line of the dest buffer
+ * @param srcPitch		width in bytes of one full line of the source buffer
+ * @param w				the width of the graphics data
+ * @param h				the height of the graphics data
+ * @param bytesPerPixel	the number of bytes per pixel of the dest buffer
+ * @param map			the 256 colors, already in the destination format,
+ *						which the palette indices map to
+ * @return				true if conversion completes successfully,
+ *						false if there is an error.
+ *
+ * @note Blitting to a 3Bpp destination is not supported
+ * @note Like crossBlit this can convert a surface in place.
+ */
+bool crossBlitMap(byte *dst, const byte *src,
+                  const uint dstPitch, const uint srcPitch,
+                  const uint w, const uint h,
+                  const uint bytesPerPixel, const uint32 *map);
+
 } // End of namespace Graphics
 
 #endif // GRAPHICS_CONVERSION_H
@@ -155,11 +155,13 @@ public:
 	 * This describes the logical width of the string when drawn at (0, 0).
 	 * This can be different from the actual bounding box of the string. Use
 	 * getBoundingBox when you need the bounding box of a drawn string.
+	 * Fonts for which measuring is expensive may override this to cache
+	 * the widths of the strings they measured.
 	 * @see getBoundingBox
 	 * @see drawChar
 	 */
-	int getStringWidth(const Common::String &str) const;
-	int getStringWidth(const Common::U32String &str) const;
+	virtual int getStringWidth(const Common::String &str) const;
+	virtual int getStringWidth(const Common::U32String &str) const;
 
 	/**
 	 * Take a text (which may contain newline characters) and word wrap it so that
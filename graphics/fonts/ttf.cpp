@@ -35,6 +35,7 @@
 #include "common/stream.h"
 #include "common/memstream.h"
 #include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/ptr.h"
 
 #include <ft2build.h>
@@ -43,6 +44,11 @@
 #include FT_TRUETYPE_TABLES_H
 #include FT_TRUETYPE_TAGS_H
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TTF_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Graphics {
 
 namespace {
@@ -121,6 +127,9 @@ public:
 
 	virtual Common::Rect getBoundingBox(uint32 chr) const;
 
+	virtual int getStringWidth(const Common::String &str) const;
+	virtual int getStringWidth(const Common::U32String &str) const;
+
 	virtual void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const;
 private:
 	bool _initialized;
@@ -133,7 +142,8 @@ private:
 	int _ascent, _descent;
 
 	struct Glyph {
-		Surface image;
+		int atlasX, atlasY;
+		int width, height;
 		int xOffset, yOffset;
 		int advance;
 		FT_UInt slot;
@@ -143,7 +153,27 @@ private:
 	typedef Common::HashMap<uint32, Glyph> GlyphCache;
 	mutable GlyphCache _glyphs;
 	bool _allowLateCaching;
-	void assureCached(uint32 chr) const;
+	const Glyph *getGlyph(uint32 chr) const;
+
+	/**
+	 * The images of all glyphs are packed into one 8 bit coverage surface.
+	 * Glyphs are placed left to right on shelves, which are as high as the
+	 * tallest glyph on them. The atlas grows when a glyph does not fit.
+	 */
+	mutable Surface _atlas;
+	mutable int _atlasX, _atlasY, _shelfHeight;
+	void allocateAtlasArea(int w, int h, int &x, int &y) const;
+	void growAtlas(int w, int h) const;
+
+	// Kerning offsets of character pairs, both characters in the lower
+	// and upper 16 bits of the key.
+	typedef Common::HashMap<uint32, int> KerningCache;
+	mutable KerningCache _kerning;
+
+	// Widths of recently measured strings. GUI code measures the same
+	// strings over and over again for layout and alignment.
+	typedef Common::HashMap<Common::String, int> StringWidthCache;
+	mutable StringWidthCache _stringWidths;
 
 	Common::SeekableReadStream *readTTFTable(FT_ULong tag) const;
 
@@ -159,7 +189,7 @@ private:
 TTFFont::TTFFont()
     : _initialized(false), _face(), _ttfFile(0), _size(0), _width(0), _height(0), _ascent(0),
       _descent(0), _glyphs(), _loadFlags(FT_LOAD_TARGET_NORMAL), _renderMode(FT_RENDER_MODE_NORMAL),
-      _hasKerning(false), _allowLateCaching(false) {
+      _hasKerning(false), _allowLateCaching(false), _atlasX(0), _atlasY(0), _shelfHeight(0) {
 }
 
 TTFFont::~TTFFont() {
@@ -169,11 +199,10 @@ TTFFont::~TTFFont() {
 		delete[] _ttfFile;
 		_ttfFile = 0;
 
-		for (GlyphCache::iterator i = _glyphs.begin(), end = _glyphs.end(); i != end; ++i)
-			i->_value.image.free();
-
 		_initialized = false;
 	}
+
+	_atlas.free();
 }
 
 bool TTFFont::load(Common::SeekableReadStream &stream, int size, TTFSizeMode sizeMode, uint dpi, TTFRenderMode renderMode, const uint32 *mapping) {
@@ -405,71 +434,223 @@ int TTFFont::getMaxCharWidth() const {
 }
 
 int TTFFont::getCharWidth(uint32 chr) const {
-	assureCached(chr);
-	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
-	if (glyphEntry == _glyphs.end())
+	const Glyph *glyph = getGlyph(chr);
+	if (!glyph)
 		return 0;
 	else
-		return glyphEntry->_value.advance;
+		return glyph->advance;
 }
 
 int TTFFont::getKerningOffset(uint32 left, uint32 right) const {
 	if (!_hasKerning)
 		return 0;
 
-	assureCached(left);
-	assureCached(right);
-
-	FT_UInt leftGlyph, rightGlyph;
-	GlyphCache::const_iterator glyphEntry;
-
-	glyphEntry = _glyphs.find(left);
-	if (glyphEntry != _glyphs.end()) {
-		leftGlyph = glyphEntry->_value.slot;
-	} else {
-		return 0;
+	const bool cacheable = (left <= 0xFFFF && right <= 0xFFFF);
+	const uint32 key = (left << 16) | right;
+	if (cacheable) {
+		KerningCache::const_iterator entry = _kerning.find(key);
+		if (entry != _kerning.end())
+			return entry->_value;
 	}
 
-	glyphEntry = _glyphs.find(right);
-	if (glyphEntry != _glyphs.end()) {
-		rightGlyph = glyphEntry->_value.slot;
-	} else {
-		return 0;
-	}
+	const Glyph *leftGlyph = getGlyph(left);
+	const Glyph *rightGlyph = getGlyph(right);
 
-	if (!leftGlyph || !rightGlyph)
-		return 0;
+	int offset = 0;
+	if (leftGlyph && rightGlyph && leftGlyph->slot && rightGlyph->slot) {
+		FT_Vector kerningVector;
+		FT_Get_Kerning(_face, leftGlyph->slot, rightGlyph->slot, FT_KERNING_DEFAULT, &kerningVector);
+		offset = kerningVector.x / 64;
+	}
 
-	FT_Vector kerningVector;
-	FT_Get_Kerning(_face, leftGlyph, rightGlyph, FT_KERNING_DEFAULT, &kerningVector);
-	return (kerningVector.x / 64);
+	if (cacheable)
+		_kerning[key] = offset;
+	return offset;
 }
 
 Common::Rect TTFFont::getBoundingBox(uint32 chr) const {
-	assureCached(chr);
-	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
-	if (glyphEntry == _glyphs.end()) {
+	const Glyph *glyph = getGlyph(chr);
+	if (!glyph) {
 		return Common::Rect();
 	} else {
-		const int xOffset = glyphEntry->_value.xOffset;
-		const int yOffset = glyphEntry->_value.yOffset;
-		const Graphics::Surface &image = glyphEntry->_value.image;
-		return Common::Rect(xOffset, yOffset, xOffset + image.w, yOffset + image.h);
+		const int xOffset = glyph->xOffset;
+		const int yOffset = glyph->yOffset;
+		return Common::Rect(xOffset, yOffset, xOffset + glyph->width, yOffset + glyph->height);
 	}
 }
 
+int TTFFont::getStringWidth(const Common::String &str) const {
+	StringWidthCache::const_iterator entry = _stringWidths.find(str);
+	if (entry != _stringWidths.end())
+		return entry->_value;
+
+	// Keep the cache from growing without bounds, strings like the ones in
+	// an edit field are not worth keeping forever.
+	if (_stringWidths.size() >= 1024)
+		_stringWidths.clear();
+
+	const int width = Font::getStringWidth(str);
+	_stringWidths[str] = width;
+	return width;
+}
+
+int TTFFont::getStringWidth(const Common::U32String &str) const {
+	return Font::getStringWidth(str);
+}
+
 namespace {
 
+#ifdef TTF_USE_SSE2
+/**
+ * Blends a color onto four pixels at once, using the glyph coverage as
+ * alpha. This works for all destination formats whose color components
+ * have 4 to 8 bits and gives exactly the same results as the per pixel
+ * code in renderGlyph.
+ */
+class CoverageBlender {
+public:
+	bool init(uint32 color, const PixelFormat &format) {
+		const uint losses[3] = { format.rLoss, format.gLoss, format.bLoss };
+		const uint shifts[3] = { format.rShift, format.gShift, format.bShift };
+
+		uint8 components[3];
+		format.colorToRGB(color, components[0], components[1], components[2]);
+
+		for (int i = 0; i < 3; ++i) {
+			if (losses[i] > 4 || shifts[i] >= 32)
+				return false;
+
+			const uint bits = 8 - losses[i];
+			_mask[i] = _mm_set1_epi32((1 << bits) - 1);
+			_shift[i] = _mm_cvtsi32_si128(shifts[i]);
+			_expandShift[i] = _mm_cvtsi32_si128(8 - bits);
+			_repeatShift[i] = _mm_cvtsi32_si128(2 * bits - 8);
+			_loss[i] = _mm_cvtsi32_si128(losses[i]);
+			_component[i] = _mm_set1_epi32(components[i]);
+		}
+
+		if (format.aLoss < 8 && format.aShift >= 32)
+			return false;
+
+		// RGBToColor always sets the alpha component to fully opaque
+		_opaque = _mm_set1_epi32((0xFF >> format.aLoss) << format.aShift);
+		_color = _mm_set1_epi32(color);
+		return true;
+	}
+
+	/**
+	 * @param color		four pixels, one in each 32 bit lane
+	 * @param coverage	the coverage for the four pixels, as 32 bit lanes
+	 */
+	inline __m128i blend(__m128i color, __m128i coverage) const {
+		const __m128i inverse = _mm_sub_epi32(_mm_set1_epi32(255), coverage);
+
+		__m128i result = _opaque;
+		for (int i = 0; i < 3; ++i) {
+			const __m128i value = _mm_and_si128(_mm_srl_epi32(color, _shift[i]), _mask[i]);
+			const __m128i expanded = _mm_or_si128(_mm_sll_epi32(value, _expandShift[i]), _mm_srl_epi32(value, _repeatShift[i]));
+
+			// All products fit into 16 bits. (x + 1 + (x >> 8)) >> 8 equals
+			// x / 255 for all of these.
+			__m128i sum = _mm_add_epi32(_mm_mullo_epi16(inverse, expanded), _mm_mullo_epi16(coverage, _component[i]));
+			sum = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(sum, _mm_set1_epi32(1)), _mm_srli_epi32(sum, 8)), 8);
+
+			result = _mm_or_si128(result, _mm_sll_epi32(_mm_srl_epi32(sum, _loss[i]), _shift[i]));
+		}
+
+		// Fully covered pixels get the exact color and uncovered ones stay
+		// untouched.
+		const __m128i full = _mm_cmpeq_epi32(coverage, _mm_set1_epi32(255));
+		const __m128i none = _mm_cmpeq_epi32(coverage, _mm_setzero_si128());
+		result = _mm_or_si128(_mm_and_si128(full, _color), _mm_andnot_si128(full, result));
+		return _mm_or_si128(_mm_and_si128(none, color), _mm_andnot_si128(none, result));
+	}
+
+private:
+	__m128i _mask[3];
+	__m128i _shift[3];
+	__m128i _expandShift[3];
+	__m128i _repeatShift[3];
+	__m128i _loss[3];
+	__m128i _component[3];
+	__m128i _opaque;
+	__m128i _color;
+};
+
+inline __m128i loadCoverage(const uint8 *src) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i coverage = _mm_cvtsi32_si128(READ_UINT32(src));
+	return _mm_unpacklo_epi16(_mm_unpacklo_epi8(coverage, zero), zero);
+}
+
+/**
+ * Blends a row of a glyph, four pixels at a time.
+ *
+ * @return the number of pixels blended
+ */
+template<typename ColorType>
+int blendGlyphRow(ColorType *dst, const uint8 *src, const int w, const CoverageBlender &blender);
+
+template<>
+int blendGlyphRow<uint16>(uint16 *dst, const uint8 *src, const int w, const CoverageBlender &blender) {
+	int x = 0;
+	for (; x + 4 <= w; x += 4) {
+		// Most of a glyph is either empty or fully covered
+		const uint32 coverage = READ_UINT32(src + x);
+		if (coverage == 0)
+			continue;
+
+		const __m128i color = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)(dst + x)), _mm_setzero_si128());
+		__m128i result = blender.blend(color, loadCoverage(src + x));
+
+		// Only keep the low 16 bits of every lane. The sign extension keeps
+		// _mm_packs_epi32 from saturating them.
+		result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+		_mm_storel_epi64((__m128i *)(dst + x), _mm_packs_epi32(result, result));
+	}
+	return x;
+}
+
+template<>
+int blendGlyphRow<uint32>(uint32 *dst, const uint8 *src, const int w, const CoverageBlender &blender) {
+	int x = 0;
+	for (; x + 4 <= w; x += 4) {
+		// Most of a glyph is either empty or fully covered
+		const uint32 coverage = READ_UINT32(src + x);
+		if (coverage == 0)
+			continue;
+
+		const __m128i color = _mm_loadu_si128((const __m128i *)(dst + x));
+		_mm_storeu_si128((__m128i *)(dst + x), blender.blend(color, loadCoverage(src + x)));
+	}
+	return x;
+}
+#endif
+
 template<typename ColorType>
 void renderGlyph(uint8 *dstPos, const int dstPitch, const uint8 *srcPos, const int srcPitch, const int w, const int h, ColorType color, const PixelFormat &dstFormat) {
 	uint8 sR, sG, sB;
 	dstFormat.colorToRGB(color, sR, sG, sB);
 
+#ifdef TTF_USE_SSE2
+	CoverageBlender blender;
+	const bool useBlender = blender.init(color, dstFormat);
+#endif
+
 	for (int y = 0; y < h; ++y) {
 		ColorType *rDst = (ColorType *)dstPos;
 		const uint8 *src = srcPos;
 
-		for (int x = 0; x < w; ++x) {
+		int x = 0;
+#ifdef TTF_USE_SSE2
+		if (useBlender) {
+			x = blendGlyphRow<ColorType>(rDst, src, w, blender);
+			rDst += x;
+			src += x;
+		}
+#endif
+
+		for (; x < w; ++x) {
 			if (*src == 255) {
 				*rDst = color;
 			} else if (*src) {
@@ -497,12 +678,11 @@ void renderGlyph(uint8 *dstPos, const int dstPitch, const uint8 *srcPos, const i
 } // End of anonymous namespace
 
 void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const {
-	assureCached(chr);
-	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
-	if (glyphEntry == _glyphs.end())
+	const Glyph *glyphEntry = getGlyph(chr);
+	if (!glyphEntry)
 		return;
 
-	const Glyph &glyph = glyphEntry->_value;
+	const Glyph &glyph = *glyphEntry;
 
 	x += glyph.xOffset;
 	y += glyph.yOffset;
@@ -512,10 +692,13 @@ void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) con
 	if (y > dst->h)
 		return;
 
-	int w = glyph.image.w;
-	int h = glyph.image.h;
+	int w = glyph.width;
+	int h = glyph.height;
+
+	if (w <= 0 || h <= 0)
+		return;
 
-	const uint8 *srcPos = (const uint8 *)glyph.image.getPixels();
+	const uint8 *srcPos = (const uint8 *)_atlas.getBasePtr(glyph.atlasX, glyph.atlasY);
 
 	// Make sure we are not drawing outside the screen bounds
 	if (x < 0) {
@@ -531,7 +714,7 @@ void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) con
 		return;
 
 	if (y < 0) {
-		srcPos -= y * glyph.image.pitch;
+		srcPos -= y * _atlas.pitch;
 		h += y;
 		y = 0;
 	}
@@ -560,12 +743,12 @@ void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) con
 			}
 
 			dstPos += dst->pitch;
-			srcPos += glyph.image.pitch;
+			srcPos += _atlas.pitch;
 		}
 	} else if (dst->format.bytesPerPixel == 2) {
-		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format);
+		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, _atlas.pitch, w, h, color, dst->format);
 	} else if (dst->format.bytesPerPixel == 4) {
-		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format);
+		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, _atlas.pitch, w, h, color, dst->format);
 	}
 }
 
@@ -594,7 +777,19 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	glyph.advance = ftCeil26_6(_face->glyph->advance.x);
 
 	const FT_Bitmap &bitmap = _face->glyph->bitmap;
-	glyph.image.create(bitmap.width, bitmap.rows, PixelFormat::createFormatCLUT8());
+	if (bitmap.pixel_mode != FT_PIXEL_MODE_MONO && bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) {
+		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap.pixel_mode);
+		return false;
+	}
+
+	glyph.width = bitmap.width;
+	glyph.height = bitmap.rows;
+	glyph.atlasX = glyph.atlasY = 0;
+
+	if (!glyph.width || !glyph.height)
+		return true;
+
+	allocateAtlasArea(glyph.width, glyph.height, glyph.atlasX, glyph.atlasY);
 
 	const uint8 *src = bitmap.buffer;
 	int srcPitch = bitmap.pitch;
@@ -603,11 +798,9 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 		srcPitch = -srcPitch;
 	}
 
-	uint8 *dst = (uint8 *)glyph.image.getPixels();
-	memset(dst, 0, glyph.image.h * glyph.image.pitch);
+	uint8 *dst = (uint8 *)_atlas.getBasePtr(glyph.atlasX, glyph.atlasY);
 
-	switch (bitmap.pixel_mode) {
-	case FT_PIXEL_MODE_MONO:
+	if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
 		for (int y = 0; y < (int)bitmap.rows; ++y) {
 			const uint8 *curSrc = src;
 			uint8 mask = 0;
@@ -616,43 +809,73 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 				if ((x % 8) == 0)
 					mask = *curSrc++;
 
-				if (mask & 0x80)
-					*dst = 255;
+				dst[x] = (mask & 0x80) ? 255 : 0;
 
 				mask <<= 1;
-				++dst;
 			}
 
+			dst += _atlas.pitch;
 			src += srcPitch;
 		}
-		break;
-
-	case FT_PIXEL_MODE_GRAY:
+	} else {
 		for (int y = 0; y < (int)bitmap.rows; ++y) {
 			memcpy(dst, src, bitmap.width);
-			dst += glyph.image.pitch;
+			dst += _atlas.pitch;
 			src += srcPitch;
 		}
-		break;
-
-	default:
-		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap.pixel_mode);
-		glyph.image.free();
-		return false;
 	}
 
 	return true;
 }
 
-void TTFFont::assureCached(uint32 chr) const {
-	if (!chr || !_allowLateCaching || _glyphs.contains(chr)) {
-		return;
+void TTFFont::allocateAtlasArea(int w, int h, int &x, int &y) const {
+	// Start a new shelf when the glyph does not fit on the current one
+	if (_atlasX + w > _atlas.w) {
+		_atlasY += _shelfHeight;
+		_atlasX = 0;
+		_shelfHeight = 0;
 	}
 
+	if (w > _atlas.w || _atlasY + h > _atlas.h)
+		growAtlas(w, _atlasY + h);
+
+	x = _atlasX;
+	y = _atlasY;
+
+	_atlasX += w;
+	_shelfHeight = MAX(_shelfHeight, h);
+}
+
+void TTFFont::growAtlas(int w, int h) const {
+	// Grow in large steps, since every time all glyphs have to be copied
+	w = MAX(w, MAX<int>(_atlas.w, 512));
+	h = MAX(h, MAX<int>(_atlas.h * 2, 64));
+
+	Surface atlas;
+	atlas.create(w, h, PixelFormat::createFormatCLUT8());
+	memset(atlas.getPixels(), 0, atlas.h * atlas.pitch);
+
+	for (int y = 0; y < _atlas.h; ++y)
+		memcpy(atlas.getBasePtr(0, y), _atlas.getBasePtr(0, y), _atlas.w);
+
+	_atlas.free();
+	_atlas = atlas;
+}
+
+const TTFFont::Glyph *TTFFont::getGlyph(uint32 chr) const {
+	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
+	if (glyphEntry != _glyphs.end())
+		return &glyphEntry->_value;
+
+	if (!chr || !_allowLateCaching)
+		return 0;
+
 	Glyph newGlyph;
-	if (cacheGlyph(newGlyph, chr)) {
-		_glyphs[chr] = newGlyph;
-	}
+	if (!cacheGlyph(newGlyph, chr))
+		return 0;
+
+	_glyphs[chr] = newGlyph;
+	return &_glyphs[chr];
 }
 
 Font *loadTTFFont(Common::SeekableReadStream &stream, int size, TTFSizeMode sizeMode, uint dpi, TTFRenderMode renderMode, const uint32 *mapping) {
@@ -37,6 +37,12 @@
 #include "graphics/transparent_surface.h"
 #include "graphics/transform_tools.h"
 
+// The SSE2 code assumes the alpha channel in the lowest byte of a pixel
+#if (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && defined(SCUMM_LITTLE_ENDIAN)
+#define TRANSPARENT_SURFACE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 //#define ENABLE_BILINEAR
 
 namespace Graphics {
@@ -65,6 +71,189 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
 void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
 
+#ifdef TRANSPARENT_SURFACE_USE_SSE2
+namespace {
+
+/*
+ * The SSE2 versions of the blitters work on four pixels at a time, with
+ * 16 bits per channel. Their results are identical to the plain versions,
+ * including the rounding and overflow behavior.
+ *
+ * In the 16 bit representation each pixel takes four lanes, which hold
+ * alpha, blue, green and red in this order.
+ */
+
+/** Loads four source pixels, in reverse order if the source is flipped */
+inline __m128i loadPixels(const byte *in, int32 inStep) {
+	if (inStep > 0)
+		return _mm_loadu_si128((const __m128i *)in);
+
+	return _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(in - 12)), _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+/** Copies the alpha value of each pixel to all of its lanes */
+inline __m128i broadcastAlpha(__m128i pixels) {
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0), 0);
+}
+
+/** Picks a for all bits set in mask, b for all others */
+inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/** Builds a vector with the channels of a colormod for each pixel, 0 for alpha */
+inline __m128i colorModLanes(uint32 color) {
+	const int16 r = (color >> kRModShift) & 0xFF;
+	const int16 g = (color >> kGModShift) & 0xFF;
+	const int16 b = (color >> kBModShift) & 0xFF;
+
+	return _mm_set_epi16(r, g, b, 0, r, g, b, 0);
+}
+
+/**
+ * Base for the blend operations. Subclasses supply blend(), which does the
+ * actual math on the 16 bit representation of two pixels.
+ */
+struct BlendOp {
+	/** The alpha channel of the result is fully opaque, else it is kept */
+	bool opaqueAlpha;
+	/** Pixels with zero alpha do not change the target */
+	bool skipTransparent;
+
+	BlendOp(bool opaque, bool skip) : opaqueAlpha(opaque), skipTransparent(skip) {}
+};
+
+template<class Op>
+inline __m128i blendPixels(const Op &op, __m128i src, __m128i dst) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(0xFF);
+
+	__m128i result = _mm_packus_epi16(op.blend(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero)),
+	                                  op.blend(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero)));
+
+	if (op.opaqueAlpha)
+		result = _mm_or_si128(result, alphaMask);
+	else
+		result = select(alphaMask, dst, result);
+
+	if (op.skipTransparent)
+		result = select(_mm_cmpeq_epi32(_mm_and_si128(src, alphaMask), zero), dst, result);
+
+	return result;
+}
+
+/**
+ * Blends as many pixels of a row as possible in groups of four.
+ *
+ * @return the number of pixels done
+ */
+template<class Op>
+uint32 blendRow(const Op &op, const byte *in, byte *out, uint32 width, int32 inStep) {
+	uint32 j = 0;
+
+	for (; j + 4 <= width; j += 4) {
+		const __m128i src = loadPixels(in, inStep);
+		const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+
+		_mm_storeu_si128((__m128i *)out, blendPixels(op, src, dst));
+
+		in += 4 * inStep;
+		out += 16;
+	}
+
+	return j;
+}
+
+struct BinaryOp : public BlendOp {
+	BinaryOp() : BlendOp(true, true) {}
+
+	__m128i blend(__m128i in, __m128i out) const {
+		return in;
+	}
+};
+
+struct AlphaBlendOp : public BlendOp {
+	AlphaBlendOp() : BlendOp(true, true) {}
+
+	// (in * a + out * (255 - a)) >> 8
+	__m128i blend(__m128i in, __m128i out) const {
+		const __m128i a = broadcastAlpha(in);
+		const __m128i invA = _mm_sub_epi16(_mm_set1_epi16(255), a);
+
+		return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(in, a), _mm_mullo_epi16(out, invA)), 8);
+	}
+};
+
+struct AlphaBlendColorOp : public BlendOp {
+	__m128i ca, cmod;
+
+	explicit AlphaBlendColorOp(uint32 color) : BlendOp(true, false),
+		ca(_mm_set1_epi16((color >> kAModShift) & 0xFF)), cmod(colorModLanes(color)) {}
+
+	// (out * (255 - ina) >> 8) + (in * ina * c >> 16), truncated to 8 bits
+	__m128i blend(__m128i in, __m128i out) const {
+		const __m128i ina = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlpha(in), ca), 8);
+		const __m128i invA = _mm_sub_epi16(_mm_set1_epi16(255), ina);
+		const __m128i dst = _mm_srli_epi16(_mm_mullo_epi16(out, invA), 8);
+		const __m128i src = _mm_mulhi_epu16(_mm_mullo_epi16(in, ina), cmod);
+
+		return _mm_and_si128(_mm_add_epi16(dst, src), _mm_set1_epi16(0xFF));
+	}
+};
+
+struct AdditiveBlendOp : public BlendOp {
+	AdditiveBlendOp() : BlendOp(false, true) {}
+
+	// MIN((in * a >> 8) + out, 255), the packing saturates
+	__m128i blend(__m128i in, __m128i out) const {
+		return _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(in, broadcastAlpha(in)), 8), out);
+	}
+};
+
+struct AdditiveBlendColorOp : public BlendOp {
+	__m128i ca, cmod, fullMod;
+
+	explicit AdditiveBlendColorOp(uint32 color) : BlendOp(false, false),
+		ca(_mm_set1_epi16((color >> kAModShift) & 0xFF)), cmod(colorModLanes(color)),
+		fullMod(_mm_cmpeq_epi16(cmod, _mm_set1_epi16(255))) {}
+
+	// MIN(out + (in * c * ina >> 16), 255), or in * ina >> 8 for c == 255
+	__m128i blend(__m128i in, __m128i out) const {
+		const __m128i ina = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlpha(in), ca), 8);
+		const __m128i src = _mm_mullo_epi16(in, ina);
+
+		return _mm_add_epi16(out, select(fullMod, _mm_srli_epi16(src, 8), _mm_mulhi_epu16(src, cmod)));
+	}
+};
+
+struct SubtractiveBlendOp : public BlendOp {
+	SubtractiveBlendOp() : BlendOp(false, true) {}
+
+	// out - (in * out * a >> 16), which never gets negative
+	__m128i blend(__m128i in, __m128i out) const {
+		return _mm_sub_epi16(out, _mm_mulhi_epu16(_mm_mullo_epi16(in, out), broadcastAlpha(in)));
+	}
+};
+
+struct SubtractiveBlendColorOp : public BlendOp {
+	__m128i cmod, fullMod;
+
+	explicit SubtractiveBlendColorOp(uint32 color) : BlendOp(true, false),
+		cmod(colorModLanes(color)), fullMod(_mm_cmpeq_epi16(cmod, _mm_set1_epi16(255))) {}
+
+	// out - (in * c * out * a >> 24), or in * out * a >> 16 for c == 255
+	__m128i blend(__m128i in, __m128i out) const {
+		const __m128i a = broadcastAlpha(in);
+		const __m128i src = _mm_mullo_epi16(in, out);
+		const __m128i modded = _mm_srli_epi16(_mm_mulhi_epu16(src, _mm_mullo_epi16(cmod, a)), 8);
+
+		return _mm_sub_epi16(out, select(fullMod, _mm_mulhi_epu16(src, a), modded));
+	}
+};
+
+} // End of anonymous namespace
+#endif // TRANSPARENT_SURFACE_USE_SSE2
+
 TransparentSurface::TransparentSurface() : Surface(), _alphaMode(ALPHA_FULL) {}
 
 TransparentSurface::TransparentSurface(const Surface &surf, bool copyData) : Surface(), _alphaMode(ALPHA_FULL) {
@@ -114,7 +303,13 @@ void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 	for (uint32 i = 0; i < height; i++) {
 		out = outo;
 		in = ino;
-		for (uint32 j = 0; j < width; j++) {
+		uint32 j = 0;
+#ifdef TRANSPARENT_SURFACE_USE_SSE2
+		j = blendRow(BinaryOp(), in, out, width, inStep);
+		in += (int32)j * inStep;
+		out += j * 4;
+#endif
+		for (; j < width; j++) {
 			uint32 pix = *(uint32 *)in;
 			int a = in[kAIndex];
 
@@ -150,7 +345,13 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef TRANSPARENT_SURFACE_USE_SSE2
+			j = blendRow(AlphaBlendOp(), in, out, width, inStep);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kAIndex] = 255;
@@ -175,7 +376,13 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef TRANSPARENT_SURFACE_USE_SSE2
+			j = blendRow(AlphaBlendColorOp(color), in, out, width, inStep);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
 				out[kAIndex] = 255;
@@ -208,7 +415,13 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef TRANSPARENT_SURFACE_USE_SSE2
+			j = blendRow(AdditiveBlendOp(), in, out, width, inStep);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kRIndex] = MIN((in[kRIndex] * in[kAIndex] >> 8) + out[kRIndex], 255);
@@ -232,7 +445,13 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef TRANSPARENT_SURFACE_USE_SSE2
+			j = blendRow(AdditiveBlendColorOp(color), in, out, width, inStep);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
 
@@ -275,7 +494,13 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef TRANSPARENT_SURFACE_USE_SSE2
+			j = blendRow(SubtractiveBlendOp(), in, out, width, inStep);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kRIndex] = MAX(out[kRIndex] - ((in[kRIndex] * out[kRIndex]) * in[kAIndex] >> 16), 0);
@@ -298,7 +523,13 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 		for (uint32 i = 0; i < height; i++) {
 			out = outo;
 			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = 0;
+#ifdef TRANSPARENT_SURFACE_USE_SSE2
+			j = blendRow(SubtractiveBlendColorOp(color), in, out, width, inStep);
+			in += (int32)j * inStep;
+			out += j * 4;
+#endif
+			for (; j < width; j++) {
 
 				out[kAIndex] = 255;
 				if (cb != 255) {
@@ -964,9 +1195,19 @@ TransparentSurface *TransparentSurface::scale(uint16 newWidth, uint16 newHeight)
 		scaleCacheX[x] = (x * srcW) / dstW;
 	}
 
+	int lastSrcY = -1;
 	for (int y = 0; y < dstH; y++) {
 		uint32 *destP = (uint32 *)target->getBasePtr(0, y);
-		const uint32 *srcP = (const uint32 *)getBasePtr(0, (y * srcH) / dstH);
+		const int srcY = (y * srcH) / dstH;
+
+		// When enlarging, consecutive rows come from the same source row
+		if (srcY == lastSrcY) {
+			memcpy(destP, target->getBasePtr(0, y - 1), dstW * 4);
+			continue;
+		}
+		lastSrcY = srcY;
+
+		const uint32 *srcP = (const uint32 *)getBasePtr(0, srcY);
 		for (int x = 0; x < dstW; x++) {
 			*destP++ = srcP[scaleCacheX[x]];
 		}
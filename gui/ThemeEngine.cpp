@@ -90,6 +90,10 @@ struct WidgetDrawData {
 
 	bool _buffer;
 
+	/** Whether the drawing only depends on the size of the widget, so
+	    ThemeEngine::drawDrawData may cache it. */
+	bool _cacheable;
+
 
 	/**
 	 * Calculates the background threshold offset of a given DrawData item.
@@ -99,8 +103,67 @@ struct WidgetDrawData {
 	 * value will be added when restoring the background of the widget.
 	 */
 	void calcBackgroundOffset();
+
+	/**
+	 * Checks whether drawings of this DrawData item can be cached.
+	 * Steps which draw outside of the clipping area or depend on the
+	 * absolute position of the widget prevent caching.
+	 */
+	void calcCacheable();
+};
+
+/**
+ * A drawing of a DrawData item. The draw steps produce the same pixels
+ * again when drawn with the same size, dynamic data and inherited renderer
+ * state over the same background. In that case they are copied instead.
+ */
+struct CachedDrawing {
+	const WidgetDrawData *data;
+	int width, height;
+	int xParity; ///< Gradients are dithered by the absolute column
+	uint32 dynamicData;
+	bool clipped;
+	Common::Rect region; ///< Drawn area relative to the widget area
+	Graphics::VectorRenderer::InheritedState state;
+
+	Graphics::Surface background; ///< Pixels of the region before drawing
+	Graphics::Surface result;     ///< Pixels of the region after drawing
+
+	~CachedDrawing() {
+		background.free();
+		result.free();
+	}
 };
 
+namespace {
+
+/** Maximum number of cached DrawData drawings */
+const uint kMaxCachedDrawings = 32;
+
+/** Maximum size of a cached drawing in pixels. Larger items like dialog
+    backgrounds are drawn rarely and would only waste memory. */
+const int kMaxCachedDrawingSize = 128 * 128;
+
+void copyRegion(Graphics::Surface &dst, const Graphics::Surface &src, const Common::Rect &region) {
+	if (!dst.getPixels())
+		dst.create(region.width(), region.height(), src.format);
+
+	dst.copyRectToSurface(src, 0, 0, region);
+}
+
+bool compareRegion(const Graphics::Surface &cached, const Graphics::Surface &surface, const Common::Rect &region) {
+	const uint lineSize = region.width() * surface.format.bytesPerPixel;
+
+	for (int y = 0; y < region.height(); ++y) {
+		if (memcmp(cached.getBasePtr(0, y), surface.getBasePtr(region.left, region.top + y), lineSize) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+} // End of anonymous namespace
+
 class ThemeItem {
 
 public:
@@ -275,11 +338,8 @@ void ThemeItemDrawData::drawSelf(bool draw, bool restore) {
 	if (restore)
 		_engine->restoreBackground(extendedRect);
 
-	if (draw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
-		for (step = _data->_steps.begin(); step != _data->_steps.end(); ++step)
-			_engine->renderer()->drawStep(_area, *step, _dynamicData);
-	}
+	if (draw)
+		_engine->drawDrawData(_data, _area, extendedRect, 0, _dynamicData);
 
 	_engine->addDirtyRect(extendedRect);
 }
@@ -292,12 +352,8 @@ void ThemeItemDrawDataClip::drawSelf(bool draw, bool restore) {
 	if (restore)
 		_engine->restoreBackground(extendedRect);
 
-	if (draw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
-		for (step = _data->_steps.begin(); step != _data->_steps.end(); ++step) {
-			_engine->renderer()->drawStepClip(_area, _clip, *step, _dynamicData);
-		}
-	}
+	if (draw)
+		_engine->drawDrawData(_data, _area, extendedRect, &_clip, _dynamicData);
 
 	extendedRect.clip(_clip);
 
@@ -418,6 +474,7 @@ ThemeEngine::~ThemeEngine() {
 	_backBuffer.free();
 
 	unloadTheme();
+	clearDrawingCache();
 
 	// Release all graphics surfaces
 	for (ImagesMap::iterator i = _bitmaps.begin(); i != _bitmaps.end(); ++i) {
@@ -638,6 +695,9 @@ void ThemeEngine::setGraphicsMode(GraphicsMode mode) {
 	_vectorRenderer = Graphics::createRenderer(mode);
 	_vectorRenderer->setSurface(&_screen);
 
+	// The cached drawings have the old size and pixel format
+	clearDrawingCache();
+
 	// Since we reinitialized our screen surfaces we know nothing has been
 	// drawn so far. Sometimes we still end up with dirty screen bits in the
 	// list. Clearing it avoids invalid overlay writes when the backend
@@ -659,11 +719,108 @@ void WidgetDrawData::calcBackgroundOffset() {
 	_backgroundOffset = maxShadow;
 }
 
+void WidgetDrawData::calcCacheable() {
+	_cacheable = true;
+	for (Common::List<Graphics::DrawStep>::const_iterator step = _steps.begin();
+	        step != _steps.end(); ++step) {
+		// Scaling is applied to the absolute coordinates, surface fills
+		// and alpha bitmaps ignore the clipping area.
+		if ((step->scale != (1 << 16) && step->scale != 0)
+		        || step->drawingCall == &Graphics::VectorRenderer::drawCallback_FILLSURFACE
+		        || step->drawingCall == &Graphics::VectorRenderer::drawCallback_ALPHABITMAP) {
+			_cacheable = false;
+			return;
+		}
+	}
+}
+
 void ThemeEngine::restoreBackground(Common::Rect r) {
 	r.clip(_screen.w, _screen.h);
 	_vectorRenderer->blitSurface(&_backBuffer, r);
 }
 
+void ThemeEngine::drawDrawData(const WidgetDrawData *data, const Common::Rect &area, Common::Rect region, const Common::Rect *clip, uint32 dynamicData) {
+	Graphics::TransparentSurface *surface = _vectorRenderer->getSurface();
+
+	// Widgets which are not completely on the surface are drawn differently
+	// depending on their position.
+	bool cacheable = data->_cacheable && region.left >= 0 && region.top >= 0
+	                 && region.right <= surface->w && region.bottom <= surface->h;
+
+	if (clip)
+		region.clip(*clip);
+
+	cacheable = cacheable && !region.isEmpty() && region.width() * region.height() <= kMaxCachedDrawingSize;
+
+	CachedDrawing *drawing = 0;
+	if (cacheable) {
+		Graphics::VectorRenderer::InheritedState state;
+		_vectorRenderer->getInheritedState(state);
+
+		Common::Rect relative = region;
+		relative.translate(-area.left, -area.top);
+
+		for (Common::List<CachedDrawing *>::iterator i = _drawingCache.begin(); i != _drawingCache.end(); ++i) {
+			CachedDrawing *cached = *i;
+			if (cached->data == data && cached->width == area.width() && cached->height == area.height()
+			        && cached->xParity == (area.left & 1) && cached->dynamicData == dynamicData && cached->clipped == (clip != 0)
+			        && cached->region == relative && cached->state == state) {
+				drawing = cached;
+				_drawingCache.erase(i);
+				break;
+			}
+		}
+
+		if (drawing && compareRegion(drawing->background, *surface, region)) {
+			surface->copyRectToSurface(drawing->result, region.left, region.top, Common::Rect(region.width(), region.height()));
+
+			// Leave the renderer in the same state as drawing the steps would
+			for (Common::List<Graphics::DrawStep>::const_iterator step = data->_steps.begin(); step != data->_steps.end(); ++step)
+				_vectorRenderer->setupStep(*step, dynamicData);
+
+			_drawingCache.push_front(drawing);
+			return;
+		}
+
+		if (!drawing) {
+			if (_drawingCache.size() >= kMaxCachedDrawings) {
+				delete _drawingCache.back();
+				_drawingCache.pop_back();
+			}
+
+			drawing = new CachedDrawing();
+			drawing->data = data;
+			drawing->width = area.width();
+			drawing->height = area.height();
+			drawing->xParity = area.left & 1;
+			drawing->dynamicData = dynamicData;
+			drawing->clipped = (clip != 0);
+			drawing->region = relative;
+			drawing->state = state;
+		}
+
+		copyRegion(drawing->background, *surface, region);
+	}
+
+	for (Common::List<Graphics::DrawStep>::const_iterator step = data->_steps.begin(); step != data->_steps.end(); ++step) {
+		if (clip)
+			_vectorRenderer->drawStepClip(area, *clip, *step, dynamicData);
+		else
+			_vectorRenderer->drawStep(area, *step, dynamicData);
+	}
+
+	if (drawing) {
+		copyRegion(drawing->result, *surface, region);
+		_drawingCache.push_front(drawing);
+	}
+}
+
+void ThemeEngine::clearDrawingCache() {
+	for (Common::List<CachedDrawing *>::iterator i = _drawingCache.begin(); i != _drawingCache.end(); ++i)
+		delete *i;
+	_drawingCache.clear();
+}
+
 
 
 /**********************************************************
@@ -858,6 +1015,7 @@ bool ThemeEngine::addDrawData(const Common::String &data, bool cached) {
 	_widgets[id] = new WidgetDrawData;
 	_widgets[id]->_buffer = kDrawDataDefaults[id].buffer;
 	_widgets[id]->_textDataId = kTextDataNone;
+	_widgets[id]->_cacheable = false;
 
 	return true;
 }
@@ -888,6 +1046,7 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 			warning("Missing data asset: '%s'", kDrawDataDefaults[i].name);
 		} else {
 			_widgets[i]->calcBackgroundOffset();
+			_widgets[i]->calcCacheable();
 		}
 	}
 }
@@ -896,6 +1055,9 @@ void ThemeEngine::unloadTheme() {
 	if (!_themeOk)
 		return;
 
+	// The cached drawings point to the DrawData items
+	clearDrawingCache();
+
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		delete _widgets[i];
 		_widgets[i] = 0;
@@ -2220,12 +2382,10 @@ bool ThemeEngine::themeConfigUsable(const Common::FSNode &node, Common::String &
 			// Open THEMERC from the ZIP file.
 			stream.open("THEMERC", *zipArchive);
 		}
-		// Delete the ZIP archive again. Note: This only works because
-		// stream.open() only uses ZipArchive::createReadStreamForMember,
-		// and that in turn happens to read all the data for a given
-		// archive member into a memory block. So there will be no dangling
-		// reference to zipArchive anywhere. This could change if we
-		// ever modify ZipArchive::createReadStreamForMember.
+		// Delete the ZIP archive again. Streams created by
+		// ZipArchive::createReadStreamForMember either hold the member
+		// data in memory or have their own handle on the archive file,
+		// so the THEMERC stream stays usable.
 		delete zipArchive;
 	} else if (node.isDirectory()) {
 		Common::FSNode headerfile = node.getChild("THEMERC");
@@ -49,6 +49,7 @@ class VectorRenderer;
 namespace GUI {
 
 struct WidgetDrawData;
+struct CachedDrawing;
 struct TextDrawData;
 struct TextColorData;
 class Dialog;
@@ -581,6 +582,19 @@ public:
 	 */
 	void restoreBackground(Common::Rect r);
 
+	/**
+	 * Draws all the steps of a DrawData item on the active surface.
+	 * When the item was drawn before with the same size over the same
+	 * background, the cached result is copied instead.
+	 *
+	 * @param data DrawData item to draw.
+	 * @param area Area of the widget.
+	 * @param region Area the draw steps may draw on.
+	 * @param clip Clipping area, or 0 to draw without clipping.
+	 * @param dynamicData Dynamic data of the widget.
+	 */
+	void drawDrawData(const WidgetDrawData *data, const Common::Rect &area, Common::Rect region, const Common::Rect *clip, uint32 dynamicData);
+
 	const Common::String &getThemeName() const { return _themeName; }
 	const Common::String &getThemeId() const { return _themeId; }
 	int getGraphicsMode() const { return _graphicsMode; }
@@ -617,6 +631,12 @@ protected:
 	 */
 	void unloadTheme();
 
+	/**
+	 * Frees all cached DrawData drawings. Needs to be called whenever
+	 * the DrawData items or the screen surfaces change.
+	 */
+	void clearDrawingCache();
+
 	const Graphics::Font *loadScalableFont(const Common::String &filename, const Common::String &charset, const int pointsize, Common::String &name);
 	const Graphics::Font *loadFont(const Common::String &filename, Common::String &name);
 	Common::String genCacheFilename(const Common::String &filename) const;
@@ -737,6 +757,9 @@ protected:
 	/** Queue with all the drawing that must be done to the screen */
 	Common::List<ThemeItem *> _screenQueue;
 
+	/** Recently drawn DrawData items, the most recently used first */
+	Common::List<CachedDrawing *> _drawingCache;
+
 	bool _initOk;  ///< Class and renderer properly initialized
 	bool _themeOk; ///< Theme data successfully loaded.
 	bool _enabled; ///< Whether the Theme is currently shown on the overlay
@@ -858,6 +858,8 @@ static const char *credits[] = {
 "C2""For generously providing hosting for our buildbot, SVN repository, planet and doxygen sites as well as tons of HD space",
 "C0""DOSBox Team",
 "C2""For their awesome OPL2 and OPL3 emulator",
+"C0""Nuke.YKT",
+"C2""For the Nuked OPL3 emulator, which our reference OPL emulator is based on",
 "C0""Yusuke Kamiyamane",
 "C2""For contributing some GUI icons",
 "C0""Till Kresslein",
@@ -34,6 +34,10 @@
 #include "common/stream.h"
 #endif
 
+#include "common/file.h"
+
+#include "audio/fmopl.h"
+
 #include "engines/engine.h"
 
 #include "gui/debugger.h"
@@ -78,6 +82,10 @@ Debugger::Debugger() {
 	registerCmd("debugflag_list",		WRAP_METHOD(Debugger, cmdDebugFlagsList));
 	registerCmd("debugflag_enable",	WRAP_METHOD(Debugger, cmdDebugFlagEnable));
 	registerCmd("debugflag_disable",	WRAP_METHOD(Debugger, cmdDebugFlagDisable));
+
+	registerCmd("opl_info",			WRAP_METHOD(Debugger, cmdOplInfo));
+	registerCmd("opl_stats",		WRAP_METHOD(Debugger, cmdOplStats));
+	registerCmd("opl_dump",			WRAP_METHOD(Debugger, cmdOplDump));
 }
 
 Debugger::~Debugger() {
@@ -728,6 +736,92 @@ bool Debugger::cmdDebugFlagDisable(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::cmdOplInfo(int argc, const char **argv) {
+	const OPL::OPL *opl = OPL::OPL::getInstance();
+	if (!opl) {
+		debugPrintf("No OPL in use\n");
+		return true;
+	}
+
+	if (opl->isInstrumented()) {
+		const OPL::Statistics stats = opl->getStatistics();
+		const uint32 duration = g_system->getMillis() - stats.startTime;
+		debugPrintf("Statistics over the last %u ms:\n", duration);
+		debugPrintf("  %u register writes, %u timer callbacks\n", stats.writes, stats.callbacks);
+		if (stats.blocks) {
+			debugPrintf("  %u blocks with %u frames rendered\n", stats.blocks, stats.frames);
+			debugPrintf("  %u ms spent rendering, at most %u ms per block\n", stats.renderTime, stats.maxBlockTime);
+		}
+	} else {
+		debugPrintf("Statistics are disabled, use opl_stats on to enable them\n");
+	}
+
+	static const char *const phaseNames[] = { "off", "attack", "decay", "sustain", "release" };
+	if (!opl->getChannelCount()) {
+		debugPrintf("The OPL emulator does not report channel status\n");
+		return true;
+	}
+
+	debugPrintf("Channel  Key  Phase    Operators  Mode\n");
+	for (int i = 0; i < opl->getChannelCount(); ++i) {
+		OPL::ChannelStatus status;
+		if (!opl->getChannelStatus(i, status))
+			continue;
+		debugPrintf("%7d  %-3s  %-7s  %9d  %s\n", i, status.keyOn ? "on" : "off", phaseNames[status.phase],
+		            status.activeOperators, status.synthMode ? status.synthMode : "-");
+	}
+	return true;
+}
+
+bool Debugger::cmdOplStats(int argc, const char **argv) {
+	OPL::OPL *opl = OPL::OPL::getInstance();
+	if (!opl) {
+		debugPrintf("No OPL in use\n");
+		return true;
+	}
+
+	if (argc < 2) {
+		debugPrintf("OPL statistics are %s\n", opl->isInstrumented() ? "enabled" : "disabled");
+		debugPrintf("Usage: %s <on | off | reset>\n", argv[0]);
+	} else if (!scumm_stricmp(argv[1], "on")) {
+		opl->setInstrumentation(true);
+		debugPrintf("Enabled OPL statistics\n");
+	} else if (!scumm_stricmp(argv[1], "off")) {
+		opl->setInstrumentation(false);
+		debugPrintf("Disabled OPL statistics\n");
+	} else if (!scumm_stricmp(argv[1], "reset")) {
+		opl->resetStatistics();
+		debugPrintf("Reset OPL statistics\n");
+	} else {
+		debugPrintf("Usage: %s <on | off | reset>\n", argv[0]);
+	}
+	return true;
+}
+
+bool Debugger::cmdOplDump(int argc, const char **argv) {
+	if (argc < 2) {
+		debugPrintf("Usage: %s <filename>\n", argv[0]);
+		return true;
+	}
+
+	const OPL::OPL *opl = OPL::OPL::getInstance();
+	if (!opl) {
+		debugPrintf("No OPL in use\n");
+		return true;
+	}
+
+	Common::DumpFile file;
+	if (!file.open(argv[1])) {
+		debugPrintf("Could not open '%s' for writing\n", argv[1]);
+		return true;
+	}
+
+	opl->writeStatusCSV(file);
+	file.finalize();
+	debugPrintf("Wrote OPL status to '%s'\n", argv[1]);
+	return true;
+}
+
 // Console handler
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 bool Debugger::debuggerInputCallback(GUI::ConsoleDialog *console, const char *input, void *refCon) {
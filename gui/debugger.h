@@ -226,6 +226,9 @@ protected:
 	bool cmdDebugFlagsList(int argc, const char **argv);
 	bool cmdDebugFlagEnable(int argc, const char **argv);
 	bool cmdDebugFlagDisable(int argc, const char **argv);
+	bool cmdOplInfo(int argc, const char **argv);
+	bool cmdOplStats(int argc, const char **argv);
+	bool cmdOplDump(int argc, const char **argv);
 
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 private:
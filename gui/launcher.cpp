@@ -30,6 +30,8 @@
 #include "common/system.h"
 #include "common/translation.h"
 
+#include "engines/detectioncache.h"
+
 #include "gui/about.h"
 #include "gui/browser.h"
 #include "gui/chooser.h"
@@ -549,6 +551,7 @@ bool LauncherDialog::doGameDetection(const Common::String &path) {
 	// ...so let's determine a list of candidates, games that
 	// could be contained in the specified directory.
 	GameList candidates(EngineMan.detectGames(files));
+	DetectionCacheMan.flush();
 
 	int idx;
 	if (candidates.empty()) {
@@ -0,0 +1,279 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/softsynth/opl/dosbox.h"
+#include "audio/softsynth/opl/harness.h"
+
+#include "common/memstream.h"
+
+#include "test/null_osystem.h"
+
+class OplTestSuite : public CxxTest::TestSuite
+{
+	// Plays a sine on channel 0 for half a second, then releases it
+	static void createNoteLog(OPL::Harness::RegisterLog &log) {
+		static const uint16 regs[] = {
+			0x20, 0x01, 0x40, 0x3f, 0x60, 0xf4, 0x80, 0x77,
+			0x23, 0x01, 0x43, 0x00, 0x63, 0xf4, 0x83, 0x77,
+			0xc0, 0x01, 0xa0, 0x98, 0xb0, 0x31
+		};
+
+		for (uint i = 0; i < ARRAYSIZE(regs); i += 2)
+			log.addWrite(0, regs[i], regs[i + 1]);
+
+		log.addWrite(log.getRate() / 2, 0xb0, 0x11);
+		log.extend(log.getRate());
+	}
+
+	public:
+	void setUp() {
+		// The DOSBox renderer runs the driver, which needs OSystem
+		Common::install_null_g_system();
+	}
+
+	void test_reference_silence() {
+		OPL::Harness::RegisterLog log;
+		log.extend(4096);
+
+		OPL::Harness::Renderer *renderer = OPL::Harness::createRenderer("reference");
+		TS_ASSERT(renderer);
+
+		Common::Array<int16> output;
+		TS_ASSERT(OPL::Harness::render(log, *renderer, output));
+		TS_ASSERT_EQUALS(output.size(), 4096u);
+
+		for (uint i = 0; i < output.size(); ++i)
+			TS_ASSERT_EQUALS(output[i], 0);
+
+		delete renderer;
+	}
+
+	void test_reference_deterministic() {
+		OPL::Harness::RegisterLog log;
+		createNoteLog(log);
+
+		OPL::Harness::Renderer *renderer = OPL::Harness::createRenderer("reference");
+		Common::Array<int16> first, second;
+		TS_ASSERT(OPL::Harness::render(log, *renderer, first));
+		TS_ASSERT(OPL::Harness::render(log, *renderer, second));
+		delete renderer;
+
+		OPL::Harness::Report report;
+		OPL::Harness::compare(first, second, 1, 1024, 16, report);
+
+		TS_ASSERT(report.referenceRms > 1000.0);
+		TS_ASSERT_EQUALS(report.rmsError, 0.0);
+		TS_ASSERT_EQUALS(report.peakError, 0);
+		TS_ASSERT_EQUALS(report.timingOffset, 0);
+		TS_ASSERT_EQUALS(report.blocks.size(), (log.getLength() + 1023) / 1024);
+	}
+
+	void test_compare_timing_offset() {
+		Common::Array<int16> reference, delayed;
+		for (int i = 0; i < 2048; ++i)
+			reference.push_back((int16)((i * 37) % 1000 - 500));
+		for (int i = 0; i < 2048; ++i)
+			delayed.push_back(i < 5 ? 0 : reference[i - 5]);
+
+		OPL::Harness::Report report;
+		OPL::Harness::compare(reference, delayed, 1, 512, 16, report);
+
+		TS_ASSERT_EQUALS(report.timingOffset, 5);
+		TS_ASSERT(report.peakError > 0);
+	}
+
+	void test_reference_release() {
+		OPL::Harness::RegisterLog log;
+		createNoteLog(log);
+
+		OPL::Harness::Renderer *renderer = OPL::Harness::createRenderer("reference");
+		Common::Array<int16> output;
+		TS_ASSERT(OPL::Harness::render(log, *renderer, output));
+		delete renderer;
+
+		// Release rate 7 decays the note well before the log ends. Like on
+		// the real chip, a silent operator still outputs -1 on the negative
+		// half of its waveform.
+		for (uint i = output.size() - 1024; i < output.size(); ++i)
+			TS_ASSERT(ABS(output[i]) <= 2);
+	}
+
+	void test_dosbox_against_reference() {
+		OPL::Harness::RegisterLog log;
+		createNoteLog(log);
+
+		Common::Array<Common::String> emulators;
+		emulators.push_back("db");
+
+		Common::Array<OPL::Harness::Report> reports;
+		TS_ASSERT(OPL::Harness::run(log, emulators, 1024, reports));
+		TS_ASSERT_EQUALS(reports.size(), 1u);
+
+		// Both cores have to play the same note at the same time
+		TS_ASSERT(ABS(reports[0].timingOffset) <= 2);
+		TS_ASSERT(reports[0].rmsError < reports[0].referenceRms / 4);
+	}
+
+	void test_dosbox_dual_opl2_against_reference() {
+		// The same note on both chips, an octave higher on the right one
+		OPL::Harness::RegisterLog log(OPL::Config::kDualOpl2);
+		static const uint16 regs[] = {
+			0x20, 0x01, 0x40, 0x3f, 0x60, 0xf4, 0x80, 0x77,
+			0x23, 0x01, 0x43, 0x00, 0x63, 0xf4, 0x83, 0x77,
+			0xc0, 0x01, 0xa0, 0x98
+		};
+
+		for (uint i = 0; i < ARRAYSIZE(regs); i += 2) {
+			log.addWrite(0, regs[i], regs[i + 1]);
+			log.addWrite(0, regs[i] | 0x100, regs[i + 1]);
+		}
+		log.addWrite(0, 0xb0, 0x31);
+		log.addWrite(0, 0x1b0, 0x35);
+		log.extend(log.getRate() / 2);
+
+		Common::Array<Common::String> emulators;
+		emulators.push_back("db");
+
+		Common::Array<OPL::Harness::Report> reports;
+		TS_ASSERT(OPL::Harness::run(log, emulators, 1024, reports));
+		TS_ASSERT_EQUALS(reports.size(), 1u);
+
+		TS_ASSERT(reports[0].referenceRms > 1000.0);
+		TS_ASSERT(ABS(reports[0].timingOffset) <= 2);
+		TS_ASSERT(reports[0].rmsError < reports[0].referenceRms / 4);
+	}
+
+	void test_dosbox_dual_opl2() {
+#ifndef DISABLE_DOSBOX_OPL
+		OPL::DOSBox::OPL opl(OPL::Config::kDualOpl2);
+		TS_ASSERT(opl.init());
+		opl.setInstrumentation(true);
+		opl.setCallbackFrequency(50);
+
+		// A note on the left chip only. Both operators use the half sine,
+		// which is only available because the driver keeps the waveform
+		// select of register 0x01 enabled.
+		static const uint8 regs[] = {
+			0x01, 0x00,
+			0x20, 0x01, 0x40, 0x10, 0x60, 0xf4, 0x80, 0x77, 0xe0, 0x01,
+			0x23, 0x01, 0x43, 0x00, 0x63, 0xf4, 0x83, 0x77, 0xe3, 0x01,
+			0xc0, 0x01, 0xa0, 0x98, 0xb0, 0x31
+		};
+
+		for (uint i = 0; i < ARRAYSIZE(regs); i += 2) {
+			opl.write(0x220, regs[i]);
+			opl.write(0x221, regs[i + 1]);
+		}
+		TS_ASSERT_EQUALS(opl.getStatistics().writes, (uint32)ARRAYSIZE(regs) / 2);
+
+		// A write through the shared ports goes to both chips
+		opl.write(0x388, 0xbd);
+		opl.write(0x389, 0x00);
+		TS_ASSERT_EQUALS(opl.getStatistics().writes, (uint32)ARRAYSIZE(regs) / 2 + 2);
+
+		int16 buffer[2 * 4096];
+		TS_ASSERT_EQUALS(opl.readBuffer(buffer, ARRAYSIZE(buffer)), (int)ARRAYSIZE(buffer));
+		TS_ASSERT_EQUALS(opl.getStatistics().blocks, 1u);
+		TS_ASSERT_EQUALS(opl.getStatistics().frames, (uint32)ARRAYSIZE(buffer) / 2);
+
+		// Channels 0-8 are on the left chip, 9-17 on the right one
+		OPL::ChannelStatus status;
+		TS_ASSERT(opl.getChannelStatus(0, status));
+		TS_ASSERT(status.keyOn);
+		TS_ASSERT(opl.getChannelStatus(9, status));
+		TS_ASSERT(!status.keyOn);
+
+		int16 minLeft = 0, maxLeft = 0, maxRight = 0;
+		for (uint i = 0; i < ARRAYSIZE(buffer); i += 2) {
+			minLeft = MIN(minLeft, buffer[i]);
+			maxLeft = MAX(maxLeft, buffer[i]);
+			maxRight = MAX<int16>(maxRight, ABS(buffer[i + 1]));
+		}
+
+		// Only the positive half waves are played, up to rounding noise
+		TS_ASSERT(maxLeft > 1000);
+		TS_ASSERT(minLeft > -maxLeft / 16);
+		TS_ASSERT_EQUALS(maxRight, 0);
+#endif
+	}
+
+	void test_tick_scheduler() {
+		OPL::TickScheduler scheduler;
+		scheduler.setRates(44100, 250);
+		scheduler.reset();
+
+		// A reset makes the next tick due immediately
+		TS_ASSERT_EQUALS(scheduler.getUnitsToNextTick(), 0u);
+		TS_ASSERT_EQUALS(scheduler.advance(0), 1u);
+
+		// 44100 / 250 = 176.4, so the ticks are 176 or 177 samples apart
+		TS_ASSERT_EQUALS(scheduler.getUnitsToNextTick(), 177u);
+
+		// One second has exactly 250 ticks, no matter how the clock is advanced
+		uint32 ticks = 0;
+		for (uint32 i = 0; i < 44100; i += 7)
+			ticks += scheduler.advance(MIN<uint32>(7, 44100 - i));
+		TS_ASSERT_EQUALS(ticks, 250u);
+
+		ticks = 0;
+		for (uint32 i = 0; i < 44100;) {
+			uint32 step = scheduler.getUnitsToNextTick();
+			TS_ASSERT(step == 176 || step == 177);
+			i += step;
+			ticks += scheduler.advance(step);
+		}
+		TS_ASSERT_EQUALS(ticks, 250u);
+	}
+
+	void test_tick_scheduler_fast_ticks() {
+		// Ticks faster than the clock are delivered in groups
+		OPL::TickScheduler scheduler;
+		scheduler.setRates(100, 250);
+
+		uint32 ticks = 0;
+		for (int i = 0; i < 100; ++i) {
+			uint32 due = scheduler.advance(1);
+			TS_ASSERT(due == 2 || due == 3);
+			ticks += due;
+		}
+		TS_ASSERT_EQUALS(ticks, 250u);
+	}
+
+	void test_tick_scheduler_timer_procs() {
+		// RealOPL runs slow drivers at their own frequency, each timer proc
+		// has to deliver exactly one tick
+		OPL::TickScheduler scheduler;
+		scheduler.setRates(60, 60);
+
+		for (int i = 0; i < 120; ++i)
+			TS_ASSERT_EQUALS(scheduler.advance(1), 1u);
+	}
+
+	void test_load_dro() {
+		static const byte dro[] = {
+			'D', 'B', 'R', 'A', 'W', 'O', 'P', 'L',
+			0x02, 0x00, 0x00, 0x00,	// version 2.0
+			0x04, 0x00, 0x00, 0x00,	// 4 pairs
+			0x00, 0x02, 0x00, 0x00,	// 512 ms
+			0x00, 0x00, 0x00,		// OPL2, interleaved, uncompressed
+			0x7e, 0x7f,				// short and long delay codes
+			0x02, 0xa0, 0xb0,		// codemap
+			0x00, 0x98,				// 0xa0 = 0x98
+			0x7e, 0x09,				// delay 10 ms
+			0x01, 0x31,				// 0xb0 = 0x31
+			0x7f, 0x00				// delay 256 ms
+		};
+
+		Common::MemoryReadStream stream(dro, sizeof(dro));
+		OPL::Harness::RegisterLog log(OPL::Config::kDualOpl2, 1000);
+		TS_ASSERT(log.loadDRO(stream));
+
+		TS_ASSERT_EQUALS(log.getType(), OPL::Config::kOpl2);
+		TS_ASSERT_EQUALS(log.getWrites().size(), 2u);
+		TS_ASSERT_EQUALS(log.getWrites()[0].reg, 0xa0);
+		TS_ASSERT_EQUALS(log.getWrites()[0].value, 0x98);
+		TS_ASSERT_EQUALS(log.getWrites()[0].sample, 0u);
+		TS_ASSERT_EQUALS(log.getWrites()[1].reg, 0xb0);
+		TS_ASSERT_EQUALS(log.getWrites()[1].sample, 10u);
+		TS_ASSERT_EQUALS(log.getLength(), 512u);
+	}
+};
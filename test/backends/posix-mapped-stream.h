@@ -0,0 +1,100 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+// The tests only run on builds which map files, see posix-fs.cpp
+#if defined(POSIX_USE_MMAP) && !defined(__OS2__)
+#define TEST_MAPPED_STREAMS
+
+#include "backends/fs/posix/posix-mapped-stream.h"
+
+#include "common/fs.h"
+#include "common/stream.h"
+
+#include "test/null_osystem.h"
+#endif
+
+class PosixMappedStreamTestSuite : public CxxTest::TestSuite
+{
+#ifdef TEST_MAPPED_STREAMS
+	// Written to the directory the tests are run in
+	static const char *getPath() { return "posix-mapped-stream-test.dat"; }
+#endif
+
+	public:
+	void setUp() {
+#ifdef TEST_MAPPED_STREAMS
+		Common::install_null_g_system();
+
+		Common::WriteStream *stream = Common::FSNode(getPath()).createWriteStream();
+		TS_ASSERT(stream);
+		for (uint32 i = 0; i < 1000; ++i)
+			stream->writeByte(i * 3);
+		stream->finalize();
+		delete stream;
+#endif
+	}
+
+	void test_read_and_seek() {
+#ifdef TEST_MAPPED_STREAMS
+		PosixMappedStream *stream = PosixMappedStream::makeFromPath(getPath(), 0, 1024);
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->size(), 1000);
+
+		TS_ASSERT_EQUALS(stream->readByte(), 0);
+		TS_ASSERT_EQUALS(stream->readByte(), 3);
+
+		TS_ASSERT(stream->seek(500));
+		TS_ASSERT_EQUALS(stream->readByte(), (byte)(500 * 3));
+		TS_ASSERT(stream->seek(-10, SEEK_CUR));
+		TS_ASSERT_EQUALS(stream->pos(), 491);
+		TS_ASSERT(stream->seek(-1, SEEK_END));
+		TS_ASSERT_EQUALS(stream->readByte(), (byte)(999 * 3));
+
+		delete stream;
+#endif
+	}
+
+	void test_eos() {
+#ifdef TEST_MAPPED_STREAMS
+		PosixMappedStream *stream = PosixMappedStream::makeFromPath(getPath(), 0, 1024);
+		TS_ASSERT(stream->seek(-2, SEEK_END));
+
+		byte buffer[4];
+		TS_ASSERT(!stream->eos());
+		TS_ASSERT_EQUALS(stream->read(buffer, sizeof(buffer)), 2u);
+		TS_ASSERT(stream->eos());
+		TS_ASSERT(!stream->err());
+
+		// Seeking back clears the end of stream flag
+		TS_ASSERT(stream->seek(0));
+		TS_ASSERT(!stream->eos());
+
+		delete stream;
+#endif
+	}
+
+	void test_direct_data() {
+#ifdef TEST_MAPPED_STREAMS
+		PosixMappedStream *stream = PosixMappedStream::makeFromPath(getPath(), 0, 1024);
+		const byte *data = stream->getDirectData();
+		TS_ASSERT(data);
+
+		bool equal = true;
+		for (uint32 i = 0; i < 1000; ++i)
+			equal = equal && (data[i] == (byte)(i * 3));
+		TS_ASSERT(equal);
+
+		delete stream;
+#endif
+	}
+
+	void test_size_limits() {
+#ifdef TEST_MAPPED_STREAMS
+		// Files outside of the size range are not mapped
+		TS_ASSERT(!PosixMappedStream::makeFromPath(getPath(), 1001, 1024));
+		TS_ASSERT(!PosixMappedStream::makeFromPath(getPath(), 0, 999));
+		TS_ASSERT(!PosixMappedStream::makeFromPath("posix-mapped-stream-missing.dat", 0, 1024));
+#endif
+	}
+};
@@ -0,0 +1,126 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/dirtyrects.h"
+
+class DirtyRectsTestSuite : public CxxTest::TestSuite
+{
+	static int totalArea(const Common::Array<Common::Rect> &rects) {
+		int area = 0;
+		for (uint i = 0; i < rects.size(); ++i)
+			area += rects[i].width() * rects[i].height();
+		return area;
+	}
+
+	static bool overlap(const Common::Array<Common::Rect> &rects) {
+		for (uint i = 0; i < rects.size(); ++i) {
+			for (uint j = i + 1; j < rects.size(); ++j) {
+				if (rects[i].intersects(rects[j]))
+					return true;
+			}
+		}
+		return false;
+	}
+
+	static bool covers(const Common::Array<Common::Rect> &rects, const Common::Rect &r) {
+		for (int y = r.top; y < r.bottom; ++y) {
+			for (int x = r.left; x < r.right; ++x) {
+				bool found = false;
+				for (uint i = 0; i < rects.size() && !found; ++i)
+					found = rects[i].contains(x, y);
+				if (!found)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	public:
+	void test_single_rect() {
+		Common::DirtyRectTracker tracker;
+		tracker.setSize(320, 200);
+		TS_ASSERT(tracker.isEmpty());
+
+		// Rects are only as large as the dirty area, not the tiles
+		tracker.addRect(Common::Rect(5, 7, 10, 12));
+		Common::Array<Common::Rect> rects;
+		TS_ASSERT(tracker.getRects(rects));
+		TS_ASSERT_EQUALS(rects.size(), 1u);
+		TS_ASSERT(rects[0] == Common::Rect(5, 7, 10, 12));
+
+		tracker.clear();
+		TS_ASSERT(tracker.isEmpty());
+		rects.clear();
+		TS_ASSERT(tracker.getRects(rects));
+		TS_ASSERT(rects.empty());
+	}
+
+	void test_overlapping_rects() {
+		Common::DirtyRectTracker tracker;
+		tracker.setSize(320, 200);
+
+		// The same area reported several times is only returned once
+		for (int i = 0; i < 10; ++i)
+			tracker.addRect(Common::Rect(100 + i, 50, 140 + i, 90));
+
+		Common::Array<Common::Rect> rects;
+		TS_ASSERT(tracker.getRects(rects));
+		TS_ASSERT(!overlap(rects));
+		TS_ASSERT(covers(rects, Common::Rect(100, 50, 149, 90)));
+		TS_ASSERT_EQUALS(totalArea(rects), 49 * 40);
+	}
+
+	void test_scattered_rects() {
+		Common::DirtyRectTracker tracker;
+		tracker.setSize(320, 200);
+
+		tracker.addRect(Common::Rect(-10, -10, 20, 20));
+		tracker.addRect(Common::Rect(300, 190, 400, 300));
+		tracker.addRect(Common::Rect(150, 10, 170, 100));
+		tracker.addRect(Common::Rect(10, 90, 200, 95));
+		TS_ASSERT(tracker.getBounds() == Common::Rect(0, 0, 320, 200));
+
+		Common::Array<Common::Rect> rects;
+		TS_ASSERT(tracker.getRects(rects));
+		TS_ASSERT(!overlap(rects));
+		TS_ASSERT(covers(rects, Common::Rect(0, 0, 20, 20)));
+		TS_ASSERT(covers(rects, Common::Rect(300, 190, 320, 200)));
+		TS_ASSERT(covers(rects, Common::Rect(150, 10, 170, 100)));
+		TS_ASSERT(covers(rects, Common::Rect(10, 90, 200, 95)));
+		TS_ASSERT(!covers(rects, Common::Rect(100, 30, 101, 31)));
+	}
+
+	void test_max_rects() {
+		Common::DirtyRectTracker tracker;
+		tracker.setSize(320, 200, 16, 16);
+
+		// A checkerboard of dirty tiles
+		for (int y = 0; y < 200; y += 16) {
+			for (int x = (y / 16 & 1) * 16; x < 320; x += 32)
+				tracker.addRect(Common::Rect(x + 1, y + 1, x + 15, y + 15));
+		}
+
+		// With too few rects allowed, each row is covered by one span
+		Common::Array<Common::Rect> rects;
+		TS_ASSERT(tracker.getRects(rects, 13));
+		TS_ASSERT(rects.size() <= 13u);
+		TS_ASSERT(!overlap(rects));
+		TS_ASSERT(covers(rects, Common::Rect(1, 1, 15, 15)));
+		TS_ASSERT(covers(rects, Common::Rect(289, 193, 303, 199)));
+
+		rects.clear();
+		TS_ASSERT(!tracker.getRects(rects, 5));
+		TS_ASSERT(rects.empty());
+	}
+
+	void test_vertical_merge() {
+		Common::DirtyRectTracker tracker;
+		tracker.setSize(320, 200, 16, 15);
+
+		// A column spanning several tiles ends up as a single rect
+		tracker.addRect(Common::Rect(32, 0, 64, 150));
+		Common::Array<Common::Rect> rects;
+		TS_ASSERT(tracker.getRects(rects));
+		TS_ASSERT_EQUALS(rects.size(), 1u);
+		TS_ASSERT(rects[0] == Common::Rect(32, 0, 64, 150));
+	}
+};
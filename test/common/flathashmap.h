@@ -0,0 +1,135 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+
+namespace {
+
+// Sends all keys to the same group, so that they overflow into the
+// following groups
+struct CollidingHash {
+	uint operator()(int) const { return 0; }
+};
+
+typedef Common::FlatHashMap<int, int, CollidingHash> CollidingMap;
+
+}
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	public:
+	// The cases shared with HashMap are covered by test/common/hashmap.h.
+	// These are about the open addressing, which HashMap does not have.
+
+	void test_tombstone_reuse() {
+		CollidingMap h;
+		for (int i = 0; i < 40; ++i)
+			h[i] = i;
+
+		// Erasing from a full group must not hide the keys behind it
+		for (int i = 0; i < 40; i += 4)
+			h.erase(i);
+		TS_ASSERT_EQUALS(h.size(), 30U);
+		for (int i = 0; i < 40; ++i)
+			TS_ASSERT_EQUALS(h.contains(i), (i % 4) != 0);
+
+		// Re-adding keys fills the deleted slots without duplicating the
+		// keys which are still there
+		for (int i = 0; i < 40; ++i)
+			h[i] = i + 100;
+		TS_ASSERT_EQUALS(h.size(), 40U);
+
+		uint count = 0;
+		int found[40] = { 0 };
+		for (CollidingMap::const_iterator i = h.begin(); i != h.end(); ++i) {
+			TS_ASSERT(i->_key >= 0 && i->_key < 40);
+			TS_ASSERT_EQUALS(i->_value, i->_key + 100);
+			++found[i->_key];
+			++count;
+		}
+		TS_ASSERT_EQUALS(count, 40U);
+		for (int i = 0; i < 40; ++i)
+			TS_ASSERT_EQUALS(found[i], 1);
+
+		for (int i = 0; i < 40; ++i)
+			h.erase(h.find(i));
+		TS_ASSERT(h.empty());
+		TS_ASSERT_EQUALS(h.begin(), h.end());
+	}
+
+	void test_rehash_under_deletes() {
+		// A sliding window of keys keeps leaving deleted slots behind,
+		// which forces the storage to be rebuilt again and again
+		Common::FlatHashMap<int, int> h;
+		CollidingMap colliding;
+		for (int i = 0; i < 5000; ++i) {
+			h[i] = i;
+			if (i < 500)
+				colliding[i] = i;
+			if (i >= 20) {
+				h.erase(i - 20);
+				if (i < 500)
+					colliding.erase(i - 20);
+			}
+		}
+
+		TS_ASSERT_EQUALS(h.size(), 20U);
+		for (int i = 0; i < 5000; ++i)
+			TS_ASSERT_EQUALS(h.contains(i), i >= 4980);
+		for (int i = 4980; i < 5000; ++i)
+			TS_ASSERT_EQUALS(h[i], i);
+
+		TS_ASSERT_EQUALS(colliding.size(), 20U);
+		for (int i = 0; i < 500; ++i)
+			TS_ASSERT_EQUALS(colliding.contains(i), i >= 480);
+
+		// A copy made in this state is just as usable
+		Common::FlatHashMap<int, int> copy(h);
+		copy[42] = 42;
+		TS_ASSERT_EQUALS(copy.size(), 21U);
+		TS_ASSERT_EQUALS(h.size(), 20U);
+		TS_ASSERT(!h.contains(42));
+	}
+
+	void test_against_hashmap() {
+		// Many string keys in colliding groups, with erased slots being
+		// reused, have to behave exactly like with HashMap
+		typedef Common::FlatHashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FlatMap;
+		typedef Common::HashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> Map;
+		FlatMap flat;
+		Map reference;
+
+		for (int i = 0; i < 2000; ++i) {
+			const Common::String key = Common::String::format("Key%d", (i * 37) % 1500);
+			if (i % 3 == 2) {
+				flat.erase(key);
+				reference.erase(key);
+			} else {
+				flat[key] = i;
+				reference[key] = i;
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+		for (Map::const_iterator i = reference.begin(); i != reference.end(); ++i) {
+			FlatMap::const_iterator entry = flat.find(i->_key);
+			TS_ASSERT(entry != flat.end());
+			TS_ASSERT_EQUALS(entry->_value, i->_value);
+		}
+
+		uint count = 0;
+		for (FlatMap::const_iterator i = flat.begin(); i != flat.end(); ++i) {
+			TS_ASSERT(reference.contains(i->_key));
+			++count;
+		}
+		TS_ASSERT_EQUALS(count, reference.size());
+
+		TS_ASSERT(flat.contains("KEY37"));
+		FlatMap copy(flat);
+		flat.clear(true);
+		TS_ASSERT(flat.empty());
+		TS_ASSERT_EQUALS(copy.size(), reference.size());
+		TS_ASSERT_EQUALS(copy["key37"], reference["key37"]);
+	}
+};
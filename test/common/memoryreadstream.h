@@ -104,4 +104,72 @@ class MemoryReadStreamTestSuite : public CxxTest::TestSuite {
 		ms.seek(0, SEEK_SET);
 		TS_ASSERT(!ms.eos());
 	}
+
+	void test_direct_data() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		ms.readByte();
+		TS_ASSERT_EQUALS(ms.getDirectData(), contents);
+	}
+
+	void test_read_arrays() {
+		byte contents[40];
+		for (int i = 0; i < 40; ++i)
+			contents[i] = i + 1;
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		// Long enough to cover both the vectorized and the scalar path
+		uint16 words[11];
+		TS_ASSERT_EQUALS(ms.readUint16ArrayBE(words, 11), 11u);
+		for (int i = 0; i < 11; ++i)
+			TS_ASSERT_EQUALS(words[i], READ_BE_UINT16(contents + i * 2));
+
+		ms.seek(0);
+		TS_ASSERT_EQUALS(ms.readUint16ArrayLE(words, 11), 11u);
+		for (int i = 0; i < 11; ++i)
+			TS_ASSERT_EQUALS(words[i], READ_LE_UINT16(contents + i * 2));
+
+		uint32 dwords[7];
+		ms.seek(1);
+		TS_ASSERT_EQUALS(ms.readUint32ArrayBE(dwords, 7), 7u);
+		for (int i = 0; i < 7; ++i)
+			TS_ASSERT_EQUALS(dwords[i], READ_BE_UINT32(contents + 1 + i * 4));
+
+		ms.seek(1);
+		TS_ASSERT_EQUALS(ms.readUint32ArrayLE(dwords, 7), 7u);
+		for (int i = 0; i < 7; ++i)
+			TS_ASSERT_EQUALS(dwords[i], READ_LE_UINT32(contents + 1 + i * 4));
+		TS_ASSERT(!ms.eos());
+
+		int16 swords[2];
+		contents[38] = 0xFF;
+		contents[39] = 0xFE;
+		ms.seek(38);
+		TS_ASSERT_EQUALS(ms.readSint16ArrayBE(swords, 1), 1u);
+		TS_ASSERT_EQUALS(swords[0], -2);
+
+		// Only completely read elements are counted
+		ms.seek(35);
+		TS_ASSERT_EQUALS(ms.readUint16ArrayLE(words, 4), 2u);
+		TS_ASSERT(ms.eos());
+	}
+
+	void test_inline_read_eos() {
+		byte contents[] = { 1, 2, 3 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		TS_ASSERT_EQUALS(ms.readUint16LE(), 0x0201);
+		TS_ASSERT(!ms.eos());
+		ms.readUint16LE();
+		TS_ASSERT(ms.eos());
+		TS_ASSERT_EQUALS(ms.pos(), 3);
+
+		ms.seek(0);
+		TS_ASSERT_EQUALS(ms.readSint16BE(), 0x0102);
+		TS_ASSERT_EQUALS(ms.readByte(), 3);
+		TS_ASSERT(!ms.eos());
+		ms.readByte();
+		TS_ASSERT(ms.eos());
+	}
 };
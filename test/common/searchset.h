@@ -0,0 +1,99 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+
+#include "test/null_osystem.h"
+
+namespace {
+
+// Archive with a single member, counting how often the member is opened
+class SingleMemberArchive : public Common::Archive {
+public:
+	SingleMemberArchive(const char *member, const char *content, int *opened)
+		: _member(member), _content(content), _opened(opened) {}
+
+	virtual bool hasFile(const Common::String &name) const {
+		return name.equalsIgnoreCase(_member);
+	}
+
+	virtual int listMembers(Common::ArchiveMemberList &list) const {
+		list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_member, this)));
+		return 1;
+	}
+
+	virtual const Common::ArchiveMemberPtr getMember(const Common::String &name) const {
+		if (!hasFile(name))
+			return Common::ArchiveMemberPtr();
+		return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_member, this));
+	}
+
+	virtual Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const {
+		if (!hasFile(name))
+			return 0;
+		++*_opened;
+		return new Common::MemoryReadStream((const byte *)_content, strlen(_content));
+	}
+
+private:
+	const char *_member;
+	const char *_content;
+	int *_opened;
+};
+
+}
+
+class SearchSetTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
+	void test_priority() {
+		int opened = 0;
+		Common::SearchSet set;
+		set.add("low", new SingleMemberArchive("data.bin", "low", &opened), 0);
+
+		Common::SeekableReadStream *stream = set.createReadStreamForMember("DATA.BIN");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->readLine(), "low");
+		delete stream;
+
+		// A new archive with a higher priority takes over the member
+		set.add("high", new SingleMemberArchive("data.bin", "high", &opened), 1);
+		stream = set.createReadStreamForMember("data.bin");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->readLine(), "high");
+		delete stream;
+
+		set.remove("high");
+		TS_ASSERT(set.hasFile("data.bin"));
+		TS_ASSERT(!set.hasFile("other.bin"));
+		stream = set.createReadStreamForMember("data.bin");
+		TS_ASSERT_EQUALS(stream->readLine(), "low");
+		delete stream;
+
+		TS_ASSERT_EQUALS(opened, 3);
+	}
+
+	void test_nested() {
+		int opened = 0;
+		Common::SearchSet *nested = new Common::SearchSet();
+		nested->add("low", new SingleMemberArchive("data.bin", "low", &opened), 0);
+
+		Common::SearchSet set;
+		set.add("nested", nested);
+
+		Common::SeekableReadStream *stream = set.createReadStreamForMember("data.bin");
+		TS_ASSERT_EQUALS(stream->readLine(), "low");
+		delete stream;
+
+		// Changes of a nested set are picked up as well
+		nested->add("high", new SingleMemberArchive("data.bin", "high", &opened), 1);
+		stream = set.createReadStreamForMember("data.bin");
+		TS_ASSERT_EQUALS(stream->readLine(), "high");
+		delete stream;
+	}
+
+};
@@ -44,4 +44,35 @@ class SubReadStreamTestSuite : public CxxTest::TestSuite {
 		// eos should not be set for the second sub stream
 		TS_ASSERT(!ssrs2.eos());
 	}
+
+	void test_direct_data() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		Common::SeekableSubReadStream srs(&ms, 3, 8);
+		TS_ASSERT_EQUALS(srs.getDirectData(), contents + 3);
+		TS_ASSERT_EQUALS(srs.getDirectData()[0], 3);
+	}
+
+	void test_safe_direct_read() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		Common::SafeSeekableSubReadStream ssrs1(&ms, 2, 6);
+		Common::SafeSeekableSubReadStream ssrs2(&ms, 5, 10);
+		ms.seek(1);
+
+		TS_ASSERT_EQUALS(ssrs1.readUint16BE(), 0x0203);
+		TS_ASSERT_EQUALS(ssrs2.readByte(), 5);
+		TS_ASSERT_EQUALS(ssrs1.readUint16BE(), 0x0405);
+		TS_ASSERT_EQUALS(ssrs2.readUint32BE(), 0x06070809u);
+		TS_ASSERT(!ssrs1.eos());
+
+		ssrs1.readByte();
+		TS_ASSERT(ssrs1.eos());
+		TS_ASSERT(!ssrs2.eos());
+
+		// Reading from memory does not move the parent stream
+		TS_ASSERT_EQUALS(ms.pos(), 1);
+	}
 };
@@ -0,0 +1,356 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+
+#include "test/null_osystem.h"
+
+class ZipTestSuite : public CxxTest::TestSuite
+{
+	// big.bin: 600000 deflated bytes, byte i is ((i * 7) + (i >> 14)) & 0xff
+	// stored.txt: "Stored member data", not compressed
+	static Common::Archive *createArchive(bool corruptStored = false) {
+		static const byte zip[] = {
+			0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x21, 0x00, 0x3f, 0xa4,
+			0x94, 0x3e, 0xb1, 0x0a, 0x00, 0x00, 0xc0, 0x27, 0x09, 0x00, 0x07, 0x00, 0x00, 0x00, 0x62, 0x69,
+			0x67, 0x2e, 0x62, 0x69, 0x6e, 0xed, 0xd0, 0xe7, 0xc2, 0x08, 0x04, 0x14, 0x00, 0xd0, 0xcf, 0x4c,
+			0x36, 0x2d, 0x19, 0x99, 0xa9, 0x8c, 0x0a, 0xd9, 0x24, 0x33, 0x24, 0x2a, 0x7b, 0x35, 0x64, 0x54,
+			0xf6, 0xde, 0x95, 0xec, 0x59, 0x94, 0x91, 0x86, 0xd1, 0x24, 0x9b, 0x4a, 0x21, 0x19, 0x21, 0x5b,
+			0x1a, 0x1a, 0xf6, 0xde, 0x7b, 0xcf, 0xb7, 0xe8, 0xfa, 0x71, 0x1e, 0xe1, 0x9c, 0x84, 0x3b, 0xd2,
+			0xde, 0x93, 0x35, 0x77, 0xbe, 0x42, 0x25, 0xca, 0x55, 0x79, 0xb6, 0x4e, 0xe3, 0x66, 0xaf, 0x77,
+			0xe8, 0xfe, 0xe6, 0xc0, 0x11, 0xef, 0x4f, 0x9c, 0xf2, 0xf5, 0xec, 0xef, 0x96, 0xac, 0x5c, 0xf7,
+			0xdb, 0xdf, 0xbb, 0x0e, 0x9e, 0x38, 0x7f, 0x2d, 0x49, 0xca, 0x0c, 0x99, 0xb2, 0xe7, 0x2d, 0xf8,
+			0x44, 0xe9, 0x0a, 0xd5, 0x9e, 0xab, 0xff, 0x62, 0x8b, 0x36, 0x9d, 0x7b, 0xf5, 0x1b, 0xf2, 0xee,
+			0xb8, 0x4f, 0x3e, 0xff, 0x66, 0xde, 0x0f, 0x3f, 0xaf, 0xde, 0xf8, 0xc7, 0x7f, 0x7b, 0x8f, 0x9c,
+			0xbe, 0x74, 0x33, 0x79, 0x9a, 0xbb, 0xb3, 0xe4, 0x7a, 0xe4, 0xf1, 0xe2, 0x4f, 0x56, 0xae, 0x51,
+			0xbb, 0xd1, 0x2b, 0xaf, 0xb5, 0xef, 0xd6, 0x77, 0xc0, 0xf0, 0x31, 0x1f, 0x4e, 0xfe, 0x6a, 0xd6,
+			0xb7, 0x8b, 0x57, 0xac, 0xdd, 0xb2, 0x6d, 0xe7, 0x81, 0xe3, 0xe7, 0xae, 0x26, 0xbe, 0x33, 0xfd,
+			0x7d, 0x0f, 0x3c, 0x58, 0xa0, 0x48, 0xa9, 0xf2, 0x55, 0x6b, 0xd5, 0x6b, 0xda, 0xbc, 0x75, 0xa7,
+			0x9e, 0x6f, 0x0f, 0x1e, 0x35, 0xf6, 0xe3, 0xcf, 0xa6, 0xcf, 0x5d, 0xb8, 0x74, 0xd5, 0x86, 0xdf,
+			0xff, 0xdd, 0x73, 0xf8, 0xd4, 0xc5, 0x1b, 0xc9, 0x52, 0xdf, 0x95, 0x39, 0xe7, 0xc3, 0x8f, 0x15,
+			0x2b, 0x5b, 0xe9, 0x99, 0x17, 0x1a, 0xbe, 0xdc, 0xaa, 0x5d, 0xd7, 0x3e, 0xfd, 0x87, 0x8d, 0x9e,
+			0x30, 0xe9, 0xcb, 0x99, 0x0b, 0x16, 0x2d, 0xff, 0x75, 0xf3, 0x5f, 0x3b, 0xf6, 0x1f, 0x3b, 0x7b,
+			0x25, 0x51, 0x8a, 0x74, 0xf7, 0x66, 0xcb, 0x93, 0xbf, 0x70, 0xc9, 0xa7, 0x9e, 0xae, 0x59, 0xb7,
+			0xc9, 0xab, 0x6f, 0x74, 0xec, 0xf1, 0xd6, 0xa0, 0x91, 0x1f, 0x7c, 0x34, 0x75, 0xda, 0x9c, 0xef,
+			0x7f, 0xfa, 0x65, 0xfd, 0xd6, 0x7f, 0x76, 0x1f, 0x3a, 0x79, 0xe1, 0x7a, 0xd2, 0x54, 0x19, 0xef,
+			0xcf, 0xf1, 0xd0, 0xa3, 0x45, 0xcb, 0x54, 0xac, 0xfe, 0x7c, 0x83, 0x97, 0x5a, 0xb6, 0xed, 0xd2,
+			0xfb, 0x9d, 0xa1, 0xef, 0x8d, 0xff, 0xf4, 0x8b, 0x19, 0xf3, 0x7f, 0x5c, 0xb6, 0x66, 0xd3, 0x9f,
+			0xdb, 0xf7, 0x1d, 0x3d, 0x73, 0x39, 0x81, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f,
+			0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f,
+			0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f,
+			0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f,
+			0x9f, 0x9f, 0x9f, 0x9f, 0xff, 0x36, 0xf0, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b,
+			0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7,
+			0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f,
+			0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b,
+			0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7,
+			0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f,
+			0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0x8f, 0xf7, 0x8b, 0xe4, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7, 0xe7,
+			0xe7, 0xff, 0xff, 0xfd, 0xb7, 0x00, 0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x21, 0x00, 0xd2, 0xc5, 0x05, 0x88, 0x12, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00,
+			0x0a, 0x00, 0x00, 0x00, 0x73, 0x74, 0x6f, 0x72, 0x65, 0x64, 0x2e, 0x74, 0x78, 0x74, 0x53, 0x74,
+			0x6f, 0x72, 0x65, 0x64, 0x20, 0x6d, 0x65, 0x6d, 0x62, 0x65, 0x72, 0x20, 0x64, 0x61, 0x74, 0x61,
+			0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x21, 0x00,
+			0x3f, 0xa4, 0x94, 0x3e, 0xb1, 0x0a, 0x00, 0x00, 0xc0, 0x27, 0x09, 0x00, 0x07, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00, 0x62, 0x69,
+			0x67, 0x2e, 0x62, 0x69, 0x6e, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x21, 0x00, 0xd2, 0xc5, 0x05, 0x88, 0x12, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00,
+			0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0xd6,
+			0x0a, 0x00, 0x00, 0x73, 0x74, 0x6f, 0x72, 0x65, 0x64, 0x2e, 0x74, 0x78, 0x74, 0x50, 0x4b, 0x05,
+			0x06, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x02, 0x00, 0x6d, 0x00, 0x00, 0x00, 0x10, 0x0b, 0x00,
+			0x00, 0x00, 0x00,
+		};
+
+		if (!corruptStored)
+			return Common::makeZipArchive(new Common::MemoryReadStream(zip, sizeof(zip)));
+
+		// Change the data of stored.txt without updating its CRC
+		byte *data = (byte *)malloc(sizeof(zip));
+		memcpy(data, zip, sizeof(zip));
+		for (uint32 i = 0; i + 6 <= sizeof(zip); ++i) {
+			if (!memcmp(data + i, "Stored", 6))
+				data[i] = 's';
+		}
+		return Common::makeZipArchive(new Common::MemoryReadStream(data, sizeof(zip), DisposeAfterUse::YES));
+	}
+
+	static byte expected(uint32 i) {
+		return (byte)((i * 7) + (i >> 14));
+	}
+
+	static bool checkData(Common::SeekableReadStream &stream, uint32 len) {
+		const uint32 start = stream.pos();
+		for (uint32 i = 0; i < len; ++i) {
+			if (stream.readByte() != expected(start + i))
+				return false;
+		}
+		return !stream.err();
+	}
+
+	public:
+	void setUp() {
+		// The archive serializes accesses to its stream with a mutex
+		Common::install_null_g_system();
+	}
+
+	void test_deflated_sequential() {
+		Common::Archive *archive = createArchive();
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("BIG.BIN");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->size(), 600000);
+
+		byte buffer[1000];
+		for (uint32 pos = 0; pos < 600000; pos += sizeof(buffer)) {
+			TS_ASSERT_EQUALS(stream->read(buffer, sizeof(buffer)), sizeof(buffer));
+			for (uint32 i = 0; i < sizeof(buffer); ++i)
+				TS_ASSERT_EQUALS(buffer[i], expected(pos + i));
+		}
+
+		TS_ASSERT(!stream->eos());
+		TS_ASSERT_EQUALS(stream->read(buffer, 1), 0u);
+		TS_ASSERT(stream->eos());
+		TS_ASSERT(!stream->err());
+
+		delete stream;
+		delete archive;
+	}
+
+	void test_deflated_seek() {
+		Common::Archive *archive = createArchive();
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("big.bin");
+
+		// The member stream keeps working without the archive
+		delete archive;
+
+		TS_ASSERT(stream->seek(-100, SEEK_END));
+		TS_ASSERT(checkData(*stream, 100));
+
+		TS_ASSERT(stream->seek(300000));
+		TS_ASSERT(checkData(*stream, 100));
+
+		TS_ASSERT(stream->seek(10));
+		TS_ASSERT(checkData(*stream, 100));
+
+		TS_ASSERT(stream->seek(270000));
+		TS_ASSERT(checkData(*stream, 100));
+
+		TS_ASSERT(stream->seek(-1000, SEEK_CUR));
+		TS_ASSERT_EQUALS(stream->pos(), 269100);
+		TS_ASSERT(checkData(*stream, 100));
+
+		delete stream;
+	}
+
+	void test_stored() {
+		Common::Archive *archive = createArchive();
+		Common::SeekableReadStream *stored = archive->createReadStreamForMember("stored.txt");
+		Common::SeekableReadStream *big = archive->createReadStreamForMember("big.bin");
+		TS_ASSERT(stored);
+		TS_ASSERT_EQUALS(stored->size(), 18);
+
+		// Interleaved reads from two members of the same archive
+		TS_ASSERT(big->seek(500000));
+		TS_ASSERT_EQUALS(stored->readLine(), "Stored member data");
+		TS_ASSERT(checkData(*big, 100));
+		TS_ASSERT(stored->seek(7));
+		TS_ASSERT_EQUALS(stored->readLine(), "member data");
+
+		delete stored;
+		delete big;
+		delete archive;
+	}
+
+	void test_streamed() {
+		// Members of archives which were not opened from a file are streamed
+		// from the archive stream, unless they are small
+		Common::Archive *archive = createArchive();
+		Common::SeekableReadStream *big = archive->createReadStreamForMember("big.bin");
+		Common::SeekableReadStream *big2 = archive->createReadStreamForMember("big.bin");
+		Common::SeekableReadStream *stored = archive->createReadStreamForMember("stored.txt");
+		TS_ASSERT(!big->getDirectData());
+		TS_ASSERT(stored->getDirectData());
+
+		// Both streams of the large member have their own position on the
+		// shared archive stream, also after the archive was deleted
+		delete archive;
+
+		TS_ASSERT(big->seek(400000));
+		TS_ASSERT(checkData(*big2, 100));
+		TS_ASSERT(checkData(*big, 100));
+		TS_ASSERT(checkData(*big2, 100));
+		TS_ASSERT_EQUALS(big->pos(), 400100);
+		TS_ASSERT_EQUALS(big2->pos(), 200);
+
+		delete big;
+		delete stored;
+		delete big2;
+	}
+
+	void test_stored_crc() {
+		Common::Archive *archive = createArchive(true);
+		TS_ASSERT(archive->hasFile("stored.txt"));
+		TS_ASSERT(!archive->createReadStreamForMember("stored.txt"));
+		delete archive;
+	}
+
+	void test_lookup() {
+		Common::Archive *archive = createArchive();
+		TS_ASSERT(archive->hasFile("Stored.TXT"));
+		TS_ASSERT(!archive->hasFile("missing.txt"));
+		TS_ASSERT(!archive->createReadStreamForMember("missing.txt"));
+
+		Common::ArchiveMemberList list;
+		TS_ASSERT_EQUALS(archive->listMembers(list), 2);
+
+		// Members can be opened more than once
+		for (int i = 0; i < 2; ++i) {
+			Common::SeekableReadStream *stored = archive->createReadStreamForMember("stored.txt");
+			TS_ASSERT(stored);
+			TS_ASSERT_EQUALS(stored->readLine(), "Stored member data");
+			delete stored;
+		}
+
+		delete archive;
+	}
+};
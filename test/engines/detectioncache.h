@@ -0,0 +1,115 @@
+#include <cxxtest/TestSuite.h>
+
+#include "engines/detectioncache.h"
+
+#include "common/fs.h"
+#include "common/stream.h"
+
+#include "test/null_osystem.h"
+
+class DetectionCacheTestSuite : public CxxTest::TestSuite
+{
+	static void writeFile(const Common::FSNode &node, uint32 size) {
+		Common::WriteStream *stream = node.createWriteStream();
+		TS_ASSERT(stream);
+		for (uint32 i = 0; i < size; ++i)
+			stream->writeByte(i);
+		stream->finalize();
+		delete stream;
+	}
+
+	public:
+	void test_hit() {
+		// Without a directory, the cache is only kept in memory
+		DetectionCache cache("");
+		Common::String md5;
+
+		TS_ASSERT(!cache.lookup("/games/foo/data.001", 1234, 5678, 5000, md5));
+
+		cache.store("/games/foo/data.001", 1234, 5678, 5000, "0123456789abcdef0123456789abcdef");
+		TS_ASSERT(cache.lookup("/games/foo/data.001", 1234, 5678, 5000, md5));
+		TS_ASSERT_EQUALS(md5, "0123456789abcdef0123456789abcdef");
+
+		// Entries without modification time work in memory, too
+		cache.store("/games/foo/data:rsrc", 42, 0, 5000, "fedcba9876543210fedcba9876543210");
+		TS_ASSERT(cache.lookup("/games/foo/data:rsrc", 42, 0, 5000, md5));
+		TS_ASSERT_EQUALS(md5, "fedcba9876543210fedcba9876543210");
+	}
+
+	void test_hashed_bytes() {
+		DetectionCache cache("");
+		Common::String md5;
+
+		cache.store("/games/foo/data.001", 1234, 5678, 5000, "0123456789abcdef0123456789abcdef");
+		cache.store("/games/foo/data.001", 1234, 5678, 0, "00000000000000000000000000000000");
+
+		TS_ASSERT(cache.lookup("/games/foo/data.001", 1234, 5678, 5000, md5));
+		TS_ASSERT_EQUALS(md5, "0123456789abcdef0123456789abcdef");
+		TS_ASSERT(cache.lookup("/games/foo/data.001", 1234, 5678, 0, md5));
+		TS_ASSERT_EQUALS(md5, "00000000000000000000000000000000");
+		TS_ASSERT(!cache.lookup("/games/foo/data.001", 1234, 5678, 1024, md5));
+	}
+
+	void test_invalidation() {
+		DetectionCache cache("");
+		Common::String md5;
+
+		cache.store("/games/foo/data.001", 1234, 5678, 5000, "0123456789abcdef0123456789abcdef");
+
+		// A different size or modification time means the file has changed
+		TS_ASSERT(!cache.lookup("/games/foo/data.001", 1235, 5678, 5000, md5));
+		TS_ASSERT(!cache.lookup("/games/foo/data.001", 1234, 5679, 5000, md5));
+
+		// The new MD5 sum replaces the old one
+		cache.store("/games/foo/data.001", 1235, 5679, 5000, "ffffffffffffffffffffffffffffffff");
+		TS_ASSERT(cache.lookup("/games/foo/data.001", 1235, 5679, 5000, md5));
+		TS_ASSERT_EQUALS(md5, "ffffffffffffffffffffffffffffffff");
+		TS_ASSERT(!cache.lookup("/games/foo/data.001", 1234, 5678, 5000, md5));
+	}
+
+#ifdef POSIX
+	void test_disk() {
+		// The null OSystem has the native file system on POSIX hosts. The
+		// files are written to the directory the tests are run in.
+		Common::install_null_g_system();
+
+		const Common::FSNode node("detectioncache-test.dat");
+		writeFile(node, 100);
+
+		const int32 size = node.getFileSize();
+		const uint32 mtime = node.getModificationTime();
+		TS_ASSERT_EQUALS(size, 100);
+		TS_ASSERT(mtime != 0);
+
+		{
+			DetectionCache cache(".");
+			cache.store(node.getPath(), size, mtime, 5000, "0123456789abcdef0123456789abcdef");
+			// Entries of files which do not exist are not written
+			cache.store("detectioncache-missing.dat", 1, mtime, 5000, "ffffffffffffffffffffffffffffffff");
+			// Neither are entries without modification time
+			cache.store("detectioncache-test.dat:rsrc", 1, 0, 5000, "ffffffffffffffffffffffffffffffff");
+			cache.flush();
+		}
+
+		Common::String md5;
+		{
+			DetectionCache cache(".");
+			TS_ASSERT(cache.lookup(node.getPath(), size, mtime, 5000, md5));
+			TS_ASSERT_EQUALS(md5, "0123456789abcdef0123456789abcdef");
+			TS_ASSERT(!cache.lookup("detectioncache-missing.dat", 1, mtime, 5000, md5));
+			TS_ASSERT(!cache.lookup("detectioncache-test.dat:rsrc", 1, 0, 5000, md5));
+
+			// A touched file has to be hashed again
+			TS_ASSERT(!cache.lookup(node.getPath(), size, mtime + 1, 5000, md5));
+		}
+
+		// So has a file which changed its size
+		writeFile(node, 200);
+		TS_ASSERT_EQUALS(node.getFileSize(), 200);
+		{
+			DetectionCache cache(".");
+			TS_ASSERT(!cache.lookup(node.getPath(), node.getFileSize(), node.getModificationTime(), 5000, md5));
+		}
+	}
+#endif
+};
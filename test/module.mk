@@ -5,8 +5,11 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/backends/*.h $(srcdir)/test/engines/*.h
+TEST_LIBS    := engines/libengines.a audio/libaudio.a backends/libbackends.a common/libcommon.a
+
+# Objects only needed by the tests, not by ScummVM itself
+TEST_OBJS    := test/null_osystem.o audio/softsynth/opl/harness.o
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
@@ -28,7 +31,7 @@ endif
 
 test: test/runner
 	./test/runner
-test/runner: test/runner.cpp $(TEST_LIBS)
+test/runner: test/runner.cpp $(TEST_OBJS) $(TEST_LIBS)
 	$(QUIET_LINK)$(CXX) $(TEST_CXXFLAGS) $(CPPFLAGS) $(TEST_CFLAGS) -o $@ $+ $(TEST_LDFLAGS)
 test/runner.cpp: $(TESTS)
 	@mkdir -p test
@@ -37,6 +40,6 @@ test/runner.cpp: $(TESTS)
 
 clean: clean-test
 clean-test:
-	-$(RM) test/runner.cpp test/runner
+	-$(RM) test/runner.cpp test/runner $(TEST_OBJS) detection.cache detectioncache-test.dat posix-mapped-stream-test.dat
 
 .PHONY: test clean-test
@@ -0,0 +1,123 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/null_osystem.h"
+
+#include "common/system.h"
+#include "audio/mixer_intern.h"
+#include "graphics/pixelformat.h"
+
+#if defined(POSIX)
+#include "backends/fs/posix/posix-fs-factory.h"
+#endif
+
+namespace {
+
+class NullOSystem : public OSystem {
+public:
+	NullOSystem() : _mixer(0) {
+#if defined(POSIX)
+		_fsFactory = new POSIXFilesystemFactory();
+#endif
+	}
+
+	virtual ~NullOSystem() {
+		delete _mixer;
+	}
+
+	void initMixer() {
+		_mixer = new Audio::MixerImpl(this, 44100);
+	}
+
+	virtual bool hasFeature(Feature f) { return false; }
+
+	virtual const GraphicsMode *getSupportedGraphicsModes() const { return 0; }
+	virtual int getDefaultGraphicsMode() const { return 0; }
+	virtual bool setGraphicsMode(int mode) { return false; }
+	virtual int getGraphicsMode() const { return 0; }
+	virtual Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format) {}
+	virtual int16 getHeight() { return 0; }
+	virtual int16 getWidth() { return 0; }
+	virtual PaletteManager *getPaletteManager() { return 0; }
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual Graphics::Surface *lockScreen() { return 0; }
+	virtual void unlockScreen() {}
+	virtual void fillScreen(uint32 col) {}
+	virtual void updateScreen() {}
+	virtual void setShakePos(int shakeOffset) {}
+
+	virtual void showOverlay() {}
+	virtual void hideOverlay() {}
+	virtual Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(); }
+	virtual void clearOverlay() {}
+	virtual void grabOverlay(void *buf, int pitch) {}
+	virtual void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual int16 getOverlayHeight() { return 0; }
+	virtual int16 getOverlayWidth() { return 0; }
+
+	virtual bool showMouse(bool visible) { return false; }
+	virtual void warpMouse(int x, int y) {}
+	virtual void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale, const Graphics::PixelFormat *format) {}
+
+	virtual uint32 getMillis(bool skipRecord = false) { return 0; }
+	virtual void delayMillis(uint msecs) {}
+	virtual void getTimeAndDate(TimeDate &t) const {}
+
+	virtual MutexRef createMutex() { return 0; }
+	virtual void lockMutex(MutexRef mutex) {}
+	virtual void unlockMutex(MutexRef mutex) {}
+	virtual void deleteMutex(MutexRef mutex) {}
+
+	virtual Audio::Mixer *getMixer() { return _mixer; }
+
+	virtual void quit() {}
+	virtual void displayMessageOnOSD(const char *msg) {}
+	virtual void displayActivityIconOnOSD(const Graphics::Surface *icon) {}
+	virtual void logMessage(LogMessageType::Type type, const char *message) {}
+
+private:
+	Audio::MixerImpl *_mixer;
+};
+
+} // End of anonymous namespace
+
+namespace Common {
+
+void install_null_g_system() {
+	if (g_system)
+		return;
+
+	// The system is never destroyed, tests may keep objects holding
+	// mutexes in static storage.
+	NullOSystem *system = new NullOSystem();
+	g_system = system;
+
+	// The mixer creates a mutex, so it can only be set up once g_system
+	// is valid.
+	system->initMixer();
+}
+
+} // End of namespace Common